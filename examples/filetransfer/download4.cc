@@ -0,0 +1,80 @@
+#include <muduo/base/Logging.h>
+#include <muduo/net/EventLoop.h>
+#include <muduo/net/TcpServer.h>
+
+#include <boost/shared_ptr.hpp>
+
+#include <stdio.h>
+#include <sys/stat.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+// Same as download3.cc, but hands the whole file to the kernel with
+// TcpConnection::sendFile(), no user space copy.
+
+void onHighWaterMark(const TcpConnectionPtr& conn, size_t len)
+{
+  LOG_INFO << "HighWaterMark " << len;
+}
+
+const char* g_file = NULL;
+typedef boost::shared_ptr<FILE> FilePtr;
+
+void onSendFileComplete(const TcpConnectionPtr& conn, int fd)
+{
+  LOG_INFO << "FileServer - done";
+  conn->shutdown();
+}
+
+void onConnection(const TcpConnectionPtr& conn)
+{
+  LOG_INFO << "FileServer - " << conn->peerAddress().toIpPort() << " -> "
+           << conn->localAddress().toIpPort() << " is "
+           << (conn->connected() ? "UP" : "DOWN");
+  if (conn->connected())
+  {
+    LOG_INFO << "FileServer - Sending file " << g_file
+             << " to " << conn->peerAddress().toIpPort();
+    conn->setHighWaterMarkCallback(onHighWaterMark, 64*1024*1024);
+
+    FILE* fp = ::fopen(g_file, "rb");
+    struct stat st;
+    if (fp && ::fstat(fileno(fp), &st) == 0)
+    {
+      FilePtr ctx(fp, ::fclose);    // closed along with the connection
+      conn->setContext(ctx);
+      conn->sendFile(fileno(fp), 0, st.st_size, onSendFileComplete);
+    }
+    else
+    {
+      if (fp)
+      {
+        ::fclose(fp);
+      }
+      conn->shutdown();
+      LOG_INFO << "FileServer - no such file";
+    }
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  LOG_INFO << "pid = " << getpid();
+  if (argc > 1)
+  {
+    g_file = argv[1];
+
+    EventLoop loop;
+    InetAddress listenAddr(2021);
+    TcpServer server(&loop, listenAddr, "FileServer");
+    server.setConnectionCallback(onConnection);
+    server.start();
+    loop.loop();
+  }
+  else
+  {
+    fprintf(stderr, "Usage: %s file_for_downloading\n", argv[0]);
+  }
+}
+
@@ -3,7 +3,7 @@
 #include <muduo/base/Atomic.h>
 #include <muduo/base/Logging.h>
 #include <muduo/base/Thread.h>
-#include <muduo/base/ThreadPool.h>
+#include <muduo/base/WorkStealingThreadPool.h>
 #include <muduo/net/EventLoop.h>
 #include <muduo/net/InetAddress.h>
 #include <muduo/net/TcpServer.h>
@@ -11,6 +11,7 @@
 #include <boost/bind.hpp>
 
 #include <utility>
+#include <vector>
 
 #include <mcheck.h>
 #include <stdio.h>
@@ -54,6 +55,7 @@ class SudokuServer
   {
     LOG_DEBUG << conn->name();
     size_t len = buf->readableBytes();
+    std::vector<WorkStealingThreadPool::Task> tasks;  // 一次消息中的所有请求批量提交
     while (len >= kCells + 2)
     {
       const char* crlf = buf->findCRLF();
@@ -62,7 +64,7 @@ class SudokuServer
         string request(buf->peek(), crlf);
         buf->retrieveUntil(crlf + 2);
         len = buf->readableBytes();
-        if (!processRequest(conn, request))
+        if (!processRequest(conn, request, &tasks))
         {
           conn->send("Bad Request!\r\n");
           conn->shutdown();
@@ -80,9 +82,11 @@ class SudokuServer
         break;
       }
     }
+    threadPool_.run(tasks);
   }
 
-  bool processRequest(const TcpConnectionPtr& conn, const string& request)
+  bool processRequest(const TcpConnectionPtr& conn, const string& request,
+                      std::vector<WorkStealingThreadPool::Task>* tasks)
   {
     string id;
     string puzzle;
@@ -101,7 +105,7 @@ class SudokuServer
 
     if (puzzle.size() == implicit_cast<size_t>(kCells))
     {
-      threadPool_.run(boost::bind(&solve, conn, puzzle, id));   // 计算线程池处理
+      tasks->push_back(boost::bind(&solve, conn, puzzle, id));  // 计算线程池处理
     }
     else
     {
@@ -128,7 +132,7 @@ class SudokuServer
 
   EventLoop* loop_;
   TcpServer server_;
-  ThreadPool threadPool_;   // 计算线程池
+  WorkStealingThreadPool threadPool_;   // 计算线程池
   int numThreads_;
   Timestamp startTime_;
 };
@@ -2,10 +2,86 @@
 #include <muduo/base/LogFile.h>
 #include <muduo/base/Timestamp.h>
 
+#include <iterator>
+
 #include <stdio.h>
+#include <sys/uio.h>
 
 using namespace muduo;
 
+namespace
+{
+// 环形缓冲区中每行日志前的记录头, 记录按16字节对齐, 因此环尾剩余空间至少能放下一个记录头
+struct RecordHeader
+{
+    int64_t time;       // 微秒时间戳, 用于合并各线程的日志
+    int32_t len;        // 日志长度, -1表示环尾的填充, 记录从环首继续
+    int32_t unused;
+};
+
+const size_t kRecordAlign = sizeof(RecordHeader);
+
+size_t recordSize(int len)
+{
+    return (sizeof(RecordHeader) + len + kRecordAlign - 1) & ~(kRecordAlign - 1);
+}
+}
+
+// 单生产者(前端线程)单消费者(后端线程)的环形缓冲区
+struct AsyncLogging::Stage : boost::noncopyable
+{
+    explicit Stage(size_t bytes)
+        : size(bytes),
+        mask(bytes - 1),
+        data(new char[bytes]),
+        tail(0),
+        head(0),
+        abandoned(false)
+    {
+    }
+
+    ~Stage() { delete[] data; }
+
+    RecordHeader* header(size_t pos) const
+    {
+        return reinterpret_cast<RecordHeader*>(data + (pos & mask));
+    }
+
+    // 前端调用, 空间不足时返回false, 成功时usedBytes传出已用空间
+    bool tryAppend(const char* logline, int len, int64_t time, size_t* usedBytes)
+    {
+        size_t need = recordSize(len);
+        size_t contiguous = size - (tail & mask);
+        size_t total = contiguous < need ? contiguous + need : need;
+        size_t used = tail - __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+        if (used + total > size)
+        {
+            return false;
+        }
+        size_t pos = tail;
+        if (contiguous < need)
+        {
+            header(pos)->len = -1;
+            pos += contiguous;
+        }
+        RecordHeader* h = header(pos);
+        h->time = time;
+        h->len = len;
+        memcpy(h + 1, logline, len);
+        __atomic_store_n(&tail, pos + need, __ATOMIC_RELEASE);
+        *usedBytes = used + total;
+        return true;
+    }
+
+    const size_t size;
+    const size_t mask;
+    char* const data;
+    size_t tail;            // 前端写入位置, 只由前端写
+    char pad_[64 - sizeof(size_t)];
+    size_t head;            // 后端读取位置, 只由后端写
+    bool abandoned;         // 所属线程已退出, 取完后由后端释放
+};
+
 AsyncLogging::AsyncLogging(const string& basename,
     size_t rollSize,
     int flushInterval)
@@ -19,14 +95,181 @@ AsyncLogging::AsyncLogging(const string& basename,
     cond_(mutex_),
     currentBuffer_(new Buffer),
     nextBuffer_(new Buffer),
-    buffers_()
+    buffers_(),
+    stageSize_(0),
+    wakeupPending_(0),
+    writeMode_(LogFile::kStdio),
+    syncInterval_(0)
 {
     currentBuffer_->bzero();
     nextBuffer_->bzero();
     buffers_.reserve(16);
+    pthread_key_create(&stageKey_, &AsyncLogging::onThreadExit);
+}
+
+AsyncLogging::~AsyncLogging()
+{
+    if (running_)
+    {
+        stop();
+    }
+    pthread_key_delete(stageKey_);
+    for (size_t i = 0; i < stages_.size(); ++i)
+    {
+        delete stages_[i];
+    }
+}
+
+void AsyncLogging::setPerThreadBuffer(size_t bytes)
+{
+    assert(!running_);
+    stageSize_ = 0;
+    if (bytes > 0)
+    {
+        stageSize_ = kRecordAlign;
+        while (stageSize_ < bytes)
+        {
+            stageSize_ <<= 1;
+        }
+    }
 }
 
 void AsyncLogging::append(const char* logline, int len)
+{
+    if (stageSize_ > 0)
+    {
+        Stage* stage = static_cast<Stage*>(pthread_getspecific(stageKey_));
+        if (stage == NULL)
+        {
+            stage = newStage();
+        }
+        size_t used = 0;
+        if (stage->tryAppend(logline, len, Timestamp::now().microSecondsSinceEpoch(), &used))
+        {
+            // 超过半满时唤醒后端, 每轮只有第一个线程需要加锁
+            if (used > stage->size / 2
+                && __atomic_load_n(&wakeupPending_, __ATOMIC_RELAXED) == 0
+                && __atomic_exchange_n(&wakeupPending_, 1, __ATOMIC_ACQ_REL) == 0)
+            {
+                muduo::MutexLockGuard lock(mutex_);
+                cond_.notify();
+            }
+            return;
+        }
+    }
+    appendShared(logline, len);
+}
+
+AsyncLogging::Stage* AsyncLogging::newStage()
+{
+    Stage* stage = new Stage(stageSize_);
+    {
+        muduo::MutexLockGuard lock(mutex_);
+        stages_.push_back(stage);
+    }
+    pthread_setspecific(stageKey_, stage);
+    return stage;
+}
+
+void AsyncLogging::onThreadExit(void* stage)
+{
+    __atomic_store_n(&static_cast<Stage*>(stage)->abandoned, true, __ATOMIC_RELEASE);
+}
+
+namespace
+{
+struct StageCursor
+{
+    size_t pos;
+    size_t end;
+};
+
+const size_t kMaxSpareBuffers = 2;      // 留给harvestStages复用的空缓冲区个数
+}
+
+// 按时间戳合并各Stage中已提交的日志, 写入后端的大缓冲区
+void AsyncLogging::harvestStages(BufferVector* buffers, BufferVector* spares)
+{
+    std::vector<Stage*> stages;
+    {
+        muduo::MutexLockGuard lock(mutex_);
+        stages = stages_;
+    }
+    std::vector<StageCursor> cursors(stages.size());
+    for (size_t i = 0; i < stages.size(); ++i)
+    {
+        cursors[i].pos = stages[i]->head;
+        cursors[i].end = __atomic_load_n(&stages[i]->tail, __ATOMIC_ACQUIRE);
+    }
+
+    Buffer* output = NULL;
+    for (;;)
+    {
+        size_t best = stages.size();
+        int64_t bestTime = 0;
+        for (size_t i = 0; i < stages.size(); ++i)
+        {
+            StageCursor& c = cursors[i];
+            if (c.pos < c.end && stages[i]->header(c.pos)->len < 0)    // 跳过环尾填充
+            {
+                c.pos += stages[i]->size - (c.pos & stages[i]->mask);
+            }
+            if (c.pos < c.end && (best == stages.size() || stages[i]->header(c.pos)->time < bestTime))
+            {
+                best = i;
+                bestTime = stages[i]->header(c.pos)->time;
+            }
+        }
+        if (best == stages.size())
+        {
+            break;
+        }
+        const RecordHeader* h = stages[best]->header(cursors[best].pos);
+        if (output == NULL || output->avail() <= h->len)
+        {
+            if (spares->empty())
+            {
+                buffers->push_back(BufferPtr(new Buffer));
+            }
+            else
+            {
+                buffers->push_back(std::move(spares->back()));
+                spares->pop_back();
+            }
+            output = buffers->back().get();
+        }
+        output->append(reinterpret_cast<const char*>(h + 1), h->len);
+        cursors[best].pos += recordSize(h->len);
+    }
+
+    bool released = false;
+    for (size_t i = 0; i < stages.size(); ++i)
+    {
+        __atomic_store_n(&stages[i]->head, cursors[i].end, __ATOMIC_RELEASE);
+        released = released || __atomic_load_n(&stages[i]->abandoned, __ATOMIC_ACQUIRE);
+    }
+    if (released)       // 释放已退出线程的Stage, 退出后不会再写入, 已全部取完
+    {
+        muduo::MutexLockGuard lock(mutex_);
+        for (size_t i = 0; i < stages_.size(); )
+        {
+            Stage* stage = stages_[i];
+            if (__atomic_load_n(&stage->abandoned, __ATOMIC_ACQUIRE)
+                && stage->head == __atomic_load_n(&stage->tail, __ATOMIC_ACQUIRE))
+            {
+                delete stage;
+                stages_[i] = stages_.back();
+                stages_.pop_back();
+            }
+            else
+            {
+                ++i;
+            }
+        }
+    }
+}
+
+void AsyncLogging::appendShared(const char* logline, int len)
 {
     muduo::MutexLockGuard lock(mutex_);
     if (currentBuffer_->avail() > len)
@@ -35,11 +278,11 @@ void AsyncLogging::append(const char* logline, int len)
     }
     else
     {
-        buffers_.push_back(currentBuffer_.release());
+        buffers_.push_back(std::move(currentBuffer_));
 
         if (nextBuffer_)
         {
-            currentBuffer_ = boost::ptr_container::move(nextBuffer_);
+            currentBuffer_ = std::move(nextBuffer_);
         }
         else
         {
@@ -50,17 +293,44 @@ void AsyncLogging::append(const char* logline, int len)
     }
 }
 
+// 一轮的所有缓冲区一次交给LogFile, 非kStdio模式下只有一次writev
+void AsyncLogging::writeBuffers(LogFile* output, const BufferVector& buffers, std::vector<struct iovec>* iov)
+{
+    iov->clear();
+    for (size_t i = 0; i < buffers.size(); ++i)
+    {
+        if (buffers[i]->length() > 0)
+        {
+            struct iovec vec = { const_cast<char*>(buffers[i]->data()),
+                                 static_cast<size_t>(buffers[i]->length()) };
+            iov->push_back(vec);
+        }
+    }
+    if (!iov->empty())
+    {
+        output->appendv(&*iov->begin(), static_cast<int>(iov->size()));
+    }
+}
+
 void AsyncLogging::threadFunc()
 {
     assert(running_ == true);
     latch_.countDown();
-    LogFile output(basename_, rollSize_, false);
+    LogFile output(basename_, rollSize_, false, flushInterval_, writeMode_);
+    output.setSyncInterval(syncInterval_);
+    if (headerCallback_)
+    {
+        output.setHeaderCallback(headerCallback_);
+    }
     BufferPtr newBuffer1(new Buffer);
     BufferPtr newBuffer2(new Buffer);
     newBuffer1->bzero();
     newBuffer2->bzero();
     BufferVector buffersToWrite;
     buffersToWrite.reserve(16);
+    BufferVector stagedToWrite;
+    BufferVector spareBuffers;      // 写完回收的缓冲区, 供下一轮harvestStages使用
+    std::vector<struct iovec> iov;
     while (running_)
     {
         assert(newBuffer1 && newBuffer1->length() == 0);
@@ -69,21 +339,32 @@ void AsyncLogging::threadFunc()
 
         {
             muduo::MutexLockGuard lock(mutex_);
-            if (buffers_.empty())  // unusual usage!
+            if (buffers_.empty() && __atomic_load_n(&wakeupPending_, __ATOMIC_ACQUIRE) == 0)  // unusual usage!
             {
                 cond_.waitForSeconds(flushInterval_);
             }
-            buffers_.push_back(currentBuffer_.release());
-            currentBuffer_ = boost::ptr_container::move(newBuffer1);
+            __atomic_store_n(&wakeupPending_, 0, __ATOMIC_RELEASE);
+            buffers_.push_back(std::move(currentBuffer_));
+            currentBuffer_ = std::move(newBuffer1);
             buffersToWrite.swap(buffers_);
             if (!nextBuffer_)
             {
-                nextBuffer_ = boost::ptr_container::move(newBuffer2);
+                nextBuffer_ = std::move(newBuffer2);
             }
         }
 
         assert(!buffersToWrite.empty());
 
+        if (stageSize_ > 0)
+        {
+            // 各线程环中的日志早于溢出到共享缓冲区的日志, 先写
+            harvestStages(&stagedToWrite, &spareBuffers);
+            buffersToWrite.insert(buffersToWrite.begin(),
+                                  std::make_move_iterator(stagedToWrite.begin()),
+                                  std::make_move_iterator(stagedToWrite.end()));
+            stagedToWrite.clear();
+        }
+
         if (buffersToWrite.size() > 25)
         {
             char buf[256];
@@ -95,34 +376,38 @@ void AsyncLogging::threadFunc()
             buffersToWrite.erase(buffersToWrite.begin() + 2, buffersToWrite.end());
         }
 
-        for (size_t i = 0; i < buffersToWrite.size(); ++i)
-        {
-            // FIXME: use unbuffered stdio FILE ? or use ::writev ?
-            output.append(buffersToWrite[i].data(), buffersToWrite[i].length());
-        }
-
-        if (buffersToWrite.size() > 2)
-        {
-            // drop non-bzero-ed buffers, avoid trashing
-            buffersToWrite.resize(2);
-        }
+        writeBuffers(&output, buffersToWrite, &iov);
 
         if (!newBuffer1)
         {
             assert(!buffersToWrite.empty());
-            newBuffer1 = buffersToWrite.pop_back();
+            newBuffer1 = std::move(buffersToWrite.back());
+            buffersToWrite.pop_back();
             newBuffer1->reset();
         }
 
         if (!newBuffer2)
         {
             assert(!buffersToWrite.empty());
-            newBuffer2 = buffersToWrite.pop_back();
+            newBuffer2 = std::move(buffersToWrite.back());
+            buffersToWrite.pop_back();
             newBuffer2->reset();
         }
 
+        // 其余的留给harvestStages, 不必每轮重新分配; 超出的释放, 避免占用过多内存
+        while (!buffersToWrite.empty() && spareBuffers.size() < kMaxSpareBuffers)
+        {
+            spareBuffers.push_back(std::move(buffersToWrite.back()));
+            buffersToWrite.pop_back();
+            spareBuffers.back()->reset();
+        }
         buffersToWrite.clear();
         output.flush();
     }
+    if (stageSize_ > 0)     // stop()之前各线程已写入的日志
+    {
+        harvestStages(&stagedToWrite, &spareBuffers);
+        writeBuffers(&output, stagedToWrite, &iov);
+    }
     output.flush();
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <muduo/base/BlockingQueue.h>
 #include <muduo/base/BoundedBlockingQueue.h>
 #include <muduo/base/CountDownLatch.h>
+#include <muduo/base/LogFile.h>
 #include <muduo/base/Mutex.h>
 #include <muduo/base/Thread.h>
 
@@ -12,7 +13,11 @@
 #include <boost/bind.hpp>
 #include <boost/noncopyable.hpp>
 #include <boost/scoped_ptr.hpp>
-#include <boost/ptr_container/ptr_vector.hpp>
+
+#include <memory>
+#include <vector>
+
+#include <pthread.h>
 
 namespace muduo
 {
@@ -25,14 +30,29 @@ public:
         size_t rollSize,
         int flushInterval = 3);
 
-    ~AsyncLogging()
+    ~AsyncLogging();
+
+    /// Gives every thread calling append() its own ring of @c bytes,
+    /// rounded up to a power of 2. append() then only copies the line into
+    /// the ring, the backend merges all rings by timestamp. Lines that do
+    /// not fit go through the shared buffers and are written after the
+    /// rings of the same round.
+    /// 0 disables, which is the default. Must be called before start().
+    void setPerThreadBuffer(size_t bytes);
+
+    /// How the backend writes each round of buffers, see LogFile::WriteMode,
+    /// and how often it calls fdatasync(2), 0 never.
+    /// Must be called before start().
+    void setWriteMode(LogFile::WriteMode mode, int syncInterval = 0)
     {
-        if (running_)
-        {
-            stop();
-        }
+        writeMode_ = mode;
+        syncInterval_ = syncInterval;
     }
 
+    /// see LogFile::setHeaderCallback, must be called before start().
+    void setHeaderCallback(const LogFile::HeaderCallback& cb)
+    { headerCallback_ = cb; }
+
     void append(const char* logline, int len);
 
     void start()
@@ -51,15 +71,19 @@ public:
 
 private:
 
-    // declare but not define, prevent compiler-synthesized functions
-    AsyncLogging(const AsyncLogging&);  // ptr_container
-    void operator=(const AsyncLogging&);  // ptr_container
-
     void threadFunc();
 
     typedef muduo::detail::FixedBuffer<muduo::detail::kLargeBuffer> Buffer;
-    typedef boost::ptr_vector<Buffer> BufferVector;
-    typedef BufferVector::auto_type BufferPtr;
+    typedef std::unique_ptr<Buffer> BufferPtr;
+    typedef std::vector<BufferPtr> BufferVector;
+
+    struct Stage;   // 一个前端线程的环形缓冲区
+
+    void appendShared(const char* logline, int len);
+    Stage* newStage();
+    void harvestStages(BufferVector* buffers, BufferVector* spares);   // 优先使用spares中的空缓冲区
+    static void writeBuffers(LogFile* output, const BufferVector& buffers, std::vector<struct iovec>* iov);
+    static void onThreadExit(void* stage);
 
     const int flushInterval_;
     bool running_;
@@ -72,6 +96,13 @@ private:
     BufferPtr currentBuffer_;
     BufferPtr nextBuffer_;
     BufferVector buffers_;
+    size_t stageSize_;              // 每线程环形缓冲区大小, 0表示不使用
+    pthread_key_t stageKey_;        // 当前线程的Stage
+    std::vector<Stage*> stages_;    // 所有线程的Stage, mutex_保护
+    int wakeupPending_;             // 有Stage超过半满, 原子操作
+    LogFile::WriteMode writeMode_;
+    int syncInterval_;              // fdatasync间隔秒数, 0表示不调用
+    LogFile::HeaderCallback headerCallback_;
 };
 
 }
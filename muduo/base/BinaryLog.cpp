@@ -0,0 +1,334 @@
+﻿#include <muduo/base/BinaryLog.h>
+
+#include <muduo/base/CurrentThread.h>
+#include <muduo/base/Mutex.h>
+#include <muduo/base/Timestamp.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <stdlib.h>
+#include <time.h>
+
+namespace muduo
+{
+// Logging.cpp中的全局变量
+extern Logger::OutputFunc g_output;
+extern Logger::FlushFunc g_flush;
+extern const char* LogLevelName[Logger::NUM_LOG_LEVELS];
+}
+
+using namespace muduo;
+
+namespace
+{
+MutexLock g_siteMutex;
+std::vector<string> g_siteRecords;  // 以编号为下标的格式串定义记录, g_siteMutex保护
+
+const size_t kHeaderSize = 4;       // kMagic, 记录类型, uint16_t记录长度
+
+template<typename T>
+bool readValue(const char** p, const char* end, T* v)
+{
+    if (end - *p < static_cast<ptrdiff_t>(sizeof(T)))
+    {
+        return false;
+    }
+    memcpy(v, *p, sizeof(T));
+    *p += sizeof(T);
+    return true;
+}
+
+bool readString(const char** p, const char* end, string* s)
+{
+    uint16_t len = 0;
+    if (!readValue(p, end, &len) || end - *p < len)
+    {
+        return false;
+    }
+    s->assign(*p, len);
+    *p += len;
+    return true;
+}
+
+void putHeader(string* record, char type)
+{
+    record->push_back(BinaryLog::kMagic);
+    record->push_back(type);
+    record->append(2, '\0');        // 长度, 最后填写
+}
+
+void finishRecord(char* record, size_t len)
+{
+    uint16_t n = static_cast<uint16_t>(len);
+    memcpy(record + 2, &n, sizeof n);
+}
+}
+
+void BinaryLog::Writer::putString(const char* str, size_t len)
+{
+    size_t avail = implicit_cast<size_t>(buffer_.avail());
+    if (truncated_ || avail <= 1 + sizeof(uint16_t))
+    {
+        truncated_ = true;
+        return;
+    }
+    if (len >= avail - 1 - sizeof(uint16_t))       // 截断过长的字符串
+    {
+        len = avail - 1 - sizeof(uint16_t) - 1;
+        truncated_ = true;
+    }
+    char type = kString;
+    uint16_t n = static_cast<uint16_t>(len);
+    buffer_.append(&type, 1);
+    buffer_.append(reinterpret_cast<const char*>(&n), sizeof n);
+    buffer_.append(str, len);
+}
+
+uint32_t BinaryLog::registerSite(Logger::SourceFile file, int line,
+                                 Logger::LogLevel level, const char* format)
+{
+    string record;
+    putHeader(&record, kSiteRecord);
+    uint32_t site = 0;
+    {
+        MutexLockGuard lock(g_siteMutex);
+        site = static_cast<uint32_t>(g_siteRecords.size());
+        record.append(reinterpret_cast<const char*>(&site), sizeof site);
+        uint8_t lv = static_cast<uint8_t>(level);
+        record.append(reinterpret_cast<const char*>(&lv), sizeof lv);
+        int32_t ln = line;
+        record.append(reinterpret_cast<const char*>(&ln), sizeof ln);
+        uint16_t fileLen = static_cast<uint16_t>(file.size_);
+        record.append(reinterpret_cast<const char*>(&fileLen), sizeof fileLen);
+        record.append(file.data_, fileLen);
+        size_t formatLen = std::min(strlen(format), implicit_cast<size_t>(detail::kSmallBuffer / 2));
+        uint16_t fmtLen = static_cast<uint16_t>(formatLen);
+        record.append(reinterpret_cast<const char*>(&fmtLen), sizeof fmtLen);
+        record.append(format, fmtLen);
+        finishRecord(&*record.begin(), record.size());
+        g_siteRecords.push_back(record);
+    }
+    g_output(record.data(), static_cast<int>(record.size()));     // 定义先于该处的第一条记录输出
+    return site;
+}
+
+string BinaryLog::siteTable()
+{
+    string table;
+    MutexLockGuard lock(g_siteMutex);
+    for (size_t i = 0; i < g_siteRecords.size(); ++i)
+    {
+        table += g_siteRecords[i];
+    }
+    return table;
+}
+
+void BinaryLog::beginEvent(Writer* w, uint32_t site)
+{
+    char header[kHeaderSize] = { kMagic, kEventRecord, 0, 0 };
+    w->put(header, sizeof header);
+    w->putValue(site);
+    w->putValue(Timestamp::now().microSecondsSinceEpoch());
+    w->putValue(static_cast<int32_t>(CurrentThread::tid()));
+}
+
+void BinaryLog::finishEvent(Writer* w, Logger::LogLevel level)
+{
+    LogStream::Buffer& buf = w->buffer();
+    finishRecord(buf.current() - buf.length(), buf.length());
+    g_output(buf.data(), buf.length());
+    if (level == Logger::FATAL)
+    {
+        g_flush();
+        abort();
+    }
+}
+
+size_t BinaryLogDecoder::decode(const char* data, size_t len, string* out, bool eof)
+{
+    const char* p = data;
+    const char* end = data + len;
+    while (p < end)
+    {
+        if (*p == BinaryLog::kMagic)
+        {
+            uint16_t recordLen = 0;
+            if (end - p < static_cast<ptrdiff_t>(kHeaderSize))
+            {
+                break;
+            }
+            memcpy(&recordLen, p + 2, sizeof recordLen);
+            if (recordLen < kHeaderSize)        // 损坏的记录, 按文本处理该字节
+            {
+                out->push_back(*p++);
+                continue;
+            }
+            if (end - p < recordLen)
+            {
+                break;
+            }
+            if (p[1] == BinaryLog::kSiteRecord)
+            {
+                decodeSite(p + kHeaderSize, p + recordLen);
+            }
+            else if (p[1] == BinaryLog::kEventRecord)
+            {
+                decodeEvent(p + kHeaderSize, p + recordLen, out);
+            }
+            p += recordLen;
+        }
+        else    // 文本日志行原样输出
+        {
+            const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+            if (eol == NULL)
+            {
+                if (!eof)
+                {
+                    break;
+                }
+                eol = end - 1;
+            }
+            out->append(p, eol + 1);
+            p = eol + 1;
+        }
+    }
+    if (eof && p < end)     // 末尾不完整的记录
+    {
+        out->append("<truncated binary record>\n");
+        p = end;
+    }
+    return static_cast<size_t>(p - data);
+}
+
+void BinaryLogDecoder::decodeSite(const char* p, const char* end)
+{
+    uint32_t id = 0;
+    uint8_t level = 0;
+    int32_t line = 0;
+    Site site;
+    if (readValue(&p, end, &id)
+        && readValue(&p, end, &level)
+        && readValue(&p, end, &line)
+        && readString(&p, end, &site.file)
+        && readString(&p, end, &site.format)
+        && level < Logger::NUM_LOG_LEVELS)
+    {
+        site.level = static_cast<Logger::LogLevel>(level);
+        site.line = line;
+        sites_[id] = site;
+    }
+}
+
+void BinaryLogDecoder::decodeEvent(const char* p, const char* end, string* out)
+{
+    uint32_t id = 0;
+    int64_t micros = 0;
+    int32_t tid = 0;
+    if (!readValue(&p, end, &id) || !readValue(&p, end, &micros) || !readValue(&p, end, &tid))
+    {
+        return;
+    }
+
+    LogStream stream;
+    time_t seconds = static_cast<time_t>(micros / Timestamp::kMicroSecondsPerSecond);
+    struct tm tm_time;
+    ::gmtime_r(&seconds, &tm_time);
+    char buf[64];
+    snprintf(buf, sizeof buf, "%4d%02d%02d %02d:%02d:%02d.%06dZ %5d ",
+             tm_time.tm_year + 1900, tm_time.tm_mon + 1, tm_time.tm_mday,
+             tm_time.tm_hour, tm_time.tm_min, tm_time.tm_sec,
+             static_cast<int>(micros % Timestamp::kMicroSecondsPerSecond), tid);
+    stream << buf;
+
+    std::map<uint32_t, Site>::const_iterator it = sites_.find(id);
+    if (it == sites_.end())
+    {
+        stream << "UNKNOWN site " << id;
+    }
+    else
+    {
+        stream << LogLevelName[it->second.level];
+    }
+    const string& format = it == sites_.end() ? string() : it->second.format;
+
+    // 依次用参数替换格式串中的{}, 多余的参数以空格分隔附在末尾
+    size_t pos = 0;
+    while (p < end)
+    {
+        size_t brace = format.find("{}", pos);
+        if (brace == string::npos)
+        {
+            stream.append(format.data() + pos, static_cast<int>(format.size() - pos));
+            pos = format.size();
+            stream << ' ';
+        }
+        else
+        {
+            stream.append(format.data() + pos, static_cast<int>(brace - pos));
+            pos = brace + 2;
+        }
+        char type = *p++;
+        switch (type)
+        {
+        case BinaryLog::kInt:
+        {
+            int64_t v = 0;
+            readValue(&p, end, &v);
+            stream << static_cast<long long>(v);
+            break;
+        }
+        case BinaryLog::kUInt:
+        {
+            uint64_t v = 0;
+            readValue(&p, end, &v);
+            stream << static_cast<unsigned long long>(v);
+            break;
+        }
+        case BinaryLog::kDouble:
+        {
+            double v = 0;
+            readValue(&p, end, &v);
+            stream << v;
+            break;
+        }
+        case BinaryLog::kChar:
+        {
+            char v = 0;
+            readValue(&p, end, &v);
+            stream << v;
+            break;
+        }
+        case BinaryLog::kString:
+        {
+            string v;
+            if (!readString(&p, end, &v))
+            {
+                p = end;
+            }
+            stream << v;
+            break;
+        }
+        case BinaryLog::kPointer:
+        {
+            uint64_t v = 0;
+            readValue(&p, end, &v);
+            stream << reinterpret_cast<const void*>(static_cast<uintptr_t>(v));
+            break;
+        }
+        default:            // 未知类型, 无法继续解析参数
+            p = end;
+            break;
+        }
+    }
+    if (pos < format.size())
+    {
+        stream.append(format.data() + pos, static_cast<int>(format.size() - pos));
+    }
+    if (it != sites_.end())
+    {
+        stream << " - " << it->second.file << ':' << it->second.line;
+    }
+    stream << '\n';
+    out->append(stream.buffer().data(), stream.buffer().length());
+}
\ No newline at end of file
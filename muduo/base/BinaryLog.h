@@ -0,0 +1,188 @@
+﻿#ifndef MUDUO_BASE_BINARYLOG_H
+#define MUDUO_BASE_BINARYLOG_H
+
+#include <muduo/base/Logging.h>
+#include <muduo/base/StringPiece.h>
+#include <muduo/base/Types.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <map>
+
+#include <stdint.h>
+#include <string.h>
+
+/*
+    二进制日志: 调用处只记录静态的格式串编号和参数的原始字节, 格式化推迟到离线解码
+    记录与文本日志一样交给Logger的输出函数, 可以与文本日志混在同一文件中
+    每条记录以kMagic开头, 文本日志行以日期数字开头, 解码时据此区分
+
+    格式串中的每个{}依次替换为一个参数:
+        LOG_BINARY(muduo::Logger::INFO, "conn {} read {} bytes in {}s", name, n, seconds);
+*/
+
+namespace muduo
+{
+
+class BinaryLog : boost::noncopyable
+{
+public:
+    static const char kMagic = '\xB1';
+
+    enum RecordType
+    {
+        kSiteRecord = 'S',      // 格式串定义: 编号, 级别, 文件, 行号, 格式串
+        kEventRecord = 'E',     // 一次日志: 编号, 时间, 线程id, 参数
+    };
+
+    enum ArgType
+    {
+        kInt = 'i',             // int64_t
+        kUInt = 'u',            // uint64_t
+        kDouble = 'd',          // double
+        kChar = 'c',            // char
+        kString = 's',          // uint16_t长度 + 内容
+        kPointer = 'p',         // uint64_t
+    };
+
+    /// Encodes arguments into a record, silently truncating at the buffer end.
+    class Writer : boost::noncopyable
+    {
+    public:
+        Writer() : truncated_(false) {}
+
+        void put(const void* data, size_t len)
+        {
+            if (!truncated_ && implicit_cast<size_t>(buffer_.avail()) > len)
+            {
+                buffer_.append(static_cast<const char*>(data), len);
+            }
+            else
+            {
+                truncated_ = true;
+            }
+        }
+
+        template<typename T>
+        void putValue(T v) { put(&v, sizeof v); }
+
+        void putArg(char type, const void* data, size_t len)
+        {
+            if (!truncated_ && implicit_cast<size_t>(buffer_.avail()) > len + 1)
+            {
+                buffer_.append(&type, 1);
+                buffer_.append(static_cast<const char*>(data), len);
+            }
+            else
+            {
+                truncated_ = true;
+            }
+        }
+
+        void putString(const char* str, size_t len);
+
+        LogStream::Buffer& buffer() { return buffer_; }
+
+    private:
+        LogStream::Buffer buffer_;
+        bool truncated_;            // 超出缓冲区后的参数被丢弃
+    };
+
+    /// Assigns an id to a call site and outputs its definition record.
+    /// Called once per site by LOG_BINARY.
+    static uint32_t registerSite(Logger::SourceFile file, int line,
+                                 Logger::LogLevel level, const char* format);
+
+    /// Definition records of all sites, write it at the start of every
+    /// log file so each file decodes on its own, see LogFile::setHeaderCallback.
+    static string siteTable();
+
+    template<typename... Args>
+    static void log(uint32_t site, Logger::LogLevel level, const Args&... args)
+    {
+        Writer w;
+        beginEvent(&w, site);
+        encodeAll(&w, args...);
+        finishEvent(&w, level);
+    }
+
+private:
+    static void beginEvent(Writer* w, uint32_t site);
+    static void finishEvent(Writer* w, Logger::LogLevel level);
+
+    static void encodeAll(Writer*) {}
+
+    template<typename T, typename... Rest>
+    static void encodeAll(Writer* w, const T& first, const Rest&... rest)
+    {
+        encode(w, first);
+        encodeAll(w, rest...);
+    }
+
+    static void encode(Writer* w, bool v)               { encodeInt(w, v); }
+    static void encode(Writer* w, short v)              { encodeInt(w, v); }
+    static void encode(Writer* w, int v)                { encodeInt(w, v); }
+    static void encode(Writer* w, long v)               { encodeInt(w, v); }
+    static void encode(Writer* w, long long v)          { encodeInt(w, v); }
+    static void encode(Writer* w, unsigned short v)     { encodeUInt(w, v); }
+    static void encode(Writer* w, unsigned int v)       { encodeUInt(w, v); }
+    static void encode(Writer* w, unsigned long v)      { encodeUInt(w, v); }
+    static void encode(Writer* w, unsigned long long v) { encodeUInt(w, v); }
+    static void encode(Writer* w, float v)              { encode(w, static_cast<double>(v)); }
+    static void encode(Writer* w, double v)             { w->putArg(kDouble, &v, sizeof v); }
+    static void encode(Writer* w, char v)               { w->putArg(kChar, &v, 1); }
+    static void encode(Writer* w, const char* v)        { w->putString(v, strlen(v)); }
+    static void encode(Writer* w, const string& v)      { w->putString(v.data(), v.size()); }
+#ifndef MUDUO_STD_STRING
+    static void encode(Writer* w, const std::string& v) { w->putString(v.data(), v.size()); }
+#endif
+    static void encode(Writer* w, const StringPiece& v)
+    { w->putString(v.data(), implicit_cast<size_t>(v.size())); }
+    static void encode(Writer* w, const void* v)
+    {
+        uint64_t p = reinterpret_cast<uintptr_t>(v);
+        w->putArg(kPointer, &p, sizeof p);
+    }
+
+    static void encodeInt(Writer* w, int64_t v)   { w->putArg(kInt, &v, sizeof v); }
+    static void encodeUInt(Writer* w, uint64_t v) { w->putArg(kUInt, &v, sizeof v); }
+};
+
+/// Renders a stream of binary records and text lines back to text,
+/// in the same layout Logger uses for text lines.
+class BinaryLogDecoder : boost::noncopyable
+{
+public:
+    /// Decodes as much of [data, data+len) as possible, appending text to
+    /// *out, returns the bytes consumed. An incomplete record or line at
+    /// the end is left for the next call, unless @c eof.
+    size_t decode(const char* data, size_t len, string* out, bool eof = false);
+
+private:
+    struct Site
+    {
+        Logger::LogLevel level;
+        int line;
+        string file;
+        string format;
+    };
+
+    void decodeSite(const char* p, const char* end);
+    void decodeEvent(const char* p, const char* end, string* out);
+
+    std::map<uint32_t, Site> sites_;
+};
+
+}       // namespace muduo
+
+// 每个调用处的编号在第一次执行时注册, 之后只编码参数
+#define LOG_BINARY(level, format, ...) \
+    do { \
+        if (muduo::Logger::logLevel() <= (level)) { \
+            static const uint32_t muduoBinaryLogSite_ = \
+                muduo::BinaryLog::registerSite(__FILE__, __LINE__, (level), format); \
+            muduo::BinaryLog::log(muduoBinaryLogSite_, (level), ##__VA_ARGS__); \
+        } \
+    } while (0)
+
+#endif  // MUDUO_BASE_BINARYLOG_H
\ No newline at end of file
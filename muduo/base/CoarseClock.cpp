@@ -0,0 +1,117 @@
+﻿#include <muduo/base/CoarseClock.h>
+
+#include <string.h>
+
+using namespace muduo;
+
+namespace
+{
+
+// 顺序锁保护的渲染结果, g_seq为奇数时正在写
+struct Rendered
+{
+    int64_t second;
+    char utc[CoarseClock::kSecondLength];
+    char local[CoarseClock::kSecondLength];
+};
+
+int64_t  g_nowMicroSeconds = 0;
+unsigned g_seq = 0;
+Rendered g_rendered = { -1, { 0 }, { 0 } };
+TimeZone g_timeZone;
+
+inline void formatTwoDigits(int value, char* buf)
+{
+    buf[0] = static_cast<char>('0' + value / 10);
+    buf[1] = static_cast<char>('0' + value % 10);
+}
+
+bool copyRendered(time_t seconds, bool local, char* buf)
+{
+    unsigned seq = __atomic_load_n(&g_seq, __ATOMIC_ACQUIRE);
+    if ((seq & 1) != 0 || __atomic_load_n(&g_rendered.second, __ATOMIC_RELAXED) != seconds)
+    {
+        return false;
+    }
+    memcpy(buf, local ? g_rendered.local : g_rendered.utc, CoarseClock::kSecondLength);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&g_seq, __ATOMIC_RELAXED) == seq;    // 拷贝期间没有被改写
+}
+
+}   // namespace
+
+void CoarseClock::update(Timestamp now)
+{
+    int64_t microSeconds = now.microSecondsSinceEpoch();
+    __atomic_store_n(&g_nowMicroSeconds, microSeconds, __ATOMIC_RELAXED);
+
+    int64_t second = microSeconds / Timestamp::kMicroSecondsPerSecond;
+    int64_t cached = __atomic_load_n(&g_rendered.second, __ATOMIC_RELAXED);
+    // 多个事件循环交替更新, 只往前走; 墙上时钟被往回调超过一秒时才重新渲染
+    if (second == cached || (second < cached && second >= cached - 1))
+    {
+        return;
+    }
+    unsigned seq = __atomic_load_n(&g_seq, __ATOMIC_RELAXED);
+    if ((seq & 1) != 0
+        || !__atomic_compare_exchange_n(&g_seq, &seq, seq + 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+    {
+        return;                 // 别的线程正在渲染
+    }
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    time_t seconds = static_cast<time_t>(second);
+    formatSecond(TimeZone::toUtcTime(seconds), g_rendered.utc);
+    if (g_timeZone.valid())
+    {
+        formatSecond(g_timeZone.toLocalTime(seconds), g_rendered.local);
+    }
+    else
+    {
+        memcpy(g_rendered.local, g_rendered.utc, kSecondLength);
+    }
+    __atomic_store_n(&g_rendered.second, second, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+Timestamp CoarseClock::now()
+{
+    int64_t microSeconds = __atomic_load_n(&g_nowMicroSeconds, __ATOMIC_RELAXED);
+    return microSeconds != 0 ? Timestamp(microSeconds) : Timestamp::now();
+}
+
+void CoarseClock::setTimeZone(const TimeZone& tz)
+{
+    g_timeZone = tz;
+    __atomic_store_n(&g_rendered.second, -1, __ATOMIC_RELAXED);     // 已渲染的本地时间作废
+}
+
+const TimeZone& CoarseClock::timeZone()
+{
+    return g_timeZone;
+}
+
+bool CoarseClock::formatUtc(time_t seconds, char* buf)
+{
+    return copyRendered(seconds, false, buf);
+}
+
+bool CoarseClock::formatLocal(time_t seconds, char* buf)
+{
+    return copyRendered(seconds, true, buf);
+}
+
+void CoarseClock::formatSecond(const struct tm& tm, char* buf)
+{
+    int year = tm.tm_year + 1900;           // "%4d%02d%02d %02d:%02d:%02d"
+    formatTwoDigits(year / 100, buf);
+    formatTwoDigits(year % 100, buf + 2);
+    formatTwoDigits(tm.tm_mon + 1, buf + 4);
+    formatTwoDigits(tm.tm_mday, buf + 6);
+    buf[8] = ' ';
+    formatTwoDigits(tm.tm_hour, buf + 9);
+    buf[11] = ':';
+    formatTwoDigits(tm.tm_min, buf + 12);
+    buf[14] = ':';
+    formatTwoDigits(tm.tm_sec, buf + 15);
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+﻿#ifndef MUDUO_BASE_COARSECLOCK_H
+#define MUDUO_BASE_COARSECLOCK_H
+
+#include <muduo/base/TimeZone.h>
+#include <muduo/base/Timestamp.h>
+
+namespace muduo
+{
+
+///
+/// Process-wide clock advanced by every EventLoop once per poll iteration.
+///
+/// Besides the latest time it keeps the current second pre-rendered as
+/// "YYYYMMDD HH:MM:SS", in UTC and in the logging time zone, so Logger and
+/// Timestamp::toFormattedString copy 17 bytes on a new second instead of
+/// converting and printing it again in every thread.
+namespace CoarseClock
+{
+const int kSecondLength = 17;
+
+/// Cheap unless the second changes, safe to call from any thread.
+void update(Timestamp now);
+/// The time of the latest update(), Timestamp::now() if there was none.
+Timestamp now();
+
+/// Zone of the local rendering, UTC if invalid. Set it through
+/// Logger::setTimeZone before starting threads.
+void setTimeZone(const TimeZone& tz);
+const TimeZone& timeZone();
+
+/// Copy the rendered second into buf (kSecondLength bytes) if it is the cached one.
+bool formatUtc(time_t seconds, char* buf);
+bool formatLocal(time_t seconds, char* buf);
+
+/// Render without the cache.
+void formatSecond(const struct tm& tm, char* buf);
+
+}       // namespace CoarseClock
+
+}       // namespace muduo
+
+#endif  // MUDUO_BASE_COARSECLOCK_H
\ No newline at end of file
@@ -0,0 +1,108 @@
+﻿#include <muduo/base/CpuAffinity.h>
+#include <muduo/base/FileUtil.h>
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h> // snprintf
+#include <stdlib.h>
+
+using namespace muduo;
+
+CpuAffinity::CpuSet CpuAffinity::parseCpuList(StringPiece list)
+{
+    CpuSet result;
+    const string str(list.data(), list.size());     // strtol需要以'\0'结尾
+    const char* p = str.c_str();
+    const char* end = p + str.size();
+    while (p < end)
+    {
+        char* next = NULL;
+        long first = ::strtol(p, &next, 10);
+        if (next == p)          // 不是数字, 如结尾的换行
+        {
+            break;
+        }
+        long last = first;
+        p = next;
+        if (p < end && *p == '-')
+        {
+            last = ::strtol(p + 1, &next, 10);
+            p = next;
+        }
+        for (long cpu = first; cpu <= last; ++cpu)
+        {
+            result.push_back(static_cast<int>(cpu));
+        }
+        if (p < end && *p == ',')
+        {
+            ++p;
+        }
+    }
+    return result;
+}
+
+CpuAffinity::CpuSet CpuAffinity::cpusOfNumaNode(int node)
+{
+    char path[64];
+    snprintf(path, sizeof path, "/sys/devices/system/node/node%d/cpulist", node);
+    string content;
+    if (FileUtil::readFile(path, 4096, &content) != 0)
+    {
+        return CpuSet();
+    }
+    return parseCpuList(content);
+}
+
+int CpuAffinity::numNumaNodes()
+{
+    string content;
+    if (FileUtil::readFile("/sys/devices/system/node/online", 4096, &content) != 0)
+    {
+        return 1;
+    }
+    CpuSet nodes = parseCpuList(content);   // 节点列表与cpulist格式相同
+    return nodes.empty() ? 1 : static_cast<int>(nodes.size());
+}
+
+std::vector<CpuAffinity::CpuSet> CpuAffinity::eachCpu(const std::vector<int>& cpus)
+{
+    std::vector<CpuSet> result;
+    for (size_t i = 0; i < cpus.size(); ++i)
+    {
+        result.push_back(CpuSet(1, cpus[i]));
+    }
+    return result;
+}
+
+std::vector<CpuAffinity::CpuSet> CpuAffinity::eachNumaNode(const std::vector<int>& nodes)
+{
+    std::vector<CpuSet> result;
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        result.push_back(cpusOfNumaNode(nodes[i]));
+    }
+    return result;
+}
+
+bool CpuAffinity::setCurrentThread(const CpuSet& cpus)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (size_t i = 0; i < cpus.size(); ++i)
+    {
+        if (cpus[i] < 0 || cpus[i] >= CPU_SETSIZE)     // 超出cpu_set_t的范围, CPU_SET的行为未定义
+        {
+            errno = EINVAL;
+            return false;
+        }
+        CPU_SET(cpus[i], &set);
+    }
+    int ret = ::pthread_setaffinity_np(::pthread_self(), sizeof set, &set);
+    if (ret != 0)
+    {
+        errno = ret;        // pthread函数通过返回值报告错误
+        return false;
+    }
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+﻿#ifndef MUDUO_BASE_CPUAFFINITY_H
+#define MUDUO_BASE_CPUAFFINITY_H
+
+#include <muduo/base/StringPiece.h>
+#include <vector>
+
+namespace muduo
+{
+
+namespace CpuAffinity
+{
+typedef std::vector<int> CpuSet;
+
+/// "0-3,8,10-11", the format of sysfs cpulist files
+CpuSet parseCpuList(StringPiece list);
+
+/// read /sys/devices/system/node/node<N>/cpulist, empty if unknown
+CpuSet cpusOfNumaNode(int node);
+/// 1 on machines without NUMA information
+int numNumaNodes();
+
+/// one set per cpu
+std::vector<CpuSet> eachCpu(const std::vector<int>& cpus);
+/// one set per node, holding all cpus of that node
+std::vector<CpuSet> eachNumaNode(const std::vector<int>& nodes);
+
+/// Pins the calling thread, returns false with errno set on failure.
+/// Memory first touched afterwards is allocated on the local node.
+bool setCurrentThread(const CpuSet& cpus);
+
+}       // namespace CpuAffinity
+
+}       // namespace muduo
+
+#endif  // MUDUO_BASE_CPUAFFINITY_H
\ No newline at end of file
@@ -12,6 +12,7 @@ namespace CurrentThread
 
     void cacheTid();        // 设置t_tidString
     bool isMainThread();
+    bool setAffinity(int cpu);  // 把当前线程绑定到一个CPU上, 失败返回false并保留errno
 
     inline int tid()        // Thread::runInThread会调用此函数, 此时会设置t_cachTid与t_tidString
     {
@@ -0,0 +1,80 @@
+﻿#ifndef MUDUO_BASE_FUTEX_H
+#define MUDUO_BASE_FUTEX_H
+
+#include <boost/noncopyable.hpp>
+
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace muduo
+{
+
+namespace detail
+{
+
+inline void cpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+///
+/// Parks threads on a futex until notified, notify() costs one fence
+/// and one load when nobody waits.
+///
+/// Waiter:                              Notifier:
+///   int key = ev.prepareWait();          make the condition true
+///   if (condition) ev.cancelWait();      ev.notify();
+///   else ev.wait(key);
+class FutexEvent : boost::noncopyable
+{
+public:
+    FutexEvent()
+        : seq_(0),
+        waiters_(0)
+    {
+    }
+
+    int prepareWait()
+    {
+        __atomic_add_fetch(&waiters_, 1, __ATOMIC_SEQ_CST);     // 先登记再检查条件, 与notify配对
+        return __atomic_load_n(&seq_, __ATOMIC_SEQ_CST);
+    }
+
+    /// The stale registration costs the next notify() one extra wakeup.
+    void cancelWait()
+    {
+    }
+
+    /// Returns after a notify() later than prepareWait(), or spuriously.
+    void wait(int key)
+    {
+        ::syscall(SYS_futex, &seq_, FUTEX_WAIT_PRIVATE, key, NULL, NULL, 0);   // seq_已变化时立即返回
+    }
+
+    /// Wakes all parked threads, they re-check their condition.
+    void notify()
+    {
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);    // 条件的修改先于读取waiters_
+        // 清零后, 被唤醒线程尚未运行前的notify不再进入内核
+        if (__atomic_load_n(&waiters_, __ATOMIC_RELAXED) > 0
+            && __atomic_exchange_n(&waiters_, 0, __ATOMIC_SEQ_CST) > 0)
+        {
+            __atomic_add_fetch(&seq_, 1, __ATOMIC_SEQ_CST);
+            ::syscall(SYS_futex, &seq_, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+        }
+    }
+
+private:
+    int seq_;           // 每次唤醒加一, futex等待的字
+    int waiters_;       // 上次唤醒后调用prepareWait的线程数
+};
+
+}       // namespace detail
+
+}       // namespace muduo
+
+#endif  // MUDUO_BASE_FUTEX_H
\ No newline at end of file
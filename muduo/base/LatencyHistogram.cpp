@@ -0,0 +1,70 @@
+﻿#include <muduo/base/LatencyHistogram.h>
+
+#include <algorithm>
+
+#include <string.h>
+
+using namespace muduo;
+
+const int LatencyHistogram::kLinearBuckets;
+const int LatencyHistogram::kSubBuckets;
+const int LatencyHistogram::kMaxExponent;
+const int LatencyHistogram::kNumBuckets;
+
+LatencyHistogram::LatencyHistogram()
+    : count_(0),
+    sum_(0),
+    max_(0)
+{
+    memset(buckets_, 0, sizeof buckets_);
+}
+
+void LatencyHistogram::snapshot(Snapshot* snap) const
+{
+    snap->buckets.resize(kNumBuckets);
+    for (int i = 0; i < kNumBuckets; ++i)
+    {
+        snap->buckets[i] = __atomic_load_n(&buckets_[i], __ATOMIC_RELAXED);
+    }
+    snap->count = __atomic_load_n(&count_, __ATOMIC_RELAXED);
+    snap->sum = __atomic_load_n(&sum_, __ATOMIC_RELAXED);
+    snap->max = __atomic_load_n(&max_, __ATOMIC_RELAXED);
+}
+
+int64_t LatencyHistogram::bucketUpperBound(int index)
+{
+    if (index < kLinearBuckets)
+    {
+        return index;
+    }
+    int exponent = (index - kLinearBuckets) / kSubBuckets + 4;
+    int64_t sub = (index - kLinearBuckets) % kSubBuckets;
+    int64_t width = 1LL << (exponent - 3);
+    return (kSubBuckets + sub) * width + width - 1;
+}
+
+int64_t LatencyHistogram::Snapshot::percentile(double p) const
+{
+    // 各桶是分别读取的, 以桶的总数为准
+    int64_t total = 0;
+    for (size_t i = 0; i < buckets.size(); ++i)
+    {
+        total += buckets[i];
+    }
+    if (total == 0)
+    {
+        return 0;
+    }
+    int64_t rank = static_cast<int64_t>(p / 100.0 * static_cast<double>(total) + 0.5);
+    rank = std::max<int64_t>(1, std::min(rank, total));
+    int64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i)
+    {
+        seen += buckets[i];
+        if (seen >= rank)
+        {
+            return std::min(bucketUpperBound(static_cast<int>(i)), max);
+        }
+    }
+    return max;
+}
\ No newline at end of file
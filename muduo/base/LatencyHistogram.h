@@ -0,0 +1,92 @@
+﻿#ifndef MUDUO_BASE_LATENCYHISTOGRAM_H
+#define MUDUO_BASE_LATENCYHISTOGRAM_H
+
+#include <muduo/base/copyable.h>
+
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include <stdint.h>
+
+namespace muduo
+{
+
+///
+/// Histogram of microsecond latencies in the spirit of HdrHistogram.
+///
+/// Values below 16 are exact, above that every power of two is split into
+/// 8 linear buckets, so percentiles are within 12.5%. Values are clamped
+/// to 2^40us (12 days). Recording is a few instructions and never allocates.
+///
+/// Only one thread may record. Any thread may take snapshots, which are
+/// not a consistent cut but never tear a single counter.
+class LatencyHistogram : boost::noncopyable
+{
+public:
+    static const int kLinearBuckets = 16;
+    static const int kSubBuckets = 8;           // 每个2的幂次区间的桶数
+    static const int kMaxExponent = 40;
+    static const int kNumBuckets = kLinearBuckets + (kMaxExponent - 4) * kSubBuckets;
+
+    class Snapshot : public muduo::copyable
+    {
+    public:
+        Snapshot() : count(0), sum(0), max(0) { }
+
+        /// Upper bound of the bucket holding the p-th percentile, p in [0, 100].
+        int64_t percentile(double p) const;
+        double mean() const
+        { return count > 0 ? static_cast<double>(sum) / static_cast<double>(count) : 0.0; }
+
+        int64_t count;
+        int64_t sum;
+        int64_t max;
+        std::vector<int64_t> buckets;
+    };
+
+    LatencyHistogram();
+
+    void record(int64_t microSeconds)
+    {
+        int index = bucketIndex(microSeconds);
+        // 单个写者, 用relaxed原子存储保证读者不会读到撕裂的值
+        __atomic_store_n(&buckets_[index], buckets_[index] + 1, __ATOMIC_RELAXED);
+        __atomic_store_n(&count_, count_ + 1, __ATOMIC_RELAXED);
+        __atomic_store_n(&sum_, sum_ + microSeconds, __ATOMIC_RELAXED);
+        if (microSeconds > max_)
+        {
+            __atomic_store_n(&max_, microSeconds, __ATOMIC_RELAXED);
+        }
+    }
+
+    void snapshot(Snapshot* snap) const;
+
+    static int bucketIndex(int64_t value)
+    {
+        if (value < kLinearBuckets)
+        {
+            return value < 0 ? 0 : static_cast<int>(value);
+        }
+        int exponent = 63 - __builtin_clzll(static_cast<unsigned long long>(value));  // >= 4
+        if (exponent >= kMaxExponent)
+        {
+            return kNumBuckets - 1;
+        }
+        int sub = static_cast<int>(value >> (exponent - 3)) & (kSubBuckets - 1);
+        return kLinearBuckets + (exponent - 4) * kSubBuckets + sub;
+    }
+
+    /// The largest value that falls into bucket @c index.
+    static int64_t bucketUpperBound(int index);
+
+private:
+    int64_t buckets_[kNumBuckets];
+    int64_t count_;
+    int64_t sum_;
+    int64_t max_;
+};
+
+}       // namespace muduo
+
+#endif  // MUDUO_BASE_LATENCYHISTOGRAM_H
\ No newline at end of file
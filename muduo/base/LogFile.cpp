@@ -2,9 +2,20 @@
 #include <muduo/base/Logging.h> // strerror_tl
 #include <muduo/base/ProcessInfo.h>
 
+#include <algorithm>
+#include <vector>
+
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
 #include <time.h>
+#include <unistd.h>
 
 using namespace muduo;
 
@@ -12,21 +23,129 @@ using namespace muduo;
 class LogFile::File : boost::noncopyable
 {
 public:
-    explicit File(const string& filename)
-        : fp_(::fopen(filename.data(), "ae")),
+    File(const string& filename, WriteMode mode)
+        : mode_(mode),
+        fp_(NULL),
+        fd_(-1),
+        directBuf_(NULL),
+        directLen_(0),
+        directOffset_(0),
+        directDirty_(false),
         writtenBytes_(0)
     {
-        assert(fp_);
-        ::setbuffer(fp_, buffer_, sizeof buffer_);  // 设置文件指针缓冲区, 超过这个大小会自动flush到文件中
-        // posix_fadvise POSIX_FADV_DONTNEED ?
+        if (mode_ == kStdio)
+        {
+            fp_ = ::fopen(filename.data(), "ae");
+            assert(fp_);
+            ::setbuffer(fp_, buffer_, sizeof buffer_);  // 设置文件指针缓冲区, 超过这个大小会自动flush到文件中
+            // posix_fadvise POSIX_FADV_DONTNEED ?
+        }
+        else if (mode_ == kWritev)
+        {
+            fd_ = ::open(filename.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+            assert(fd_ >= 0);
+        }
+        else
+        {
+            openDirect(filename);
+        }
     }
 
     ~File()
     {
-        ::fclose(fp_);
+        if (fp_)
+        {
+            ::fclose(fp_);
+        }
+        if (directBuf_)
+        {
+            writeDirect();
+            ::free(directBuf_);
+        }
+        if (fd_ >= 0)
+        {
+            ::close(fd_);
+        }
     }
 
     void append(const char* logline, const size_t len)
+    {
+        if (mode_ == kStdio)
+        {
+            appendStdio(logline, len);
+        }
+        else if (mode_ == kWritev)
+        {
+            struct iovec iov = { const_cast<char*>(logline), len };
+            writevAll(&iov, 1);
+        }
+        else
+        {
+            copyDirect(logline, len);
+        }
+        writtenBytes_ += len;
+    }
+
+    void appendv(const struct iovec* iov, int iovcnt)
+    {
+        size_t total = 0;
+        for (int i = 0; i < iovcnt; ++i)
+        {
+            total += iov[i].iov_len;
+        }
+        if (mode_ == kStdio)
+        {
+            for (int i = 0; i < iovcnt; ++i)
+            {
+                appendStdio(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+            }
+        }
+        else if (mode_ == kWritev && iovcnt > 0)
+        {
+            // writevAll会修改数组以便续写
+            std::vector<struct iovec> vec(iov, iov + iovcnt);
+            writevAll(&*vec.begin(), iovcnt);
+        }
+        else if (mode_ == kDirect)
+        {
+            for (int i = 0; i < iovcnt; ++i)
+            {
+                copyDirect(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+            }
+            writeDirect();
+        }
+        writtenBytes_ += total;
+    }
+
+    void flush()
+    {
+        if (fp_)
+        {
+            ::fflush(fp_);
+        }
+        else if (directBuf_)
+        {
+            writeDirect();
+        }
+    }
+
+    void sync()
+    {
+        flush();
+        int fd = fp_ ? ::fileno(fp_) : fd_;
+        if (::fdatasync(fd) < 0)
+        {
+            fprintf(stderr, "LogFile::File::sync() failed %s\n", strerror_tl(errno));
+        }
+    }
+
+    size_t writtenBytes() const { return writtenBytes_; }
+
+private:
+    static const size_t kDirectAlign = 4096;                // O_DIRECT要求的内存/偏移/长度对齐
+    static const size_t kDirectBufferSize = 4 * 1024 * 1024;
+
+    void appendStdio(const char* logline, const size_t len)
     {
         size_t n = write(logline, len);     // 调用内部的write成员函数
         size_t remain = len - n;
@@ -46,26 +165,139 @@ public:
             n += x;
             remain = len - n; // remain -= x
         }
+    }
 
-        writtenBytes_ += len;
+    size_t write(const char* logline, size_t len)
+    {
+#undef fwrite_unlocked
+        return ::fwrite_unlocked(logline, 1, len, fp_); // 不加锁的方式写入
     }
 
-    void flush()
+    // 写完iov中的所有数据, 处理部分写入与IOV_MAX限制
+    void writevAll(struct iovec* iov, int iovcnt)
     {
-        ::fflush(fp_);
+        while (iovcnt > 0)
+        {
+            ssize_t n = ::writev(fd_, iov, std::min(iovcnt, IOV_MAX));
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                fprintf(stderr, "LogFile::File::appendv() failed %s\n", strerror_tl(errno));
+                break;
+            }
+            size_t written = static_cast<size_t>(n);
+            while (iovcnt > 0 && written >= iov->iov_len)
+            {
+                written -= iov->iov_len;
+                ++iov;
+                --iovcnt;
+            }
+            if (iovcnt > 0)
+            {
+                iov->iov_base = static_cast<char*>(iov->iov_base) + written;
+                iov->iov_len -= written;
+            }
+        }
     }
 
-    size_t writtenBytes() const { return writtenBytes_; }
+    void openDirect(const string& filename)
+    {
+        fd_ = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | O_DIRECT, 0644);
+        if (fd_ < 0 && errno == EINVAL)     // tmpfs等不支持O_DIRECT, 退回kWritev
+        {
+            fprintf(stderr, "LogFile::File: O_DIRECT not supported for %s, using writev\n", filename.c_str());
+            mode_ = kWritev;
+            fd_ = ::open(filename.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+            assert(fd_ >= 0);
+            return;
+        }
+        assert(fd_ >= 0);
+        void* buf = NULL;
+        int ret = ::posix_memalign(&buf, kDirectAlign, kDirectBufferSize);
+        assert(ret == 0); (void) ret;
+        directBuf_ = static_cast<char*>(buf);
+        // 已有文件: 从最后一个不完整的块开始续写, 先读回这部分数据
+        struct stat st;
+        if (::fstat(fd_, &st) == 0 && st.st_size > 0)
+        {
+            directOffset_ = st.st_size & ~static_cast<off_t>(kDirectAlign - 1);
+            directLen_ = static_cast<size_t>(st.st_size - directOffset_);
+            int rfd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+            if (rfd < 0 || ::pread(rfd, directBuf_, directLen_, directOffset_) != static_cast<ssize_t>(directLen_))
+            {
+                fprintf(stderr, "LogFile::File: cannot read tail of %s\n", filename.c_str());
+            }
+            if (rfd >= 0)
+            {
+                ::close(rfd);
+            }
+        }
+    }
 
-private:
+    void copyDirect(const char* data, size_t len)
+    {
+        while (len > 0)
+        {
+            size_t n = std::min(len, kDirectBufferSize - directLen_);
+            memcpy(directBuf_ + directLen_, data, n);
+            directLen_ += n;
+            directDirty_ = true;
+            data += n;
+            len -= n;
+            if (directLen_ == kDirectBufferSize)
+            {
+                writeDirect();
+            }
+        }
+    }
 
-    size_t write(const char* logline, size_t len)
+    // 按块对齐写出缓冲区, 最后一块不完整时以0补齐, 并留在缓冲区中下次连同新数据一起重写
+    // 补齐的0随即截断掉, 文件长度始终等于已写入的日志长度
+    void writeDirect()
     {
-#undef fwrite_unlocked
-        return ::fwrite_unlocked(logline, 1, len, fp_); // 不加锁的方式写入
+        if (!directDirty_)
+        {
+            return;
+        }
+        directDirty_ = false;
+        size_t full = directLen_ & ~(kDirectAlign - 1);
+        size_t len = (directLen_ + kDirectAlign - 1) & ~(kDirectAlign - 1);
+        memset(directBuf_ + directLen_, 0, len - directLen_);
+        size_t done = 0;
+        while (done < len)
+        {
+            ssize_t n = ::pwrite(fd_, directBuf_ + done, len - done, directOffset_ + static_cast<off_t>(done));
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (n <= 0)
+            {
+                fprintf(stderr, "LogFile::File::writeDirect() failed %s\n", strerror_tl(errno));
+                break;
+            }
+            done += static_cast<size_t>(n);
+        }
+        if (len > directLen_
+            && ::ftruncate(fd_, directOffset_ + static_cast<off_t>(directLen_)) < 0)
+        {
+            fprintf(stderr, "LogFile::File::writeDirect() ftruncate failed %s\n", strerror_tl(errno));
+        }
+        memmove(directBuf_, directBuf_ + full, directLen_ - full);
+        directOffset_ += static_cast<off_t>(full);
+        directLen_ -= full;
     }
 
-    FILE* fp_;                  // 文件指针
+    WriteMode mode_;
+    FILE* fp_;                  // 文件指针, kStdio
+    int fd_;                    // kWritev, kDirect
+    char* directBuf_;           // kDirect的对齐缓冲区
+    size_t directLen_;          // directBuf_中的数据长度
+    off_t directOffset_;        // directBuf_[0]在文件中的偏移, 块对齐
+    bool directDirty_;          // directBuf_中有未写出的数据
     char buffer_[64 * 1024];    // 文件指针缓冲区
     size_t writtenBytes_;       // 已经写入的字节数
 };
@@ -73,15 +305,19 @@ private:
 LogFile::LogFile(const string& basename,
                  size_t rollSize,
                  bool threadSafe,
-                 int flushInterval)
+                 int flushInterval,
+                 WriteMode mode)
     : basename_(basename),
     rollSize_(rollSize),
     flushInterval_(flushInterval),
+    mode_(mode),
+    syncInterval_(0),
     count_(0),
     mutex_(threadSafe ? new MutexLock : NULL),
     startOfPeriod_(0),
     lastRoll_(0),
-    lastFlush_(0)
+    lastFlush_(0),
+    lastSync_(0)
 {
     assert(basename.find('/') == string::npos);
     rollFile();         // 这里调用实际是为了产生文件
@@ -104,16 +340,83 @@ void LogFile::append(const char* logline, int len)
     }
 }
 
+void LogFile::setHeaderCallback(const HeaderCallback& cb)
+{
+    if (mutex_)
+    {
+        MutexLockGuard lock(*mutex_);
+        headerCallback_ = cb;
+        writeHeader();
+    }
+    else
+    {
+        headerCallback_ = cb;
+        writeHeader();
+    }
+}
+
+void LogFile::writeHeader()
+{
+    if (headerCallback_ && file_->writtenBytes() == 0)
+    {
+        string header = headerCallback_();
+        file_->append(header.data(), header.size());
+    }
+}
+
+void LogFile::appendv(const struct iovec* iov, int iovcnt)
+{
+    if (mutex_)
+    {
+        MutexLockGuard lock(*mutex_);
+        appendv_unlocked(iov, iovcnt);
+    }
+    else
+    {
+        appendv_unlocked(iov, iovcnt);
+    }
+}
+
 void LogFile::flush()
 {
     if (mutex_)
     {
         MutexLockGuard lock(*mutex_);
-        file_->flush();
+        flush_unlocked();
+    }
+    else
+    {
+        flush_unlocked();
+    }
+}
+
+void LogFile::flush_unlocked()
+{
+    if (syncInterval_ > 0)
+    {
+        time_t now = ::time(NULL);
+        if (now - lastSync_ >= syncInterval_)
+        {
+            lastSync_ = now;
+            file_->sync();
+            return;
+        }
+    }
+    file_->flush();
+}
+
+void LogFile::appendv_unlocked(const struct iovec* iov, int iovcnt)
+{
+    file_->appendv(iov, iovcnt);
+
+    if (file_->writtenBytes() > rollSize_)
+    {
+        rollFile();
     }
     else
     {
-        file_->flush();
+        count_ = 0;
+        checkPeriod(::time(NULL));      // appendv每次写一批, 不必按次数抽查时间
     }
 }
 
@@ -130,17 +433,7 @@ void LogFile::append_unlocked(const char* logline, int len)
         if (count_ > kCheckTimeRoll_)
         {
             count_ = 0;
-            time_t now = ::time(NULL);
-            time_t thisPeriod_ = now / kRollPerSeconds_ * kRollPerSeconds_; // 当前时间取整
-            if (thisPeriod_ != startOfPeriod_)                              // 到达第二天时间
-            {
-                rollFile();         // 第二天滚动日志
-            }
-            else if (now - lastFlush_ > flushInterval_) // 到达间隔时间进行flush
-            {
-                lastFlush_ = now;
-                file_->flush();
-            }
+            checkPeriod(::time(NULL));
         }
         else
         {
@@ -149,6 +442,20 @@ void LogFile::append_unlocked(const char* logline, int len)
     }
 }
 
+void LogFile::checkPeriod(time_t now)
+{
+    time_t thisPeriod_ = now / kRollPerSeconds_ * kRollPerSeconds_; // 当前时间取整
+    if (thisPeriod_ != startOfPeriod_)                              // 到达第二天时间
+    {
+        rollFile();         // 第二天滚动日志
+    }
+    else if (now - lastFlush_ > flushInterval_) // 到达间隔时间进行flush
+    {
+        lastFlush_ = now;
+        flush_unlocked();
+    }
+}
+
 void LogFile::rollFile()
 {
     time_t now = 0;
@@ -162,7 +469,8 @@ void LogFile::rollFile()
         lastRoll_ = now;
         lastFlush_ = now;
         startOfPeriod_ = start;
-        file_.reset(new File(filename));    // 创建新的文件
+        file_.reset(new File(filename, mode_));    // 创建新的文件
+        writeHeader();
     }
 }
 
@@ -4,26 +4,54 @@
 #include <muduo/base/Mutex.h>
 #include <muduo/base/Types.h>
 
+#include <boost/function.hpp>
 #include <boost/noncopyable.hpp>
 #include <boost/scoped_ptr.hpp>
 
+struct iovec;
+
 namespace muduo
 {
 // 可以实现线程安全的添加日志, 多个线程使用同一个对象进行添加
 class LogFile : boost::noncopyable
 {
 public:
+    typedef boost::function<string()> HeaderCallback;
+
+    enum WriteMode
+    {
+        kStdio,         // 经过64KB的stdio缓冲区, 默认
+        kWritev,        // 不经stdio, appendv一次writev写入
+        kDirect,        // O_DIRECT, 经对齐缓冲区绕过page cache, 文件系统不支持时退回kWritev
+                        // 不完整的最后一块补0写出后立即截断到实际长度, 只有两次调用之间崩溃才会在文件尾留下0
+    };
+
     LogFile(const string& basename,
             size_t rollSize,
             bool threadSafe = true,     // 默认线程安全
-            int flushInterval = 3);
+            int flushInterval = 3,
+            WriteMode mode = kStdio);
     ~LogFile();
 
     void append(const char* logline, int len);  // 将len长的logline字符添加到日志中
+    /// Appends all buffers, with one writev(2) unless in kStdio mode.
+    void appendv(const struct iovec* iov, int iovcnt);
     void flush();                               // 刷新到文件中
 
+    /// flush() also calls fdatasync(2) if @c seconds passed since the last
+    /// one. 0 never syncs, which is the default.
+    void setSyncInterval(int seconds) { syncInterval_ = seconds; }
+
+    /// The returned bytes are written at the start of every new file,
+    /// e.g. BinaryLog::siteTable. Also written to the current file if empty.
+    void setHeaderCallback(const HeaderCallback& cb);
+
 private:
     void append_unlocked(const char* logline, int len); // 不加锁的方式添加
+    void appendv_unlocked(const struct iovec* iov, int iovcnt);
+    void flush_unlocked();
+    void checkPeriod(time_t now);   // 到达第二天滚动日志, 到达间隔时间flush
+    void writeHeader();
 
     static string getLogFileName(const string& basename, time_t* now);  // 获取日志文件的名称
     void rollFile();            // 滚动日志
@@ -31,6 +59,9 @@ private:
     const string basename_;     // 日志文件basename
     const size_t rollSize_;     // 日志文件达到rolSize_换一个新文件
     const int flushInterval_;   // 日志写入间隔时间
+    const WriteMode mode_;
+    int syncInterval_;          // fdatasync间隔, 0表示不调用
+    HeaderCallback headerCallback_; // 每个新文件开头写入的内容
 
     int count_;                 // 计数器, 初始值为0, 达到kCheckTimeRoll_是否换一个新的日志, 或者达到roolSize_
 
@@ -38,6 +69,7 @@ private:
     time_t startOfPeriod_;      // 开始记录日志时间（调整至零点的时间, 方便下一次日志滚动）
     time_t lastRoll_;           // 上一次滚动日志文件时间
     time_t lastFlush_;          // 上一次日志写入文件时间
+    time_t lastSync_;           // 上一次fdatasync时间
     class File;                 // 前向声明
     boost::scoped_ptr<File> file_;  // 智能指针
 
@@ -4,6 +4,7 @@
 #include <limits>
 #include <boost/static_assert.hpp>
 #include <boost/type_traits/is_arithmetic.hpp>
+#include <boost/type_traits/make_unsigned.hpp>
 #include <assert.h>
 #include <string.h>
 #include <stdint.h>
@@ -25,31 +26,73 @@ const char digits[] = "9876543210123456789";
 const char* zero = digits + 9;              // 指向digits+9位置, 即0位置
 BOOST_STATIC_ASSERT(sizeof(digits) == 20);
 
+const char digitPairs[] =                   // 00~99, 每次查表输出两位
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+BOOST_STATIC_ASSERT(sizeof digitPairs == 201);
+
 const char digitsHex[] = "0123456789ABCDEF";
 BOOST_STATIC_ASSERT(sizeof digitsHex == 17);
 
-// Efficient Integer to String Conversions, by Matthew Wilson.
-template<typename T>
-size_t convert(char buf[], T value)         // 通过digits指向位置来转换字符串
+template<typename U>
+int countDigits(U v)                        // 十进制位数, 每轮比较四次才做一次除法
 {
-    T i = value;
-    char* p = buf;  // 指针指向buf
-
-    do
+    int n = 1;
+    for (;;)
     {
-        int lsd = static_cast<int>(i % 10);                             // 得到最后一个数字 
-        i /= 10;
-        *p++ = zero[lsd];                                               // zero指针指向0位置
-    } while (i != 0);
+        if (v < 10) return n;
+        if (v < 100) return n + 1;
+        if (v < 1000) return n + 2;
+        if (v < 10000) return n + 3;
+        v /= 10000u;
+        n += 4;
+    }
+}
 
+// Efficient Integer to String Conversions, by Matthew Wilson.
+// 先算出位数, 再从末尾每次写两位, 省去逐位除法和最后的reverse
+template<typename T>
+size_t convert(char buf[], T value)
+{
+    typedef typename boost::make_unsigned<T>::type U;
+    // 在无符号类型上取绝对值, 最小负数也不会溢出
+    U i = value < 0 ? static_cast<U>(0 - static_cast<U>(value)) : static_cast<U>(value);
+    char* p = buf;
     if (value < 0)
     {
         *p++ = '-';
     }
-    *p = '\0';
-    std::reverse(buf, p);                                             // 负数字符串逆转, 左闭右开逆序规则, 即p指向的'\0'字符不被包含在逆序的范围内
+    p += countDigits(i);
+    char* end = p;
+    *end = '\0';
+
+    while (i >= 100)
+    {
+        unsigned idx = static_cast<unsigned>(i % 100) * 2;
+        i /= 100;
+        *--p = digitPairs[idx + 1];
+        *--p = digitPairs[idx];
+    }
+    if (i >= 10)
+    {
+        unsigned idx = static_cast<unsigned>(i) * 2;
+        *--p = digitPairs[idx + 1];
+        *--p = digitPairs[idx];
+    }
+    else
+    {
+        *--p = zero[i];
+    }
 
-    return p - buf;                                                   // 转换字符数
+    return end - buf;
 }
 
 // uintptr_t对于32位平台来说就是unsigned int
@@ -72,6 +115,305 @@ size_t convertHex(char buf[], uintptr_t value)  // 通过digitsHex指向位置
     return p - buf;
 }
 
+// Printing Floating-Point Numbers Quickly and Accurately with Integers,
+// by Florian Loitsch. 下面是其中的Grisu2, 写法参考Milo Yip的dtoa.
+// 输出的数字串总能被strtod读回同一个值, 绝大多数情况下也是最短的.
+
+struct DiyFp                                // f * 2^e, 64位尾数的"手工"浮点数
+{
+    DiyFp(uint64_t f_, int e_) : f(f_), e(e_) { }
+
+    DiyFp operator-(const DiyFp& rhs) const { return DiyFp(f - rhs.f, e); }
+
+    DiyFp operator*(const DiyFp& rhs) const    // 只保留乘积的高64位, 并四舍五入
+    {
+        unsigned __int128 p = static_cast<unsigned __int128>(f) * rhs.f;
+        uint64_t h = static_cast<uint64_t>(p >> 64);
+        uint64_t l = static_cast<uint64_t>(p);
+        h += l >> 63;
+        return DiyFp(h, e + rhs.e + 64);
+    }
+
+    DiyFp normalize() const                     // 左移到最高位为1
+    {
+        int s = __builtin_clzll(f);
+        return DiyFp(f << s, e - s);
+    }
+
+    uint64_t f;
+    int e;
+};
+
+// 10^k的近似值, k = -348, -340, ..., 340
+const uint64_t kCachedPowersF[] =
+{
+    0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL,
+    0xcf42894a5dce35eaULL, 0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL,
+    0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL, 0xbe5691ef416bd60cULL,
+    0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+    0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL,
+    0xc21094364dfb5637ULL, 0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL,
+    0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL, 0xb23867fb2a35b28eULL,
+    0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+    0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL,
+    0xb5b5ada8aaff80b8ULL, 0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL,
+    0x964e858c91ba2655ULL, 0xdff9772470297ebdULL, 0xa6dfbd9fb8e5b88fULL,
+    0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+    0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL,
+    0xaa242499697392d3ULL, 0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL,
+    0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL, 0x9c40000000000000ULL,
+    0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+    0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL,
+    0x9f4f2726179a2245ULL, 0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL,
+    0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL, 0x924d692ca61be758ULL,
+    0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+    0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL,
+    0x952ab45cfa97a0b3ULL, 0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL,
+    0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL, 0x88fcf317f22241e2ULL,
+    0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+    0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL,
+    0x8bab8eefb6409c1aULL, 0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL,
+    0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL, 0x80444b5e7aa7cf85ULL,
+    0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+    0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL,
+};
+
+const int16_t kCachedPowersE[] =
+{
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+    -954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+    -688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+    -422, -396, -369, -343, -316, -289, -263, -236, -210, -183,
+    -157, -130, -103, -77, -50, -24, 3, 30, 56, 83,
+    109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614,
+    641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+    907, 933, 960, 986, 1013, 1039, 1066,
+};
+
+// 选取10^-K, 使 w * 10^-K 的二进制指数落在[-60, -32]
+DiyFp getCachedPower(int e, int* K)
+{
+    double dk = (-61 - e) * 0.30102999566398114 + 347;  // log10(2)
+    int k = static_cast<int>(dk);
+    if (dk - k > 0.0)
+    {
+        ++k;
+    }
+    unsigned index = static_cast<unsigned>((k >> 3) + 1);
+    *K = -(-348 + static_cast<int>(index << 3));
+    return DiyFp(kCachedPowersF[index], kCachedPowersE[index]);
+}
+
+const uint64_t kPow10[] =
+{
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+    10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+    100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+    100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+    100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+};
+
+// 在允许的误差内把最后一位往真实值靠近
+void grisuRound(char* buffer, int len, uint64_t delta, uint64_t rest, uint64_t tenKappa, uint64_t distance)
+{
+    while (rest < distance && delta - rest >= tenKappa &&
+           (rest + tenKappa < distance || distance - rest > rest + tenKappa - distance))
+    {
+        buffer[len - 1]--;
+        rest += tenKappa;
+    }
+}
+
+// 生成 Mp 的数字, 直到剩余部分落在 [Mp - delta, Mp] 之内
+void digitGen(const DiyFp& W, const DiyFp& Mp, uint64_t delta, char* buffer, int* len, int* K)
+{
+    const DiyFp one(1ULL << -Mp.e, Mp.e);
+    const DiyFp distance = Mp - W;
+    uint32_t p1 = static_cast<uint32_t>(Mp.f >> -one.e);   // 整数部分
+    uint64_t p2 = Mp.f & (one.f - 1);                       // 小数部分
+    int kappa = countDigits(p1);
+    *len = 0;
+
+    while (kappa > 0)
+    {
+        uint32_t d = 0;
+        switch (kappa)                          // 常量除数, 编译器会换成乘法
+        {
+            case 10: d = p1 / 1000000000; p1 %= 1000000000; break;
+            case  9: d = p1 /  100000000; p1 %=  100000000; break;
+            case  8: d = p1 /   10000000; p1 %=   10000000; break;
+            case  7: d = p1 /    1000000; p1 %=    1000000; break;
+            case  6: d = p1 /     100000; p1 %=     100000; break;
+            case  5: d = p1 /      10000; p1 %=      10000; break;
+            case  4: d = p1 /       1000; p1 %=       1000; break;
+            case  3: d = p1 /        100; p1 %=        100; break;
+            case  2: d = p1 /         10; p1 %=         10; break;
+            case  1: d = p1;              p1 =           0; break;
+        }
+        if (d || *len)
+        {
+            buffer[(*len)++] = static_cast<char>('0' + d);
+        }
+        --kappa;
+        uint64_t rest = (static_cast<uint64_t>(p1) << -one.e) + p2;
+        if (rest <= delta)
+        {
+            *K += kappa;
+            grisuRound(buffer, *len, delta, rest, kPow10[kappa] << -one.e, distance.f);
+            return;
+        }
+    }
+
+    for (;;)
+    {
+        p2 *= 10;
+        delta *= 10;
+        char d = static_cast<char>(p2 >> -one.e);
+        if (d || *len)
+        {
+            buffer[(*len)++] = static_cast<char>('0' + d);
+        }
+        p2 &= one.f - 1;
+        --kappa;
+        if (p2 < delta)
+        {
+            *K += kappa;
+            int index = -kappa;
+            grisuRound(buffer, *len, delta, p2, one.f, distance.f * (index < 20 ? kPow10[index] : 0));
+            return;
+        }
+    }
+}
+
+// value = f * 2^e (f != 0), 相邻两个可表示值的中点之间的任何数都会被读回value
+// lowerCloser: f是2的幂时下方的间隔只有上方的一半
+// 输出 buffer[0, len) * 10^K
+void grisu2(uint64_t f, int e, bool lowerCloser, char* buffer, int* len, int* K)
+{
+    DiyFp plus = DiyFp((f << 1) + 1, e - 1).normalize();
+    DiyFp minus = lowerCloser ? DiyFp((f << 2) - 1, e - 2) : DiyFp((f << 1) - 1, e - 1);
+    minus.f <<= minus.e - plus.e;
+    minus.e = plus.e;
+
+    const DiyFp cached = getCachedPower(plus.e, K);
+    const DiyFp W = DiyFp(f, e).normalize() * cached;
+    DiyFp Wp = plus * cached;
+    DiyFp Wm = minus * cached;
+    Wm.f++;                                     // 乘法有至多1ulp的误差, 向内收缩
+    Wp.f--;
+    digitGen(W, Wp, Wp.f - Wm.f, buffer, len, K);
+}
+
+// 与"%.17g"相同的排版: 十进制指数在[-4, 17)之间用定点表示, 否则用科学计数法
+size_t prettify(char* buf, const char* digitBuf, int len, int K)
+{
+    char* p = buf;
+    const int point = len + K;                  // 小数点位于第point个数字之后
+    if (point > 0 && point <= 17)
+    {
+        if (point >= len)                       // 1234e7 -> 12340000000
+        {
+            memcpy(p, digitBuf, len);
+            memset(p + len, '0', point - len);
+            p += point;
+        }
+        else                                    // 1234e-2 -> 12.34
+        {
+            memcpy(p, digitBuf, point);
+            p[point] = '.';
+            memcpy(p + point + 1, digitBuf + point, len - point);
+            p += len + 1;
+        }
+    }
+    else if (point > -4 && point <= 0)          // 1234e-6 -> 0.001234
+    {
+        *p++ = '0';
+        *p++ = '.';
+        memset(p, '0', -point);
+        p += -point;
+        memcpy(p, digitBuf, len);
+        p += len;
+    }
+    else                                        // 1234e30 -> 1.234e+33
+    {
+        *p++ = digitBuf[0];
+        if (len > 1)
+        {
+            *p++ = '.';
+            memcpy(p, digitBuf + 1, len - 1);
+            p += len - 1;
+        }
+        int exp = point - 1;
+        *p++ = 'e';
+        *p++ = exp < 0 ? '-' : '+';
+        unsigned absExp = static_cast<unsigned>(exp < 0 ? -exp : exp);
+        if (absExp >= 100)
+        {
+            *p++ = static_cast<char>('0' + absExp / 100);
+            absExp %= 100;
+        }
+        *p++ = digitPairs[absExp * 2];
+        *p++ = digitPairs[absExp * 2 + 1];
+    }
+    *p = '\0';
+    return p - buf;
+}
+
+// 尾数位数为kSignificandBits的IEEE754数, bits为其位模式
+template<int kSignificandBits, int kExponentBits>
+size_t formatShortest(char buf[], uint64_t bits)
+{
+    const uint64_t kSignificandMask = (1ULL << kSignificandBits) - 1;
+    const int kExponentMax = (1 << kExponentBits) - 1;
+    const int kExponentBias = (kExponentMax >> 1) + kSignificandBits;
+
+    char* p = buf;
+    if (bits >> (kSignificandBits + kExponentBits))  // 符号位, 与printf一样保留-0和-nan的负号
+    {
+        *p++ = '-';
+    }
+    uint64_t significand = bits & kSignificandMask;
+    int biased = static_cast<int>((bits >> kSignificandBits) & kExponentMax);
+    if (biased == kExponentMax)
+    {
+        memcpy(p, significand ? "nan" : "inf", 4);
+        return p + 3 - buf;
+    }
+    if (biased == 0 && significand == 0)
+    {
+        memcpy(p, "0", 2);
+        return p + 1 - buf;
+    }
+
+    uint64_t f = significand;
+    int e = 1 - kExponentBias;                  // 非规格化数
+    if (biased != 0)
+    {
+        f += 1ULL << kSignificandBits;
+        e = biased - kExponentBias;
+    }
+    char digitBuf[24];
+    int len = 0;
+    int K = 0;
+    grisu2(f, e, significand == 0 && biased > 1, digitBuf, &len, &K);
+    return p - buf + prettify(p, digitBuf, len, K);
+}
+
+size_t formatDouble(char buf[], double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof bits);
+    return formatShortest<52, 11>(buf, bits);
+}
+
+size_t formatFloat(char buf[], float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof bits);
+    return formatShortest<23, 8>(buf, bits);
+}
+
 }   // namespace detail
 
 }   // namespace muduo
@@ -176,12 +518,22 @@ LogStream& LogStream::operator<<(const void* p)
     return *this;
 }
 
-// FIXME: replace this with Grisu3 by Florian Loitsch.
+// 最短的能读回原值的数字串, 而非固定12位有效数字
+LogStream& LogStream::operator<<(float v)
+{
+    if (buffer_.avail() >= kMaxNumericSize)
+    {
+        size_t len = formatFloat(buffer_.current(), v);
+        buffer_.add(len);
+    }
+    return *this;
+}
+
 LogStream& LogStream::operator<<(double v)
 {
     if (buffer_.avail() >= kMaxNumericSize)
     {
-        int len = snprintf(buffer_.current(), kMaxNumericSize, "%.12g", v);
+        size_t len = formatDouble(buffer_.current(), v);
         buffer_.add(len);
     }
     return *this;
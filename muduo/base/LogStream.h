@@ -101,11 +101,7 @@ public:
 
     self& operator<<(const void*);  // 指针转换成十六进制地址存放进去
 
-    self& operator<<(float v)
-    {
-        *this << static_cast<double>(v);
-        return *this;
-    }
+    self& operator<<(float);
     self& operator<<(double);
     // self& operator<<(long double);
 
@@ -1,5 +1,6 @@
 ﻿#include <muduo/base/Logging.h>
 
+#include <muduo/base/CoarseClock.h>
 #include <muduo/base/CurrentThread.h>
 #include <muduo/base/StringPiece.h>
 #include <muduo/base/Timestamp.h>
@@ -33,6 +34,8 @@ const char* basename_;
 __thread char t_errnobuf[512];  // 错误字符串缓存
 __thread char t_time[32];       // 时间缓存
 __thread time_t t_lastSecond;   // 存储从1970年到现在经过了多少秒, 应该是某个整型变量
+__thread int t_timeZoneGeneration;  // t_time按哪一次设置的时区渲染
+int g_timeZoneGeneration = 0;       // 每次Logger::setTimeZone加一
 
 const char* strerror_tl(int savedErrno)
 {
@@ -131,22 +134,35 @@ Logger::Impl::Impl(LogLevel level, int savedErrno, const SourceFile& file, int l
 void Logger::Impl::formatTime()
 {
     int64_t microSecondsSinceEpoch = time_.microSecondsSinceEpoch();
-    time_t  seconds = static_cast<time_t>(microSecondsSinceEpoch / 1000000);
-    int     microseconds = static_cast<int>(microSecondsSinceEpoch % 1000000);
-    if (seconds != t_lastSecond)
+    time_t  seconds = static_cast<time_t>(microSecondsSinceEpoch / Timestamp::kMicroSecondsPerSecond);
+    int     microseconds = static_cast<int>(microSecondsSinceEpoch % Timestamp::kMicroSecondsPerSecond);
+    const TimeZone& tz = CoarseClock::timeZone();
+    int generation = __atomic_load_n(&g_timeZoneGeneration, __ATOMIC_RELAXED);
+    if (seconds != t_lastSecond || generation != t_timeZoneGeneration)
     {
         t_lastSecond = seconds;
-        struct tm tm_time;
-        ::gmtime_r(&seconds, &tm_time); // FIXME TimeZone::fromUtcTime
-
-        int len = snprintf(t_time, sizeof(t_time), "%4d%02d%02d %02d:%02d:%02d",
-                           tm_time.tm_year + 1900, tm_time.tm_mon + 1, tm_time.tm_mday,
-                           tm_time.tm_hour, tm_time.tm_min, tm_time.tm_sec);
-        assert(len == 17); (void)len;
+        t_timeZoneGeneration = generation;
+        // 事件循环每次poll后都渲染好了当前这一秒, 多数线程直接拷贝
+        if (!CoarseClock::formatLocal(seconds, t_time))
+        {
+            struct tm tm_time = tz.valid() ? tz.toLocalTime(seconds) : TimeZone::toUtcTime(seconds);
+            CoarseClock::formatSecond(tm_time, t_time);
+        }
+    }
+    char us[] = ".000000Z ";            // 同Fmt(".%06dZ ", microseconds), 本地时间不带Z
+    for (int i = 6; i > 0; --i)
+    {
+        us[i] = static_cast<char>('0' + microseconds % 10);
+        microseconds /= 10;
+    }
+    unsigned len = 9;
+    if (tz.valid())
+    {
+        us[7] = ' ';
+        us[8] = '\0';
+        len = 8;
     }
-    Fmt us(".%06dZ ", microseconds);    // 微秒格式化类
-    assert(us.length() == 9);
-    stream_ << T(t_time, 17) << T(us.data(), 9);
+    stream_ << T(t_time, 17) << T(us, len);
 }
 
 void Logger::Impl::finish()
@@ -200,4 +216,10 @@ void Logger::setOutput(OutputFunc out)
 void Logger::setFlush(FlushFunc flush)
 {
     g_flush = flush;
+}
+
+void Logger::setTimeZone(const TimeZone& tz)
+{
+    CoarseClock::setTimeZone(tz);
+    __atomic_add_fetch(&g_timeZoneGeneration, 1, __ATOMIC_RELAXED);
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include <muduo/base/LogStream.h>
 #include <muduo/base/Timestamp.h>
+#include <muduo/base/TimeZone.h>
 
 namespace muduo
 {
@@ -69,6 +70,7 @@ public:
 
     static void setOutput(OutputFunc);  // 更改输出函数
     static void setFlush(FlushFunc);    // 更改刷新函数
+    static void setTimeZone(const TimeZone& tz);    // 日志时间按该时区输出, 默认UTC(带Z后缀)
 
 private:
     class Impl      // Logger类内部嵌套类, 负责具体字符串格式化
@@ -0,0 +1,210 @@
+﻿#ifndef MUDUO_BASE_MPMCBLOCKINGQUEUE_H
+#define MUDUO_BASE_MPMCBLOCKINGQUEUE_H
+
+#include <muduo/base/Futex.h>
+
+#include <boost/noncopyable.hpp>
+#include <assert.h>
+#include <stddef.h>
+
+/*
+    多生产者多消费者有界环形队列(Dmitry Vyukov的bounded MPMC queue)
+    每个槽带一个序号, 生产者/消费者各自CAS抢占下标后只访问自己的槽
+    序号表明槽是否可写(等于下标)或可读(等于下标+1)
+    只有在队列满/空并自旋无果后才通过futex睡眠
+*/
+
+namespace muduo
+{
+
+template<typename T>
+class MpmcBlockingQueue : boost::noncopyable
+{
+public:
+    /// @c maxSize is rounded up to a power of 2, and at least 2:
+    /// with a single cell, sequence+1 of a full slot equals the next
+    /// round's enqueue position, so a full queue would look writable.
+    explicit MpmcBlockingQueue(size_t maxSize)
+        : capacity_(roundUp(maxSize)),
+        mask_(capacity_ - 1),
+        cells_(new Cell[capacity_]),
+        enqueuePos_(0),
+        dequeuePos_(0)
+    {
+        for (size_t i = 0; i < capacity_; ++i)
+        {
+            cells_[i].sequence = i;
+        }
+    }
+
+    ~MpmcBlockingQueue()
+    {
+        delete[] cells_;
+    }
+
+    /// Thread safe, returns false if full.
+    bool tryPut(const T& x)
+    {
+        size_t pos = __atomic_load_n(&enqueuePos_, __ATOMIC_RELAXED);
+        Cell* cell;
+        for (;;)
+        {
+            cell = &cells_[pos & mask_];
+            size_t seq = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+            ptrdiff_t diff = static_cast<ptrdiff_t>(seq - pos);
+            if (diff == 0)              // 槽可写, 抢占下标
+            {
+                if (__atomic_compare_exchange_n(&enqueuePos_, &pos, pos + 1, true,
+                                                __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)          // 槽中仍是上一圈未取走的数据, 队列已满
+            {
+                return false;
+            }
+            else                        // 被其他生产者抢先
+            {
+                pos = __atomic_load_n(&enqueuePos_, __ATOMIC_RELAXED);
+            }
+        }
+        cell->value = x;
+        __atomic_store_n(&cell->sequence, pos + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    /// Thread safe, returns false if empty.
+    bool tryTake(T* x)
+    {
+        size_t pos = __atomic_load_n(&dequeuePos_, __ATOMIC_RELAXED);
+        Cell* cell;
+        for (;;)
+        {
+            cell = &cells_[pos & mask_];
+            size_t seq = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+            ptrdiff_t diff = static_cast<ptrdiff_t>(seq - (pos + 1));
+            if (diff == 0)              // 槽可读, 抢占下标
+            {
+                if (__atomic_compare_exchange_n(&dequeuePos_, &pos, pos + 1, true,
+                                                __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)          // 槽尚未写入, 队列为空
+            {
+                return false;
+            }
+            else                        // 被其他消费者抢先
+            {
+                pos = __atomic_load_n(&dequeuePos_, __ATOMIC_RELAXED);
+            }
+        }
+        *x = cell->value;
+        __atomic_store_n(&cell->sequence, pos + mask_ + 1, __ATOMIC_RELEASE);  // 留给下一圈的生产者
+        return true;
+    }
+
+    void put(const T& x)        // 满时阻塞
+    {
+        while (!tryPutSpin(x))
+        {
+            int key = notFull_.prepareWait();
+            if (tryPut(x))
+            {
+                notFull_.cancelWait();
+                break;
+            }
+            notFull_.wait(key);
+        }
+        notEmpty_.notify();
+    }
+
+    T take()                    // 空时阻塞
+    {
+        T x;
+        while (!tryTakeSpin(&x))
+        {
+            int key = notEmpty_.prepareWait();
+            if (tryTake(&x))
+            {
+                notEmpty_.cancelWait();
+                break;
+            }
+            notEmpty_.wait(key);
+        }
+        notFull_.notify();
+        return x;
+    }
+
+    /// Approximate when called concurrently.
+    size_t size() const
+    {
+        size_t tail = __atomic_load_n(&enqueuePos_, __ATOMIC_ACQUIRE);
+        size_t head = __atomic_load_n(&dequeuePos_, __ATOMIC_ACQUIRE);
+        return tail > head ? tail - head : 0;
+    }
+
+    size_t capacity() const { return capacity_; }
+
+private:
+    static const int kSpins = 64;       // 睡眠前重试的次数
+
+    struct Cell
+    {
+        size_t sequence;
+        T value;
+    };
+
+    static size_t roundUp(size_t n)
+    {
+        size_t c = 2;
+        while (c < n)
+        {
+            c <<= 1;
+        }
+        return c;
+    }
+
+    bool tryPutSpin(const T& x)
+    {
+        for (int i = 0; i < kSpins; ++i)
+        {
+            if (tryPut(x))
+            {
+                return true;
+            }
+            detail::cpuRelax();
+        }
+        return false;
+    }
+
+    bool tryTakeSpin(T* x)
+    {
+        for (int i = 0; i < kSpins; ++i)
+        {
+            if (tryTake(x))
+            {
+                return true;
+            }
+            detail::cpuRelax();
+        }
+        return false;
+    }
+
+    const size_t capacity_;
+    const size_t mask_;
+    Cell* const cells_;
+    char pad0_[64];
+    size_t enqueuePos_;     // 生产者之间CAS竞争
+    char pad1_[64 - sizeof(size_t)];
+    size_t dequeuePos_;     // 消费者之间CAS竞争
+    char pad2_[64 - sizeof(size_t)];
+    detail::FutexEvent notEmpty_;
+    detail::FutexEvent notFull_;
+};
+
+}       // namespace muduo
+
+#endif  // MUDUO_BASE_MPMCBLOCKINGQUEUE_H
\ No newline at end of file
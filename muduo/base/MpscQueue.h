@@ -0,0 +1,181 @@
+﻿#ifndef MUDUO_BASE_MPSCQUEUE_H
+#define MUDUO_BASE_MPSCQUEUE_H
+
+#include <boost/noncopyable.hpp>
+
+#include <algorithm>
+#include <assert.h>
+
+/*
+    无锁多生产者单消费者队列(Dmitry Vyukov的intrusive MPSC node-based queue)
+    生产者只做一次原子交换, 不会互相阻塞; 消费者只在一个线程中取数据
+    队列中的节点由一个哑节点(stub_)作为起点, 消费者总是保留最后一个节点
+    取出的节点由消费者放回空闲栈(freeList_), 生产者优先从中复用, 稳定后put()不再分配节点
+    多个生产者同时出栈会有ABA问题, 因此出栈由popping_标志互斥; 抢不到标志的生产者直接new, 仍然不会互相等待
+*/
+
+namespace muduo
+{
+
+template<typename T>
+class MpscQueue : boost::noncopyable
+{
+public:
+    MpscQueue()
+        : head_(&stub_),
+        tail_(&stub_),
+        freeList_(NULL),
+        freeCount_(0),
+        popping_(0)
+    {
+        stub_.next = NULL;
+    }
+
+    ~MpscQueue()
+    {
+        T x;
+        while (take(&x))
+        {
+        }
+        while (freeList_)
+        {
+            Node* node = freeList_;
+            freeList_ = node->next;
+            delete node;
+        }
+    }
+
+    /// Safe to call from multiple threads.
+    /// Reuses a node recycled by take() when one is available.
+    void put(const T& x)
+    {
+        Node* node = allocate();
+        if (node)
+        {
+            node->value = x;
+        }
+        else
+        {
+            node = new Node(x);
+        }
+        push(node);
+    }
+
+    /// Must be called from the single consumer thread.
+    /// Returns false if empty, or if a producer is in the middle of put().
+    /// The element will be visible to a later take() in that case.
+    bool take(T* x)
+    {
+        Node* tail = tail_;
+        Node* next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+        if (tail == &stub_)             // 跳过哑节点
+        {
+            if (next == NULL)
+            {
+                return false;
+            }
+            tail_ = next;
+            tail = next;
+            next = __atomic_load_n(&next->next, __ATOMIC_ACQUIRE);
+        }
+        if (next)
+        {
+            tail_ = next;
+            return release(tail, x);
+        }
+        Node* head = __atomic_load_n(&head_, __ATOMIC_ACQUIRE);
+        if (tail != head)               // 生产者已交换head_, 但还未链接next
+        {
+            return false;
+        }
+        push(&stub_);                   // tail是最后一个节点, 放回哑节点以便取出tail
+        next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+        if (next)
+        {
+            tail_ = next;
+            return release(tail, x);
+        }
+        return false;
+    }
+
+private:
+    static const int kMaxFreeNodes = 1024;  // 空闲栈上限, 超出的节点直接释放
+
+    struct Node
+    {
+        Node() : next(NULL), value() {}
+        explicit Node(const T& x) : next(NULL), value(x) {}
+
+        Node* next;
+        T value;
+    };
+
+    void push(Node* node)
+    {
+        __atomic_store_n(&node->next, static_cast<Node*>(NULL), __ATOMIC_RELAXED);
+        Node* prev = __atomic_exchange_n(&head_, node, __ATOMIC_ACQ_REL);   // 生产者之间唯一的同步点
+        __atomic_store_n(&prev->next, node, __ATOMIC_RELEASE);
+    }
+
+    bool release(Node* node, T* x)
+    {
+        assert(node != &stub_);
+        using std::swap;
+        swap(*x, node->value);
+        node->value = T();              // 尽早释放旧值持有的资源
+        recycle(node);
+        return true;
+    }
+
+    // 生产者调用, 抢不到popping_或空闲栈为空时返回NULL
+    Node* allocate()
+    {
+        if (__atomic_exchange_n(&popping_, 1, __ATOMIC_ACQUIRE) != 0)
+        {
+            return NULL;
+        }
+        Node* node = __atomic_load_n(&freeList_, __ATOMIC_ACQUIRE);
+        // 只有持有popping_的线程出栈, 栈顶节点不会被并发取走再放回, 没有ABA
+        while (node
+               && !__atomic_compare_exchange_n(&freeList_, &node,
+                                               __atomic_load_n(&node->next, __ATOMIC_RELAXED), true,
+                                               __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE))
+        {
+        }
+        __atomic_store_n(&popping_, 0, __ATOMIC_RELEASE);
+        if (node)
+        {
+            __atomic_sub_fetch(&freeCount_, 1, __ATOMIC_RELAXED);
+        }
+        return node;
+    }
+
+    // 消费者调用
+    void recycle(Node* node)
+    {
+        if (__atomic_load_n(&freeCount_, __ATOMIC_RELAXED) >= kMaxFreeNodes)
+        {
+            delete node;
+            return;
+        }
+        __atomic_add_fetch(&freeCount_, 1, __ATOMIC_RELAXED);
+        Node* top = __atomic_load_n(&freeList_, __ATOMIC_RELAXED);
+        do
+        {
+            __atomic_store_n(&node->next, top, __ATOMIC_RELAXED);
+        } while (!__atomic_compare_exchange_n(&freeList_, &top, node, true,
+                                              __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    }
+
+    Node* head_;    // 生产者在此追加, 原子操作
+    char pad_[64 - sizeof(Node*)];  // head_与tail_分处不同cache line, 避免伪共享
+    Node* tail_;    // 只由消费者访问
+    Node  stub_;
+    Node* freeList_;    // 消费者入栈, 生产者出栈
+    int   freeCount_;
+    int   popping_;     // 生产者出栈的互斥标志
+};
+
+}       // namespace muduo
+
+#endif  // MUDUO_BASE_MPSCQUEUE_H
\ No newline at end of file
@@ -0,0 +1,169 @@
+﻿#ifndef MUDUO_BASE_SPSCBLOCKINGQUEUE_H
+#define MUDUO_BASE_SPSCBLOCKINGQUEUE_H
+
+#include <muduo/base/Futex.h>
+
+#include <boost/noncopyable.hpp>
+#include <assert.h>
+#include <stddef.h>
+
+/*
+    单生产者单消费者有界环形队列
+    生产者只写tail_, 消费者只写head_, 各自缓存对方的下标, 只在缓存显示满/空时才读对方的cache line
+    只有在队列满/空并自旋无果后才通过futex睡眠
+*/
+
+namespace muduo
+{
+
+template<typename T>
+class SpscBlockingQueue : boost::noncopyable
+{
+public:
+    /// @c maxSize is rounded up to a power of 2.
+    explicit SpscBlockingQueue(size_t maxSize)
+        : capacity_(roundUp(maxSize)),
+        mask_(capacity_ - 1),
+        slots_(new T[capacity_]),
+        head_(0),
+        cachedTail_(0),
+        tail_(0),
+        cachedHead_(0)
+    {
+    }
+
+    ~SpscBlockingQueue()
+    {
+        delete[] slots_;
+    }
+
+    /// Must be called from the single producer thread.
+    bool tryPut(const T& x)
+    {
+        size_t tail = tail_;
+        if (tail - cachedHead_ == capacity_)
+        {
+            cachedHead_ = __atomic_load_n(&head_, __ATOMIC_ACQUIRE);
+            if (tail - cachedHead_ == capacity_)
+            {
+                return false;
+            }
+        }
+        slots_[tail & mask_] = x;
+        __atomic_store_n(&tail_, tail + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    /// Must be called from the single consumer thread.
+    bool tryTake(T* x)
+    {
+        size_t head = head_;
+        if (head == cachedTail_)
+        {
+            cachedTail_ = __atomic_load_n(&tail_, __ATOMIC_ACQUIRE);
+            if (head == cachedTail_)
+            {
+                return false;
+            }
+        }
+        *x = slots_[head & mask_];
+        __atomic_store_n(&head_, head + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    void put(const T& x)        // 满时阻塞
+    {
+        while (!tryPutSpin(x))
+        {
+            int key = notFull_.prepareWait();
+            if (tryPut(x))
+            {
+                notFull_.cancelWait();
+                break;
+            }
+            notFull_.wait(key);
+        }
+        notEmpty_.notify();
+    }
+
+    T take()                    // 空时阻塞
+    {
+        T x;
+        while (!tryTakeSpin(&x))
+        {
+            int key = notEmpty_.prepareWait();
+            if (tryTake(&x))
+            {
+                notEmpty_.cancelWait();
+                break;
+            }
+            notEmpty_.wait(key);
+        }
+        notFull_.notify();
+        return x;
+    }
+
+    /// Approximate when called concurrently.
+    size_t size() const
+    {
+        return __atomic_load_n(&tail_, __ATOMIC_ACQUIRE) - __atomic_load_n(&head_, __ATOMIC_ACQUIRE);
+    }
+
+    size_t capacity() const { return capacity_; }
+
+private:
+    static const int kSpins = 64;       // 睡眠前重试的次数
+
+    static size_t roundUp(size_t n)
+    {
+        size_t c = 1;
+        while (c < n)
+        {
+            c <<= 1;
+        }
+        return c;
+    }
+
+    bool tryPutSpin(const T& x)
+    {
+        for (int i = 0; i < kSpins; ++i)
+        {
+            if (tryPut(x))
+            {
+                return true;
+            }
+            detail::cpuRelax();
+        }
+        return false;
+    }
+
+    bool tryTakeSpin(T* x)
+    {
+        for (int i = 0; i < kSpins; ++i)
+        {
+            if (tryTake(x))
+            {
+                return true;
+            }
+            detail::cpuRelax();
+        }
+        return false;
+    }
+
+    const size_t capacity_;
+    const size_t mask_;
+    T* const slots_;
+    char pad0_[64];
+    size_t head_;           // 消费者下标, 只由消费者写
+    size_t cachedTail_;     // 消费者缓存的tail_
+    char pad1_[64 - 2 * sizeof(size_t)];
+    size_t tail_;           // 生产者下标, 只由生产者写
+    size_t cachedHead_;     // 生产者缓存的head_
+    char pad2_[64 - 2 * sizeof(size_t)];
+    detail::FutexEvent notEmpty_;
+    detail::FutexEvent notFull_;
+};
+
+}       // namespace muduo
+
+#endif  // MUDUO_BASE_SPSCBLOCKINGQUEUE_H
\ No newline at end of file
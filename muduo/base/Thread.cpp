@@ -1,4 +1,5 @@
 ﻿#include <muduo/base/Thread.h>
+#include <muduo/base/CpuAffinity.h>
 #include <muduo/base/CurrentThread.h>
 #include <muduo/base/Exception.h>
 #include <muduo/base/Logging.h>
@@ -81,6 +82,12 @@ CurrentThread::isMainThread()
     return tid() == ::getpid();
 }
 
+bool
+CurrentThread::setAffinity(int cpu)
+{
+    return CpuAffinity::setCurrentThread(CpuAffinity::CpuSet(1, cpu));
+}
+
 AtomicInt32 
 Thread::numCreated_;    // 静态函数初始化
 
@@ -1,6 +1,7 @@
 ﻿#include <muduo/base/ThreadPool.h>
 
 #include <muduo/base/Exception.h>
+#include <muduo/base/Logging.h>
 
 #include <boost/bind.hpp>
 #include <assert.h>
@@ -10,8 +11,19 @@ using namespace muduo;
 
 ThreadPool::ThreadPool(const string &name)
     : mutex_(),
-    cond_(mutex_),
+    notEmpty_(mutex_),
+    notFull_(mutex_),
     name_(name),
+    maxQueueSize_(0),
+    rejectPolicy_(kBlock),
+    peakQueueSize_(0),
+    submitted_(0),
+    rejected_(0),
+    tryRunFailures_(0),
+    callerRuns_(0),
+    started_(0),
+    totalLatencyUs_(0),
+    maxLatencyUs_(0),
     running_(false)
 {
 }
@@ -33,7 +45,7 @@ void ThreadPool::start(int numThreads)
     {
         char id[32];
         snprintf(id, sizeof(id), "%d", i);
-        threads_.push_back(new muduo::Thread(boost::bind(&ThreadPool::runInThread, this), name_ + id));
+        threads_.push_back(new muduo::Thread(boost::bind(&ThreadPool::runInThread, this, i), name_ + id));
         threads_[i].start();    // 启动线程
     }
 }
@@ -43,7 +55,8 @@ void ThreadPool::stop()
     {
         MutexLockGuard lock(mutex_);
         running_ = false;
-        cond_.notifyAll();
+        notEmpty_.notifyAll();
+        notFull_.notifyAll();   // 唤醒阻塞在run中的调用者
     }
     for_each(threads_.begin(), threads_.end(), boost::bind(&muduo::Thread::join, _1));
 }
@@ -52,14 +65,113 @@ void ThreadPool::run(const Task &task)
 {
     if (threads_.empty())
     {
-        take();
+        task();
     }
     else
     {
-        MutexLockGuard lock(mutex_);
-        queue_.push_back(task);
-        cond_.notify();
+        Task rejected;
+        {
+            MutexLockGuard lock(mutex_);
+            if (!isFull())
+            {
+                enqueue(task);
+                return;
+            }
+            switch (rejectPolicy_)
+            {
+            case kBlock:
+                while (isFull() && running_)
+                {
+                    notFull_.wait();
+                }
+                if (!running_)          // 已停止, 任务被丢弃
+                {
+                    return;
+                }
+                enqueue(task);
+                return;
+            case kReject:
+                ++rejected_;
+                rejected = task;
+                break;
+            case kCallerRuns:
+                ++callerRuns_;
+                break;
+            case kDiscardOldest:
+                ++rejected_;
+                rejected.swap(queue_.front().first);
+                queue_.pop_front();
+                enqueue(task);
+                break;
+            }
+        }
+        // 在锁外执行任务或回调, 它们可能再次调用run
+        if (rejectPolicy_ == kCallerRuns)
+        {
+            task();
+        }
+        else if (rejected && rejectCallback_)
+        {
+            rejectCallback_(rejected);
+        }
+    }
+}
+
+bool ThreadPool::tryRun(const Task& task)
+{
+    if (threads_.empty())
+    {
+        task();
+        return true;
+    }
+    MutexLockGuard lock(mutex_);
+    if (isFull())
+    {
+        ++tryRunFailures_;
+        return false;
+    }
+    enqueue(task);
+    return true;
+}
+
+bool ThreadPool::isFull() const
+{
+    return maxQueueSize_ > 0 && queue_.size() >= maxQueueSize_;
+}
+
+void ThreadPool::enqueue(const Task& task)
+{
+    queue_.push_back(Entry(task, Timestamp::now()));
+    ++submitted_;
+    if (queue_.size() > peakQueueSize_)
+    {
+        peakQueueSize_ = queue_.size();
     }
+    notEmpty_.notify();
+}
+
+ThreadPool::Stats ThreadPool::stats() const
+{
+    MutexLockGuard lock(mutex_);
+    Stats s;
+    s.queueSize = queue_.size();
+    s.peakQueueSize = peakQueueSize_;
+    s.submitted = submitted_;
+    s.executed = started_;
+    s.rejected = rejected_;
+    s.tryRunFailures = tryRunFailures_;
+    s.callerRuns = callerRuns_;
+    s.avgQueueLatency = started_ > 0
+        ? static_cast<double>(totalLatencyUs_) / static_cast<double>(started_) / Timestamp::kMicroSecondsPerSecond
+        : 0.0;
+    s.maxQueueLatency = static_cast<double>(maxLatencyUs_) / Timestamp::kMicroSecondsPerSecond;
+    return s;
+}
+
+size_t ThreadPool::queueSize() const
+{
+    MutexLockGuard lock(mutex_);
+    return queue_.size();
 }
 
 ThreadPool::Task ThreadPool::take()
@@ -68,19 +180,39 @@ ThreadPool::Task ThreadPool::take()
     // always use a while-loop, due to spurious wakeup
     while (queue_.empty() && running_)
     {
-        cond_.wait();
+        notEmpty_.wait();
     }
     Task task;
     if (!queue_.empty())
     {
-        task = queue_.front();
+        task.swap(queue_.front().first);
+        int64_t latency = Timestamp::now().microSecondsSinceEpoch()
+                          - queue_.front().second.microSecondsSinceEpoch();
         queue_.pop_front();
+        ++started_;
+        totalLatencyUs_ += latency;
+        if (latency > maxLatencyUs_)
+        {
+            maxLatencyUs_ = latency;
+        }
+        if (maxQueueSize_ > 0)
+        {
+            notFull_.notify();
+        }
     }
     return task;
 }
 
-void ThreadPool::runInThread()
+void ThreadPool::runInThread(int index)
 {
+    if (!cpuSets_.empty())
+    {
+        const CpuAffinity::CpuSet& cpus = cpuSets_[index % cpuSets_.size()];
+        if (!cpus.empty() && !CpuAffinity::setCurrentThread(cpus))
+        {
+            LOG_SYSERR << "ThreadPool::runInThread - cannot set cpu affinity";
+        }
+    }
     try
     {
         while (running_)
@@ -2,8 +2,10 @@
 #define MUDUO_BASE_THREADPOOL_H
 
 #include <muduo/base/Condition.h>
+#include <muduo/base/CpuAffinity.h>
 #include <muduo/base/Mutex.h>
 #include <muduo/base/Thread.h>
+#include <muduo/base/Timestamp.h>
 #include <muduo/base/Types.h>
 
 #include <boost/function.hpp>
@@ -11,6 +13,7 @@
 #include <boost/ptr_container/ptr_vector.hpp>
 
 #include <deque>
+#include <utility>
 
 namespace muduo
 {
@@ -19,24 +22,86 @@ class ThreadPool : boost::noncopyable
 {
 public:
     typedef boost::function<void()> Task;
+    typedef boost::function<void(const Task&)> RejectCallback;
+
+    /// What run() does when the queue holds maxQueueSize tasks.
+    enum RejectPolicy
+    {
+        kBlock,             // 阻塞调用者直到有空位, 默认
+        kReject,            // 不入队, 交给RejectCallback
+        kCallerRuns,        // 在调用者线程中直接执行
+        kDiscardOldest,     // 丢弃队首任务(交给RejectCallback)后入队
+    };
+
+    struct Stats
+    {
+        size_t  queueSize;          // 当前排队任务数
+        size_t  peakQueueSize;      // 排队任务数的最大值
+        int64_t submitted;          // 进入队列的任务数
+        int64_t executed;           // 已开始执行的任务数
+        int64_t rejected;           // run()按kReject拒绝或按kDiscardOldest丢弃的任务数
+        int64_t tryRunFailures;     // 队列满时tryRun()返回false的次数, 不计入rejected
+        int64_t callerRuns;         // kCallerRuns下由调用者执行的任务数
+        double  avgQueueLatency;    // 任务从入队到开始执行的平均等待秒数
+        double  maxQueueLatency;    // 最大等待秒数
+    };
 
     explicit ThreadPool(const string &name = string());
     ~ThreadPool();
 
+    /// Pins worker i to cpus[i % cpus.size()], must be called before start().
+    void setThreadCpus(const std::vector<int>& cpus)
+    { cpuSets_ = CpuAffinity::eachCpu(cpus); }
+    /// Binds worker i to NUMA node nodes[i % nodes.size()],
+    /// must be called before start().
+    void setThreadNumaNodes(const std::vector<int>& nodes)
+    { cpuSets_ = CpuAffinity::eachNumaNode(nodes); }
+
+    /// 0 means unbounded, which is the default. Must be called before start().
+    void setMaxQueueSize(size_t maxSize) { maxQueueSize_ = maxSize; }
+    void setRejectPolicy(RejectPolicy policy) { rejectPolicy_ = policy; }
+    /// Called in the submitting thread with each rejected or discarded task.
+    void setRejectCallback(const RejectCallback& cb) { rejectCallback_ = cb; }
+
     void start(int numThreads); // numThread: 线程池内线程数量, 构造启动线程  
     void stop();                // 调用muduo::Thread::join回收线程
 
     void run(const Task &f);    // 生产者, 向queue_添加任务, 若threads_为空, 即单线线程, 直接执行Task
+    /// Never blocks nor applies the reject policy, returns false if the
+    /// queue is full, so an IO loop can shed load itself.
+    bool tryRun(const Task& f);
+
+    /// Thread safe.
+    Stats stats() const;
+    size_t queueSize() const;
 
 private:
-    void runInThread();         // 调用take后, 执行任务
-    Task take();                // 消费者, 从queue_获取任务, 任务队列为空时等待条件变量cond_
+    void runInThread(int index);    // 绑定CPU后, 循环调用take执行任务
+    Task take();                // 消费者, 从queue_获取任务, 任务队列为空时等待条件变量notEmpty_
+    bool isFull() const;        // 需持有mutex_
+    void enqueue(const Task& task);     // 需持有mutex_
+
+    typedef std::pair<Task, Timestamp> Entry;   // 任务及其入队时间
 
-    MutexLock   mutex_;         // 配合条件变量使用的互斥量
-    Condition   cond_;          // 任务队列不为空条件变量
+    mutable MutexLock mutex_;   // 配合条件变量使用的互斥量
+    Condition   notEmpty_;      // 任务队列不为空条件变量
+    Condition   notFull_;       // 任务队列不为满条件变量, kBlock策略使用
     string      name_;          // 线程名默认空字符串
     boost::ptr_vector<muduo::Thread> threads_;  // 这里需要加muduo域?
-    std::deque<Task> queue_;
+    std::deque<Entry> queue_;
+    size_t      maxQueueSize_;  // 0表示不限
+    RejectPolicy rejectPolicy_;
+    RejectCallback rejectCallback_;
+    // 以下统计由mutex_保护
+    size_t      peakQueueSize_;
+    int64_t     submitted_;
+    int64_t     rejected_;
+    int64_t     tryRunFailures_;
+    int64_t     callerRuns_;
+    int64_t     started_;           // 已开始执行的任务数
+    int64_t     totalLatencyUs_;    // 已开始执行任务的等待时间之和
+    int64_t     maxLatencyUs_;
+    std::vector<CpuAffinity::CpuSet> cpuSets_;  // 第i个线程绑定cpuSets_[i % size()], 为空则不绑定
     bool        running_;
 };
 
@@ -0,0 +1,373 @@
+﻿#include <muduo/base/TimeZone.h>
+#include <muduo/base/FileUtil.h>
+#include <muduo/base/Types.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace muduo
+{
+
+namespace detail
+{
+
+struct Transition
+{
+    time_t utctime;         // 切换时刻
+    time_t localtime;       // 切换后的本地时间, fromLocalTime按它查找
+    int    localtimeIdx;
+
+    Transition(time_t t, time_t l, int localIdx)
+        : utctime(t), localtime(l), localtimeIdx(localIdx)
+    {
+    }
+};
+
+struct Comp
+{
+    bool compareGmt;
+
+    Comp(bool gmt)
+        : compareGmt(gmt)
+    {
+    }
+
+    bool operator()(const Transition& lhs, const Transition& rhs) const
+    {
+        if (compareGmt)
+            return lhs.utctime < rhs.utctime;
+        else
+            return lhs.localtime < rhs.localtime;
+    }
+};
+
+struct Localtime
+{
+    time_t gmtOffset;
+    bool   isDst;
+    int    arrbIdx;         // 时区缩写在abbreviation中的下标
+
+    Localtime(time_t offset, bool dst, int arrb)
+        : gmtOffset(offset), isDst(dst), arrbIdx(arrb)
+    {
+    }
+};
+
+const int kSecondsPerDay = 24 * 60 * 60;
+
+// 1970-01-01以来的天数, 公历. chrono-Compatible Low-Level Date Algorithms, by Howard Hinnant.
+int64_t daysFromCivil(int64_t y, int m, int d)
+{
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const int64_t yoe = y - era * 400;                                  // [0, 399]
+    const int64_t doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1; // [0, 365]
+    const int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;          // [0, 146096]
+    return era * 146097 + doe - 719468;
+}
+
+void civilFromDays(int64_t z, int* year, int* month, int* day)
+{
+    z += 719468;
+    const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const int64_t doe = z - era * 146097;
+    const int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const int64_t mp = (5 * doy + 2) / 153;
+    *day = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+    *month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+    *year = static_cast<int>(yoe + era * 400 + (*month <= 2));
+}
+
+// tzfile(5)中的整数都是大端的, 读越界时置failed_
+class TzReader
+{
+public:
+    explicit TzReader(const string& content)
+        : p_(content.data()),
+        end_(content.data() + content.size()),
+        failed_(false)
+    {
+    }
+
+    bool failed() const { return failed_; }
+
+    const char* read(size_t n)
+    {
+        if (failed_ || static_cast<size_t>(end_ - p_) < n)
+        {
+            failed_ = true;
+            return NULL;
+        }
+        const char* result = p_;
+        p_ += n;
+        return result;
+    }
+
+    int64_t readBigEndian(size_t n)        // n为4或8
+    {
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(read(n));
+        if (p == NULL)
+        {
+            return 0;
+        }
+        uint64_t x = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            x = (x << 8) | p[i];
+        }
+        if (n == 4)
+        {
+            return static_cast<int32_t>(static_cast<uint32_t>(x));
+        }
+        return static_cast<int64_t>(x);
+    }
+
+    int readUInt8()
+    {
+        const char* p = read(1);
+        return p ? static_cast<unsigned char>(*p) : 0;
+    }
+
+private:
+    const char* p_;
+    const char* end_;
+    bool failed_;
+};
+
+struct TzHeader
+{
+    char version;
+    int64_t isutcnt, isstdcnt, leapcnt, timecnt, typecnt, charcnt;
+
+    bool read(TzReader* r)
+    {
+        const char* magic = r->read(5);
+        if (magic == NULL || memcmp(magic, "TZif", 4) != 0)
+        {
+            return false;
+        }
+        version = magic[4];
+        r->read(15);
+        isutcnt = r->readBigEndian(4);
+        isstdcnt = r->readBigEndian(4);
+        leapcnt = r->readBigEndian(4);
+        timecnt = r->readBigEndian(4);
+        typecnt = r->readBigEndian(4);
+        charcnt = r->readBigEndian(4);
+        return !r->failed() && typecnt > 0 && timecnt >= 0 && charcnt >= 0
+            && leapcnt >= 0 && isstdcnt >= 0 && isutcnt >= 0;
+    }
+
+    // 数据块的长度, timeSize为4(版本1)或8(版本2以上)
+    int64_t bodySize(int64_t timeSize) const
+    {
+        return timecnt * timeSize + timecnt + typecnt * 6 + charcnt
+            + leapcnt * (timeSize + 4) + isstdcnt + isutcnt;
+    }
+};
+
+}   // namespace detail
+
+struct TimeZone::Data
+{
+    std::vector<detail::Transition> transitions;
+    std::vector<detail::Localtime> localtimes;
+    string abbreviation;                    // 以'\0'分隔的各个时区缩写
+};
+
+namespace detail
+{
+
+bool readTimeZoneFile(const char* zonefile, TimeZone::Data* data)
+{
+    string content;
+    if (FileUtil::readFile(zonefile, 1024 * 1024, &content) != 0)
+    {
+        return false;
+    }
+
+    TzReader r(content);
+    TzHeader header;
+    if (!header.read(&r))
+    {
+        return false;
+    }
+    int64_t timeSize = 4;
+    if (header.version >= '2')          // 跳过32位的数据块, 改读其后64位时间的那一份
+    {
+        r.read(static_cast<size_t>(header.bodySize(4)));
+        if (!header.read(&r))
+        {
+            return false;
+        }
+        timeSize = 8;
+    }
+
+    std::vector<int64_t> times;
+    for (int64_t i = 0; i < header.timecnt; ++i)
+    {
+        times.push_back(r.readBigEndian(static_cast<size_t>(timeSize)));
+    }
+    std::vector<int> indices;
+    for (int64_t i = 0; i < header.timecnt; ++i)
+    {
+        indices.push_back(r.readUInt8());
+    }
+    for (int64_t i = 0; i < header.typecnt; ++i)
+    {
+        int64_t gmtoff = r.readBigEndian(4);
+        int isdst = r.readUInt8();
+        int abbrind = r.readUInt8();
+        if (abbrind >= header.charcnt)
+        {
+            return false;
+        }
+        data->localtimes.push_back(Localtime(static_cast<time_t>(gmtoff), isdst != 0, abbrind));
+    }
+    const char* abbreviation = r.read(static_cast<size_t>(header.charcnt));
+    if (r.failed())
+    {
+        return false;
+    }
+    data->abbreviation.assign(abbreviation, static_cast<size_t>(header.charcnt));
+    data->abbreviation.push_back('\0');    // 缩写表最后一项可能没有结尾的'\0'
+    // 闰秒与标准时/UTC指示位只对POSIX TZ规则有意义, 忽略
+
+    for (size_t i = 0; i < times.size(); ++i)
+    {
+        if (indices[i] >= header.typecnt)
+        {
+            return false;
+        }
+        time_t utc = static_cast<time_t>(times[i]);
+        data->transitions.push_back(
+            Transition(utc, utc + data->localtimes[indices[i]].gmtOffset, indices[i]));
+    }
+    return true;
+}
+
+const Localtime* findLocaltime(const TimeZone::Data& data, Transition sentry, Comp comp)
+{
+    const Localtime* local = NULL;
+
+    if (data.transitions.empty() || comp(sentry, data.transitions.front()))
+    {
+        // 第一次切换之前用类型0, 见RFC 8536
+        local = &data.localtimes.front();
+    }
+    else
+    {
+        std::vector<Transition>::const_iterator transI = std::upper_bound(data.transitions.begin(),
+                                                                          data.transitions.end(),
+                                                                          sentry,
+                                                                          comp);
+        --transI;
+        local = &data.localtimes[transI->localtimeIdx];
+    }
+
+    return local;
+}
+
+}   // namespace detail
+
+}   // namespace muduo
+
+using namespace muduo;
+using namespace std;
+
+TimeZone::TimeZone(const char* zonefile)
+    : data_(new TimeZone::Data)
+{
+    if (!detail::readTimeZoneFile(zonefile, data_.get()))
+    {
+        data_.reset();
+    }
+}
+
+TimeZone::TimeZone(int eastOfUtc, const char* name)
+    : data_(new TimeZone::Data)
+{
+    data_->localtimes.push_back(detail::Localtime(eastOfUtc, false, 0));
+    data_->abbreviation = name;
+}
+
+struct tm TimeZone::toLocalTime(time_t seconds) const
+{
+    struct tm localTime;
+    memset(&localTime, 0, sizeof localTime);
+    assert(data_ != NULL);
+    const Data& data(*data_);
+
+    detail::Transition sentry(seconds, 0, 0);
+    const detail::Localtime* local = findLocaltime(data, sentry, detail::Comp(true));
+
+    if (local)
+    {
+        time_t localSeconds = seconds + local->gmtOffset;
+        localTime = toUtcTime(localSeconds);
+        localTime.tm_isdst = local->isDst;
+        localTime.tm_gmtoff = local->gmtOffset;
+        localTime.tm_zone = &data.abbreviation[local->arrbIdx];
+    }
+
+    return localTime;
+}
+
+time_t TimeZone::fromLocalTime(const struct tm& localTm) const
+{
+    assert(data_ != NULL);
+    const Data& data(*data_);
+
+    time_t localSeconds = fromUtcTime(localTm);
+    detail::Transition sentry(0, localSeconds, 0);
+    const detail::Localtime* local = findLocaltime(data, sentry, detail::Comp(false));
+    return localSeconds - local->gmtOffset;
+}
+
+struct tm TimeZone::toUtcTime(time_t secondsSinceEpoch)
+{
+    struct tm utc;
+    memset(&utc, 0, sizeof utc);
+    utc.tm_zone = "GMT";
+
+    int64_t seconds = static_cast<int64_t>(secondsSinceEpoch);
+    int64_t days = seconds / detail::kSecondsPerDay;
+    int64_t secondsInDay = seconds % detail::kSecondsPerDay;
+    if (secondsInDay < 0)           // 1970年之前, 向下取整
+    {
+        secondsInDay += detail::kSecondsPerDay;
+        --days;
+    }
+    int inDay = static_cast<int>(secondsInDay);
+    utc.tm_hour = inDay / 3600;
+    utc.tm_min = inDay / 60 % 60;
+    utc.tm_sec = inDay % 60;
+
+    int year = 0, month = 0, day = 0;
+    detail::civilFromDays(days, &year, &month, &day);
+    utc.tm_year = year - 1900;
+    utc.tm_mon = month - 1;
+    utc.tm_mday = day;
+    utc.tm_wday = static_cast<int>((days % 7 + 11) % 7);       // 1970-01-01是星期四
+    utc.tm_yday = static_cast<int>(days - detail::daysFromCivil(year, 1, 1));
+    return utc;
+}
+
+time_t TimeZone::fromUtcTime(const struct tm& utc)
+{
+    return fromUtcTime(utc.tm_year + 1900, utc.tm_mon + 1, utc.tm_mday,
+                       utc.tm_hour, utc.tm_min, utc.tm_sec);
+}
+
+time_t TimeZone::fromUtcTime(int year, int month, int day,
+                             int hour, int minute, int seconds)
+{
+    int64_t days = detail::daysFromCivil(year, month, day);
+    int64_t secondsInDay = hour * 3600 + minute * 60 + seconds;
+    return static_cast<time_t>(days * detail::kSecondsPerDay + secondsInDay);
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+﻿#ifndef MUDUO_BASE_TIMEZONE_H
+#define MUDUO_BASE_TIMEZONE_H
+
+#include <muduo/base/copyable.h>
+#include <boost/shared_ptr.hpp>
+#include <time.h>
+
+namespace muduo
+{
+
+///
+/// Local time in a time zone, converted without touching the TZ environment
+/// variable or the global state behind localtime_r(3).
+///
+/// The zone is read once from a tzfile(5), e.g. /usr/share/zoneinfo/Asia/Shanghai.
+/// After the last transition in the file the last local time type applies.
+class TimeZone : public muduo::copyable
+{
+public:
+    explicit TimeZone(const char* zonefile);
+    TimeZone(int eastOfUtc, const char* tzname);    // 固定偏移, 没有夏令时
+    TimeZone() { }                                  // 无效的时区
+
+    // default copy ctor/assignment/dtor are Okay.
+
+    bool valid() const
+    {
+        return static_cast<bool>(data_);
+    }
+
+    /// tm_gmtoff, tm_isdst and tm_zone are filled in as well,
+    /// tm_zone points into this object.
+    struct tm toLocalTime(time_t secondsSinceEpoch) const;
+    /// A local time skipped or repeated by a transition resolves to the later offset.
+    time_t fromLocalTime(const struct tm&) const;
+
+    // gmtime(3)
+    static struct tm toUtcTime(time_t secondsSinceEpoch);
+    // timegm(3)
+    static time_t fromUtcTime(const struct tm&);
+    // year in [1900..2500], month in [1..12], day in [1..31]
+    static time_t fromUtcTime(int year, int month, int day,
+                              int hour, int minute, int seconds);
+
+    struct Data;
+
+private:
+    boost::shared_ptr<Data> data_;
+};
+
+}       // namespace muduo
+
+#endif  // MUDUO_BASE_TIMEZONE_H
\ No newline at end of file
@@ -1,6 +1,8 @@
 ﻿#include <muduo/base/Timestamp.h>
+#include <muduo/base/CoarseClock.h>
 
 #include <sys/time.h>
+#include <time.h>
 #include <stdio.h>
 #define __STD_FORMAT_MACROS
 #include <inttypes.h>
@@ -34,14 +36,13 @@ Timestamp::toFormattedString() const
     char    buf[32] = { 0 };
     time_t  seconds = static_cast<time_t>(microSecondsSinceEpoch_ / kMicroSecondsPerSecond);
     int     microseconds = static_cast<int>(microSecondsSinceEpoch_ % kMicroSecondsPerSecond);
-    struct tm tm_time;
-    /* 通过秒转换成时间结果体 */
-    gmtime_r(&seconds, &tm_time);   // gmtime_r表示是一个线程安全的函数
-
-    snprintf(buf, sizeof(buf), "%4d%02d%02d %02d:%02d:%02d.%06d",
-        tm_time.tm_year + 1900, tm_time.tm_mon + 1, tm_time.tm_mday,
-        tm_time.tm_hour, tm_time.tm_min, tm_time.tm_sec,
-        microseconds);
+    /* 当前这一秒通常已由事件循环渲染好, 否则再转换成时间结构体 */
+    if (!CoarseClock::formatUtc(seconds, buf))
+    {
+        CoarseClock::formatSecond(TimeZone::toUtcTime(seconds), buf);
+    }
+
+    snprintf(buf + CoarseClock::kSecondLength, sizeof(buf) - CoarseClock::kSecondLength, ".%06d", microseconds);
     return buf;
 }
 
@@ -54,6 +55,31 @@ Timestamp::now()
     return Timestamp(seconds * kMicroSecondsPerSecond + tv.tv_usec);
 }
 
+namespace
+{
+
+Timestamp readClock(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    int64_t seconds = ts.tv_sec;
+    return Timestamp(seconds * Timestamp::kMicroSecondsPerSecond + ts.tv_nsec / 1000);
+}
+
+}   // namespace
+
+Timestamp 
+Timestamp::coarseNow()
+{
+    return readClock(CLOCK_REALTIME_COARSE);
+}
+
+Timestamp 
+Timestamp::monotonicNow(bool coarse)
+{
+    return readClock(coarse ? CLOCK_MONOTONIC_COARSE : CLOCK_MONOTONIC);
+}
+
 Timestamp 
 Timestamp::invalid()
 {
@@ -37,6 +37,13 @@ public:
     }
 
     static Timestamp now();     // 通过静态成员变量构造对象, 然后通过拷贝构造函数进行初始化
+    /// CLOCK_REALTIME_COARSE, the time of the last clock tick (1~4ms resolution),
+    /// cheaper to read than now().
+    static Timestamp coarseNow();
+    /// CLOCK_MONOTONIC, or CLOCK_MONOTONIC_COARSE if @c coarse.
+    /// Time since an unspecified point, unaffected by settimeofday or NTP steps,
+    /// only comparable with other monotonic timestamps.
+    static Timestamp monotonicNow(bool coarse = false);
 
     static Timestamp invalid();
 
@@ -64,7 +71,7 @@ inline double timeDifference(Timestamp high, Timestamp low)
 
 inline Timestamp addTime(Timestamp timestamp, double second)
 {
-    int64_t delta = static_cast<int>(second * Timestamp::kMicroSecondsPerSecond);   // 秒转换成微秒
+    int64_t delta = static_cast<int64_t>(second * Timestamp::kMicroSecondsPerSecond);   // 秒转换成微秒
     return Timestamp(delta + timestamp.microSecondsSinceEpoch());
 }
 
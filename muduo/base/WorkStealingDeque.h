@@ -0,0 +1,156 @@
+﻿#ifndef MUDUO_BASE_WORKSTEALINGDEQUE_H
+#define MUDUO_BASE_WORKSTEALINGDEQUE_H
+
+#include <boost/noncopyable.hpp>
+
+#include <vector>
+
+#include <assert.h>
+#include <stdint.h>
+
+/*
+    无锁工作窃取双端队列(Chase-Lev deque, 内存序参照Lê等人的C11实现)
+    只有所有者线程在bottom_端push/pop(后进先出), 其他线程在top_端steal(先进先出)
+    所有者与窃取者只在剩最后一个元素时通过top_的CAS竞争
+    T必须是指针或整数, 以便原子读写
+*/
+
+namespace muduo
+{
+
+template<typename T>
+class WorkStealingDeque : boost::noncopyable
+{
+public:
+    /// @c capacity must be a power of 2, the deque grows when full.
+    explicit WorkStealingDeque(int64_t capacity = 256)
+        : top_(0),
+        bottom_(0),
+        array_(new Array(capacity))
+    {
+        assert(capacity > 0 && (capacity & (capacity - 1)) == 0);
+    }
+
+    ~WorkStealingDeque()
+    {
+        delete array_;
+        for (size_t i = 0; i < garbage_.size(); ++i)
+        {
+            delete garbage_[i];
+        }
+    }
+
+    /// Must be called from the owner thread.
+    void push(T x)
+    {
+        int64_t b = __atomic_load_n(&bottom_, __ATOMIC_RELAXED);
+        int64_t t = __atomic_load_n(&top_, __ATOMIC_ACQUIRE);
+        Array* a = __atomic_load_n(&array_, __ATOMIC_RELAXED);
+        if (b - t > a->mask)            // 已满, 扩容
+        {
+            garbage_.push_back(a);      // 窃取者可能仍在读旧数组, 析构时再释放
+            a = a->grow(t, b);
+            __atomic_store_n(&array_, a, __ATOMIC_RELEASE);
+        }
+        a->put(b, x);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        __atomic_store_n(&bottom_, b + 1, __ATOMIC_RELAXED);
+    }
+
+    /// Must be called from the owner thread, takes the newest element.
+    bool pop(T* x)
+    {
+        int64_t b = __atomic_load_n(&bottom_, __ATOMIC_RELAXED) - 1;
+        Array* a = __atomic_load_n(&array_, __ATOMIC_RELAXED);
+        __atomic_store_n(&bottom_, b, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        int64_t t = __atomic_load_n(&top_, __ATOMIC_RELAXED);
+        bool found = false;
+        if (t <= b)
+        {
+            *x = a->get(b);
+            found = true;
+            if (t == b)                 // 最后一个元素, 与窃取者竞争
+            {
+                found = __atomic_compare_exchange_n(&top_, &t, t + 1, false,
+                                                    __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+                __atomic_store_n(&bottom_, b + 1, __ATOMIC_RELAXED);
+            }
+        }
+        else
+        {
+            __atomic_store_n(&bottom_, b + 1, __ATOMIC_RELAXED);
+        }
+        return found;
+    }
+
+    /// Safe to call from any thread, takes the oldest element.
+    /// Returns false if empty, or if it lost a race with pop() or another
+    /// steal(), the caller may retry while !empty().
+    bool steal(T* x)
+    {
+        int64_t t = __atomic_load_n(&top_, __ATOMIC_ACQUIRE);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        int64_t b = __atomic_load_n(&bottom_, __ATOMIC_ACQUIRE);
+        if (t < b)
+        {
+            Array* a = __atomic_load_n(&array_, __ATOMIC_ACQUIRE);
+            T value = a->get(t);
+            if (__atomic_compare_exchange_n(&top_, &t, t + 1, false,
+                                            __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+            {
+                *x = value;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// Approximate when called from other threads.
+    int64_t size() const
+    {
+        int64_t b = __atomic_load_n(&bottom_, __ATOMIC_SEQ_CST);
+        int64_t t = __atomic_load_n(&top_, __ATOMIC_SEQ_CST);
+        return b > t ? b - t : 0;
+    }
+
+    bool empty() const { return size() == 0; }
+
+private:
+    struct Array : boost::noncopyable
+    {
+        explicit Array(int64_t capacity)
+            : mask(capacity - 1),
+            slots(new T[capacity])
+        {
+        }
+
+        ~Array() { delete[] slots; }
+
+        T get(int64_t i) const { return __atomic_load_n(&slots[i & mask], __ATOMIC_RELAXED); }
+        void put(int64_t i, T x) { __atomic_store_n(&slots[i & mask], x, __ATOMIC_RELAXED); }
+
+        Array* grow(int64_t top, int64_t bottom) const
+        {
+            Array* a = new Array((mask + 1) * 2);
+            for (int64_t i = top; i < bottom; ++i)
+            {
+                a->put(i, get(i));
+            }
+            return a;
+        }
+
+        int64_t mask;
+        T* slots;
+    };
+
+    int64_t top_;           // 窃取端, 窃取者之间通过CAS竞争
+    char pad_[64 - sizeof(int64_t)];    // top_与bottom_分处不同cache line, 避免伪共享
+    int64_t bottom_;        // 所有者端, 只有所有者写
+    Array* array_;
+    std::vector<Array*> garbage_;       // 扩容前的数组, 只由所有者访问
+};
+
+}       // namespace muduo
+
+#endif  // MUDUO_BASE_WORKSTEALINGDEQUE_H
\ No newline at end of file
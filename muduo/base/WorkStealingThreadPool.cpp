@@ -0,0 +1,290 @@
+﻿#include <muduo/base/WorkStealingThreadPool.h>
+
+#include <muduo/base/Exception.h>
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace muduo;
+
+namespace
+{
+__thread WorkStealingThreadPool* t_pool = NULL;     // 当前线程所属的线程池, 非工作线程为NULL
+__thread int t_index = -1;                           // 当前线程在线程池中的编号
+
+const size_t kMaxBatch = 32;    // 每次从共享队列最多取走的任务数
+}
+
+WorkStealingThreadPool::WorkStealingThreadPool(const string& name)
+    : mutex_(),
+    cond_(mutex_),
+    name_(name),
+    injectedSize_(0),
+    sleepers_(0),
+    running_(false)
+{
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool()
+{
+    if (running_)
+    {
+        stop();
+    }
+    for (size_t i = 0; i < workers_.size(); ++i)
+    {
+        Task* task = NULL;
+        while (workers_[i].deque.pop(&task))
+        {
+            delete task;
+        }
+    }
+    for (size_t i = 0; i < injected_.size(); ++i)
+    {
+        delete injected_[i];
+    }
+}
+
+void WorkStealingThreadPool::start(int numThreads)
+{
+    assert(threads_.empty());
+    __atomic_store_n(&running_, true, __ATOMIC_RELEASE);
+    workers_.reserve(numThreads);
+    for (int i = 0; i < numThreads; ++i)
+    {
+        workers_.push_back(new Worker(static_cast<uint32_t>(i) * 2654435761u + 1));
+    }
+    threads_.reserve(numThreads);
+    for (int i = 0; i < numThreads; ++i)
+    {
+        char id[32];
+        snprintf(id, sizeof(id), "%d", i);
+        threads_.push_back(new muduo::Thread(
+            boost::bind(&WorkStealingThreadPool::runInThread, this, i), name_ + id));
+        threads_[i].start();
+    }
+}
+
+void WorkStealingThreadPool::stop()
+{
+    {
+        MutexLockGuard lock(mutex_);
+        __atomic_store_n(&running_, false, __ATOMIC_RELEASE);
+        cond_.notifyAll();
+    }
+    for_each(threads_.begin(), threads_.end(), boost::bind(&muduo::Thread::join, _1));
+}
+
+void WorkStealingThreadPool::run(const Task& task)
+{
+    if (threads_.empty())
+    {
+        task();
+    }
+    else if (t_pool == this)
+    {
+        // 工作线程提交, 放入自己的双端队列, 无需加锁
+        workers_[t_index].deque.push(new Task(task));
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);    // 与wait()中的检查配对, 避免丢失唤醒
+        if (__atomic_load_n(&sleepers_, __ATOMIC_RELAXED) > 0)
+        {
+            wakeUp(1);
+        }
+    }
+    else
+    {
+        MutexLockGuard lock(mutex_);
+        injected_.push_back(new Task(task));
+        __atomic_store_n(&injectedSize_, injected_.size(), __ATOMIC_RELEASE);
+        cond_.notify();
+    }
+}
+
+void WorkStealingThreadPool::run(const std::vector<Task>& tasks)
+{
+    if (threads_.empty())
+    {
+        for (size_t i = 0; i < tasks.size(); ++i)
+        {
+            tasks[i]();
+        }
+    }
+    else if (t_pool == this)
+    {
+        Worker& self = workers_[t_index];
+        for (size_t i = 0; i < tasks.size(); ++i)
+        {
+            self.deque.push(new Task(tasks[i]));
+        }
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&sleepers_, __ATOMIC_RELAXED) > 0)
+        {
+            wakeUp(tasks.size());
+        }
+    }
+    else if (!tasks.empty())
+    {
+        MutexLockGuard lock(mutex_);
+        for (size_t i = 0; i < tasks.size(); ++i)
+        {
+            injected_.push_back(new Task(tasks[i]));
+        }
+        __atomic_store_n(&injectedSize_, injected_.size(), __ATOMIC_RELEASE);
+        if (tasks.size() >= workers_.size())
+        {
+            cond_.notifyAll();
+        }
+        else
+        {
+            for (size_t i = 0; i < tasks.size(); ++i)
+            {
+                cond_.notify();
+            }
+        }
+    }
+}
+
+size_t WorkStealingThreadPool::queueSize() const
+{
+    size_t n = __atomic_load_n(&injectedSize_, __ATOMIC_ACQUIRE);
+    for (size_t i = 0; i < workers_.size(); ++i)
+    {
+        n += static_cast<size_t>(workers_[i].deque.size());
+    }
+    return n;
+}
+
+// 从共享队列取一个任务执行, 顺带把一批任务移入自己的双端队列, 供自己和窃取者使用
+bool WorkStealingThreadPool::takeInjected(Worker* self, Task** task)
+{
+    if (__atomic_load_n(&injectedSize_, __ATOMIC_ACQUIRE) == 0)
+    {
+        return false;
+    }
+    MutexLockGuard lock(mutex_);
+    if (injected_.empty())
+    {
+        return false;
+    }
+    *task = injected_.front();
+    injected_.pop_front();
+    size_t batch = std::min(injected_.size() / workers_.size(), kMaxBatch);
+    for (size_t i = 0; i < batch; ++i)
+    {
+        self->deque.push(injected_.front());
+        injected_.pop_front();
+    }
+    __atomic_store_n(&injectedSize_, injected_.size(), __ATOMIC_RELEASE);
+    return true;
+}
+
+bool WorkStealingThreadPool::steal(int index, Task** task)
+{
+    Worker& self = workers_[index];
+    size_t n = workers_.size();
+    // xorshift32, 随机选择起点, 避免所有空闲线程同时窃取同一个线程
+    self.seed ^= self.seed << 13;
+    self.seed ^= self.seed >> 17;
+    self.seed ^= self.seed << 5;
+    size_t start = self.seed % n;
+    for (size_t i = 0; i < n; ++i)
+    {
+        size_t victim = (start + i) % n;
+        if (victim == implicit_cast<size_t>(index))
+        {
+            continue;
+        }
+        WorkStealingDeque<Task*>& deque = workers_[victim].deque;
+        while (!deque.empty())
+        {
+            if (deque.steal(task))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void WorkStealingThreadPool::wait()
+{
+    MutexLockGuard lock(mutex_);
+    __atomic_add_fetch(&sleepers_, 1, __ATOMIC_SEQ_CST);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);    // 先登记再检查双端队列, 与run()中的先push再读sleepers_配对
+    for (;;)
+    {
+        bool stealable = false;
+        for (size_t i = 0; i < workers_.size() && !stealable; ++i)
+        {
+            stealable = !workers_[i].deque.empty();
+        }
+        if (stealable || !injected_.empty() || !running())
+        {
+            break;
+        }
+        cond_.wait();
+    }
+    __atomic_sub_fetch(&sleepers_, 1, __ATOMIC_SEQ_CST);
+}
+
+void WorkStealingThreadPool::wakeUp(size_t count)
+{
+    MutexLockGuard lock(mutex_);
+    if (count >= workers_.size())
+    {
+        cond_.notifyAll();
+    }
+    else
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            cond_.notify();
+        }
+    }
+}
+
+void WorkStealingThreadPool::runInThread(int index)
+{
+    t_pool = this;
+    t_index = index;
+    Worker& self = workers_[index];
+    try
+    {
+        while (running())
+        {
+            Task* task = NULL;
+            if (self.deque.pop(&task) || takeInjected(&self, &task) || steal(index, &task))
+            {
+                (*task)();
+                delete task;
+            }
+            else
+            {
+                wait();
+            }
+        }
+    }
+    catch (const Exception& ex)
+    {
+        fprintf(stderr, "exception caught in WorkStealingThreadPool %s\n", name_.c_str());
+        fprintf(stderr, "reason: %s\n", ex.what());
+        fprintf(stderr, "stack trace: %s\n", ex.stackTrace());
+        abort();
+    }
+    catch (const std::exception& ex)
+    {
+        fprintf(stderr, "exception caught in WorkStealingThreadPool %s\n", name_.c_str());
+        fprintf(stderr, "reason: %s\n", ex.what());
+        abort();
+    }
+    catch (...)
+    {
+        fprintf(stderr, "unknown exception caught in WorkStealingThreadPool %s\n", name_.c_str());
+        throw; // rethrow
+    }
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+﻿#ifndef MUDUO_BASE_WORKSTEALINGTHREADPOOL_H
+#define MUDUO_BASE_WORKSTEALINGTHREADPOOL_H
+
+#include <muduo/base/Condition.h>
+#include <muduo/base/Mutex.h>
+#include <muduo/base/Thread.h>
+#include <muduo/base/Types.h>
+#include <muduo/base/WorkStealingDeque.h>
+
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+
+#include <deque>
+#include <vector>
+
+namespace muduo
+{
+
+///
+/// Thread pool with one work-stealing deque per worker.
+///
+/// Tasks submitted from a worker go to its own deque without locking,
+/// tasks from other threads go to a shared queue that idle workers drain
+/// in batches. A worker with nothing to do steals from the others before
+/// it sleeps. Tasks are not run in submission order.
+class WorkStealingThreadPool : boost::noncopyable
+{
+public:
+    typedef boost::function<void()> Task;
+
+    explicit WorkStealingThreadPool(const string& name = string());
+    ~WorkStealingThreadPool();
+
+    void start(int numThreads); // numThreads为0时, run直接在调用线程执行任务
+    void stop();                // 未执行的任务被丢弃
+
+    /// Thread safe, from a worker of this pool the task is queued locally.
+    void run(const Task& task);
+    /// Queues all tasks with one lock acquisition and wakes up to
+    /// tasks.size() workers.
+    void run(const std::vector<Task>& tasks);
+
+    /// Tasks not yet started, approximate.
+    size_t queueSize() const;
+
+private:
+    struct Worker : boost::noncopyable
+    {
+        explicit Worker(uint32_t s) : seed(s) {}
+
+        WorkStealingDeque<Task*> deque; // 本线程提交的任务及从共享队列批量取来的任务
+        uint32_t seed;                  // 随机选择窃取对象
+    };
+
+    void runInThread(int index);
+    bool takeInjected(Worker* self, Task** task);
+    bool steal(int index, Task** task);
+    void wait();
+    void wakeUp(size_t count);
+    bool running() const { return __atomic_load_n(&running_, __ATOMIC_ACQUIRE); }
+
+    mutable MutexLock mutex_;   // 保护injected_, 配合cond_使用
+    Condition   cond_;          // 有任务可取条件变量
+    string      name_;
+    boost::ptr_vector<muduo::Thread> threads_;
+    boost::ptr_vector<Worker> workers_;
+    std::deque<Task*> injected_;    // 非工作线程提交的任务
+    size_t      injectedSize_;      // injected_.size(), 工作线程不加锁读取, 原子操作
+    int         sleepers_;          // 在cond_上等待的工作线程数, 原子操作
+    bool        running_;
+};
+
+}       // namespace muduo
+
+#endif  // MUDUO_BASE_WORKSTEALINGTHREADPOOL_H
\ No newline at end of file
@@ -1,11 +1,23 @@
 ﻿#include <muduo/base/AsyncLogging.h>
 #include <muduo/base/Logging.h>
+#include <muduo/base/Thread.h>
 #include <muduo/base/Timestamp.h>
 
+#include <boost/bind.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+
 #include <stdio.h>
 #include <sys/resource.h>
 
+/*
+    asynclogging_test [threads] [perThreadKB] [writeMode] [long]
+    threads个线程同时写日志, 打印每批1000条的平均耗时(微秒)
+    perThreadKB为0时使用共享的双缓冲, 否则每个线程使用自己的环形缓冲区
+    writeMode: 0 stdio, 1 writev, 2 O_DIRECT
+*/
+
 int kRollSize = 500 * 1000 * 1000;
+const int kRounds = 30;
 
 muduo::AsyncLogging* g_asyncLog = NULL;
 
@@ -14,17 +26,15 @@ void asyncOutput(const char* msg, int len)
     g_asyncLog->append(msg, len);
 }
 
-void bench(bool longLog)
+void bench(bool longLog, double* totalUs)
 {
-    muduo::Logger::setOutput(asyncOutput);
-
     int cnt = 0;
     const int kBatch = 1000;
     muduo::string empty = " ";
     muduo::string longStr(3000, 'X');
     longStr += " ";
 
-    for (int t = 0; t < 30; ++t)
+    for (int t = 0; t < kRounds; ++t)
     {
         muduo::Timestamp start = muduo::Timestamp::now();
         for (int i = 0; i < kBatch; ++i)
@@ -35,7 +45,9 @@ void bench(bool longLog)
             ++cnt;
         }
         muduo::Timestamp end = muduo::Timestamp::now();
-        printf("%f\n", timeDifference(end, start) * 1000000 / kBatch);
+        double us = timeDifference(end, start) * 1000000 / kBatch;
+        *totalUs += us;
+        printf("%f\n", us);
         struct timespec ts = { 0, 500 * 1000 * 1000 };
         nanosleep(&ts, NULL);
     }
@@ -52,12 +64,33 @@ int main(int argc, char* argv[])
 
     printf("pid = %d\n", getpid());
 
+    int numThreads = argc > 1 ? atoi(argv[1]) : 1;
+    int perThreadKB = argc > 2 ? atoi(argv[2]) : 0;
+    int writeMode = argc > 3 ? atoi(argv[3]) : 0;
+    bool longLog = argc > 4;
+
     char name[256];
     strncpy(name, argv[0], 256);
     muduo::AsyncLogging log(::basename(name), kRollSize);
+    log.setPerThreadBuffer(perThreadKB * 1024);
+    log.setWriteMode(static_cast<muduo::LogFile::WriteMode>(writeMode), 1);
     log.start();
     g_asyncLog = &log;
+    muduo::Logger::setOutput(asyncOutput);
 
-    bool longLog = argc > 1;
-    bench(longLog);
+    std::vector<double> totalUs(numThreads);
+    boost::ptr_vector<muduo::Thread> threads;
+    for (int i = 0; i < numThreads; ++i)
+    {
+        threads.push_back(new muduo::Thread(boost::bind(bench, longLog, &totalUs[i])));
+        threads.back().start();
+    }
+    double sum = 0;
+    for (int i = 0; i < numThreads; ++i)
+    {
+        threads[i].join();
+        sum += totalUs[i];
+    }
+    printf("threads=%d perThreadKB=%d writeMode=%d average %f us per line\n",
+           numThreads, perThreadKB, writeMode, sum / numThreads / kRounds);
 }
\ No newline at end of file
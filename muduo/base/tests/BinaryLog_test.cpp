@@ -0,0 +1,70 @@
+﻿#include <muduo/base/BinaryLog.h>
+#include <muduo/base/Timestamp.h>
+
+#include <assert.h>
+#include <stdio.h>
+
+muduo::string g_output;
+
+void output(const char* msg, int len)
+{
+    g_output.append(msg, len);
+}
+
+void bench()
+{
+    const int kLines = 1000 * 1000;
+    double seconds = 0;
+    {
+        g_output.clear();
+        muduo::Timestamp start(muduo::Timestamp::now());
+        for (int i = 0; i < kLines; ++i)
+        {
+            LOG_INFO << "Hello " << i << " pi=" << 3.1415926 << ' ' << muduo::string("abcdefghij");
+        }
+        seconds = timeDifference(muduo::Timestamp::now(), start);
+        printf("text   %.3f us per line, %zu bytes\n", seconds * 1e6 / kLines, g_output.size());
+    }
+    {
+        g_output.clear();
+        muduo::Timestamp start(muduo::Timestamp::now());
+        for (int i = 0; i < kLines; ++i)
+        {
+            LOG_BINARY(muduo::Logger::INFO, "Hello {} pi={} {}", i, 3.1415926, muduo::string("abcdefghij"));
+        }
+        seconds = timeDifference(muduo::Timestamp::now(), start);
+        printf("binary %.3f us per line, %zu bytes\n", seconds * 1e6 / kLines, g_output.size());
+    }
+}
+
+int main()
+{
+    muduo::Logger::setLogLevel(muduo::Logger::INFO);
+    muduo::Logger::setOutput(output);
+
+    int x = 42;
+    LOG_INFO << "text line";
+    LOG_BINARY(muduo::Logger::INFO, "int={} uint={} double={} char={} str={} ptr={}",
+               -7, 7u, 0.25, 'c', "hello", static_cast<const void*>(&x));
+    LOG_BINARY(muduo::Logger::WARN, "no placeholders", 1, muduo::string("extra"));
+    LOG_BINARY(muduo::Logger::DEBUG, "filtered {}", 1);
+
+    muduo::BinaryLogDecoder decoder;
+    muduo::string text;
+    size_t consumed = decoder.decode(g_output.data(), g_output.size(), &text, true);
+    assert(consumed == g_output.size()); (void) consumed;
+    printf("%s", text.c_str());
+    assert(text.find("INFO  text line") != muduo::string::npos);
+    assert(text.find("INFO  int=-7 uint=7 double=0.25 char=c str=hello ptr=0x") != muduo::string::npos);
+    assert(text.find("WARN  no placeholders 1 extra - BinaryLog_test.cpp:") != muduo::string::npos);
+    assert(text.find("filtered") == muduo::string::npos);
+
+    // 文件头中的定义使后续的记录可以单独解码
+    muduo::string table = muduo::BinaryLog::siteTable();
+    muduo::BinaryLogDecoder decoder2;
+    muduo::string text2;
+    decoder2.decode(table.data(), table.size(), &text2);
+    assert(text2.empty());
+
+    bench();
+}
\ No newline at end of file
@@ -1,5 +1,8 @@
 ﻿#include <muduo/base/BlockingQueue.h>
+#include <muduo/base/BoundedBlockingQueue.h>
 #include <muduo/base/CountDownLatch.h>
+#include <muduo/base/MpmcBlockingQueue.h>
+#include <muduo/base/SpscBlockingQueue.h>
 #include <muduo/base/Thread.h>
 #include <muduo/base/Timestamp.h>
 
@@ -8,10 +11,12 @@
 #include <map>
 #include <string>
 #include <stdio.h>
+#include <string.h>
 
 /*
     Test::run->生产者线程, 等待消费者执行时才开始生产产品
     Treas::threadFunc->消费者线程
+    ThroughputBench: 多个生产者尽快put, 多个消费者take, 比较各队列的吞吐量
 */
 
 class Bench
@@ -88,11 +93,114 @@ private:
     boost::ptr_vector<muduo::Thread> threads_;
 };
 
+template<typename Queue>
+class ThroughputBench
+{
+public:
+    ThroughputBench(Queue* queue, int producers, int consumers, int messages)
+        : queue_(queue),
+        numProducers_(producers),
+        numConsumers_(consumers),
+        messages_(messages),
+        start_(1)
+    {
+    }
+
+    // 返回每秒传递的消息数
+    double run()
+    {
+        boost::ptr_vector<muduo::Thread> threads;
+        for (int i = 0; i < numConsumers_; ++i)
+        {
+            threads.push_back(new muduo::Thread(boost::bind(&ThroughputBench::consume, this), "consumer"));
+        }
+        for (int i = 0; i < numProducers_; ++i)
+        {
+            threads.push_back(new muduo::Thread(boost::bind(&ThroughputBench::produce, this), "producer"));
+        }
+        for_each(threads.begin(), threads.end(), boost::bind(&muduo::Thread::start, _1));
+        muduo::Timestamp start(muduo::Timestamp::now());
+        start_.countDown();
+        for (int i = numConsumers_; i < numConsumers_ + numProducers_; ++i)
+        {
+            threads[i].join();
+        }
+        for (int i = 0; i < numConsumers_; ++i)
+        {
+            queue_->put(-1);        // 每个消费者一个结束标记
+        }
+        for (int i = 0; i < numConsumers_; ++i)
+        {
+            threads[i].join();
+        }
+        double seconds = timeDifference(muduo::Timestamp::now(), start);
+        return static_cast<double>(messages_ / numProducers_ * numProducers_) / seconds;
+    }
+
+private:
+    void produce()
+    {
+        start_.wait();
+        int n = messages_ / numProducers_;
+        for (int i = 0; i < n; ++i)
+        {
+            queue_->put(i);
+        }
+    }
+
+    void consume()
+    {
+        while (queue_->take() >= 0)
+        {
+        }
+    }
+
+    Queue* queue_;
+    int numProducers_;
+    int numConsumers_;
+    int messages_;
+    muduo::CountDownLatch start_;
+};
+
+template<typename Queue>
+void throughput(const char* name, Queue* queue, int producers, int consumers, int messages)
+{
+    ThroughputBench<Queue> bench(queue, producers, consumers, messages);
+    printf("%-20s producers=%d consumers=%d %8.3f M msgs/s\n",
+           name, producers, consumers, bench.run() / 1e6);
+}
+
 int main(int argc, char* argv[])
 {
-    int threads = argc > 1 ? atoi(argv[1]) : 1;
+    if (argc > 1 && strcmp(argv[1], "latency") == 0)
+    {
+        int threads = argc > 2 ? atoi(argv[2]) : 1;
 
-    Bench t(threads);
-    t.run(10000);
-    t.joinAll();
+        Bench t(threads);
+        t.run(10000);
+        t.joinAll();
+        return 0;
+    }
+
+    // blockingqueue_bench [maxThreads] [messages]
+    int maxThreads = argc > 1 ? atoi(argv[1]) : 4;
+    int messages = argc > 2 ? atoi(argv[2]) : 1000 * 1000;
+    const int kQueueSize = 1024;
+    for (int producers = 1; producers <= maxThreads; producers *= 2)
+    {
+        for (int consumers = 1; consumers <= maxThreads; consumers *= 2)
+        {
+            muduo::BlockingQueue<int> blocking;
+            throughput("BlockingQueue", &blocking, producers, consumers, messages);
+            muduo::BoundedBlockingQueue<int> bounded(kQueueSize);
+            throughput("BoundedBlockingQueue", &bounded, producers, consumers, messages);
+            if (producers == 1 && consumers == 1)
+            {
+                muduo::SpscBlockingQueue<int> spsc(kQueueSize);
+                throughput("SpscBlockingQueue", &spsc, producers, consumers, messages);
+            }
+            muduo::MpmcBlockingQueue<int> mpmc(kQueueSize);
+            throughput("MpmcBlockingQueue", &mpmc, producers, consumers, messages);
+        }
+    }
 }
@@ -0,0 +1,51 @@
+﻿#include <muduo/base/LatencyHistogram.h>
+
+//#define BOOST_TEST_MODULE LatencyHistogramTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using muduo::LatencyHistogram;
+
+BOOST_AUTO_TEST_CASE(testBuckets)
+{
+    // 桶下标单调不减, 值不超过所在桶的上界, 且大于前一个桶的上界
+    int last = 0;
+    for (int64_t v = 0; v < (1LL << 20); v += 1 + v / 64)
+    {
+        int index = LatencyHistogram::bucketIndex(v);
+        BOOST_REQUIRE_MESSAGE(index >= last, "monotonic at " << v);
+        BOOST_REQUIRE_MESSAGE(v <= LatencyHistogram::bucketUpperBound(index), "upper bound at " << v);
+        BOOST_REQUIRE_MESSAGE(index == 0 || v > LatencyHistogram::bucketUpperBound(index - 1), "lower bound at " << v);
+        // 相对误差不超过1/8
+        BOOST_REQUIRE_MESSAGE(LatencyHistogram::bucketUpperBound(index) - v <= v / 8, "precision at " << v);
+        last = index;
+    }
+    BOOST_CHECK_EQUAL(LatencyHistogram::bucketIndex(-5), 0);
+    BOOST_CHECK_EQUAL(LatencyHistogram::bucketIndex(1LL << 50), LatencyHistogram::kNumBuckets - 1);
+    BOOST_CHECK_EQUAL(LatencyHistogram::bucketUpperBound(LatencyHistogram::kNumBuckets - 1), (1LL << 40) - 1);
+}
+
+BOOST_AUTO_TEST_CASE(testPercentile)
+{
+    LatencyHistogram histogram;
+    LatencyHistogram::Snapshot snap;
+    histogram.snapshot(&snap);
+    BOOST_CHECK_EQUAL(snap.count, 0);
+    BOOST_CHECK_EQUAL(snap.percentile(99), 0);
+
+    for (int64_t v = 1; v <= 1000; ++v)
+    {
+        histogram.record(v);
+    }
+    histogram.snapshot(&snap);
+    BOOST_CHECK_EQUAL(snap.count, 1000);
+    BOOST_CHECK_EQUAL(snap.sum, 500500);
+    BOOST_CHECK_EQUAL(snap.max, 1000);
+    int64_t p50 = snap.percentile(50);
+    int64_t p99 = snap.percentile(99);
+    BOOST_CHECK(p50 >= 500 && p50 <= 500 + 500 / 8);
+    BOOST_CHECK(p99 >= 990 && p99 <= 1000);
+    BOOST_CHECK_EQUAL(snap.percentile(100), 1000);
+    BOOST_CHECK_EQUAL(snap.percentile(0), 1);
+}
\ No newline at end of file
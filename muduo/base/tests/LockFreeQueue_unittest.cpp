@@ -0,0 +1,324 @@
+﻿#include <muduo/base/MpmcBlockingQueue.h>
+#include <muduo/base/MpscQueue.h>
+#include <muduo/base/SpscBlockingQueue.h>
+#include <muduo/base/Thread.h>
+
+#include <boost/bind.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#include <unistd.h>
+
+//#define BOOST_TEST_MODULE LockFreeQueueTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using muduo::MpmcBlockingQueue;
+using muduo::MpscQueue;
+using muduo::SpscBlockingQueue;
+using muduo::Thread;
+
+namespace
+{
+
+// 等待计数达到expected, 超时返回false, 避免唤醒丢失时测试挂死
+bool waitFor(const int* counter, int expected)
+{
+    for (int i = 0; i < 5000; ++i)
+    {
+        if (__atomic_load_n(counter, __ATOMIC_ACQUIRE) >= expected)
+        {
+            return true;
+        }
+        ::usleep(1000);
+    }
+    return false;
+}
+
+const int kItems = 1000000;
+
+void spscProducer(SpscBlockingQueue<int>* queue)
+{
+    for (int i = 0; i < kItems; ++i)
+    {
+        queue->put(i);
+    }
+}
+
+}   // namespace
+
+BOOST_AUTO_TEST_CASE(testSpscFifo)
+{
+    SpscBlockingQueue<int> queue(64);       // 容量小, 两端都会频繁睡眠
+    Thread producer(boost::bind(spscProducer, &queue), "producer");
+    producer.start();
+    for (int i = 0; i < kItems; ++i)
+    {
+        int x = queue.take();
+        if (x != i)
+        {
+            BOOST_ERROR("spsc order at " << i << ", got " << x);
+            break;
+        }
+    }
+    producer.join();
+    BOOST_CHECK_EQUAL(queue.size(), 0u);
+}
+
+namespace
+{
+
+const int kProducers = 4;
+const int kConsumers = 4;
+const int kItemsPerProducer = 200000;
+
+void mpmcProducer(MpmcBlockingQueue<int>* queue, int id)
+{
+    for (int i = 0; i < kItemsPerProducer; ++i)
+    {
+        queue->put(id * kItemsPerProducer + i);
+    }
+}
+
+void mpmcConsumer(MpmcBlockingQueue<int>* queue, std::vector<int>* received)
+{
+    for (;;)
+    {
+        int x = queue->take();
+        if (x < 0)
+        {
+            break;
+        }
+        received->push_back(x);
+    }
+}
+
+}   // namespace
+
+BOOST_AUTO_TEST_CASE(testMpmcExactlyOnce)
+{
+    MpmcBlockingQueue<int> queue(128);
+    std::vector<std::vector<int> > received(kConsumers);
+    boost::ptr_vector<Thread> threads;
+    for (int i = 0; i < kConsumers; ++i)
+    {
+        threads.push_back(new Thread(boost::bind(mpmcConsumer, &queue, &received[i]), "consumer"));
+    }
+    for (int i = 0; i < kProducers; ++i)
+    {
+        threads.push_back(new Thread(boost::bind(mpmcProducer, &queue, i), "producer"));
+    }
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+        threads[i].start();
+    }
+    for (int i = kConsumers; i < kConsumers + kProducers; ++i)
+    {
+        threads[i].join();
+    }
+    for (int i = 0; i < kConsumers; ++i)
+    {
+        queue.put(-1);
+    }
+    for (int i = 0; i < kConsumers; ++i)
+    {
+        threads[i].join();
+    }
+
+    std::vector<char> seen(kProducers * kItemsPerProducer, 0);
+    long long count = 0;
+    long long sum = 0;
+    for (int c = 0; c < kConsumers; ++c)
+    {
+        std::vector<int> last(kProducers, -1);
+        for (size_t i = 0; i < received[c].size(); ++i)
+        {
+            int x = received[c][i];
+            ++count;
+            sum += x;
+            ++seen[x];
+            // 同一个生产者的数据, 被同一个消费者取到的顺序与放入顺序一致
+            int producer = x / kItemsPerProducer;
+            BOOST_REQUIRE_MESSAGE(x > last[producer], "per-producer order at " << x);
+            last[producer] = x;
+        }
+    }
+    long long n = kProducers * kItemsPerProducer;
+    BOOST_CHECK_EQUAL(count, n);
+    BOOST_CHECK_EQUAL(sum, n * (n - 1) / 2);
+    BOOST_CHECK_EQUAL(std::count(seen.begin(), seen.end(), 1), n);
+}
+
+namespace
+{
+
+void mpscProducer(MpscQueue<int>* queue, int id)
+{
+    for (int i = 0; i < kItemsPerProducer; ++i)
+    {
+        queue->put(id * kItemsPerProducer + i);
+    }
+}
+
+}   // namespace
+
+BOOST_AUTO_TEST_CASE(testMpscExactlyOnce)
+{
+    // 节点在生产者和消费者之间反复复用
+    MpscQueue<int> queue;
+    boost::ptr_vector<Thread> threads;
+    for (int i = 0; i < kProducers; ++i)
+    {
+        threads.push_back(new Thread(boost::bind(mpscProducer, &queue, i), "producer"));
+        threads.back().start();
+    }
+
+    long long n = kProducers * kItemsPerProducer;
+    std::vector<char> seen(n, 0);
+    std::vector<int> last(kProducers, -1);
+    long long count = 0;
+    while (count < n)
+    {
+        int x = 0;
+        if (!queue.take(&x))
+        {
+            continue;
+        }
+        ++count;
+        ++seen[x];
+        int producer = x / kItemsPerProducer;
+        BOOST_REQUIRE_MESSAGE(x > last[producer], "per-producer order at " << x);
+        last[producer] = x;
+    }
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+        threads[i].join();
+    }
+    int x = 0;
+    BOOST_CHECK(!queue.take(&x));
+    BOOST_CHECK_EQUAL(std::count(seen.begin(), seen.end(), 1), n);
+}
+
+BOOST_AUTO_TEST_CASE(testMpscReleasesValue)
+{
+    // 复用的节点不应继续持有已取出的值
+    MpscQueue<boost::shared_ptr<int> > queue;
+    boost::shared_ptr<int> p(new int(42));
+    for (int i = 0; i < 3; ++i)
+    {
+        queue.put(p);
+        boost::shared_ptr<int> x;
+        BOOST_REQUIRE(queue.take(&x));
+        BOOST_CHECK_EQUAL(x.get(), p.get());
+        x.reset();
+        BOOST_CHECK_EQUAL(p.use_count(), 1);
+    }
+}
+
+namespace
+{
+
+int g_taken = 0;
+int g_put = 0;
+
+void parkedConsumer(MpmcBlockingQueue<int>* queue)
+{
+    queue->take();
+    __atomic_add_fetch(&g_taken, 1, __ATOMIC_RELEASE);
+}
+
+void parkedSpscConsumer(SpscBlockingQueue<int>* queue)
+{
+    queue->take();
+    __atomic_add_fetch(&g_taken, 1, __ATOMIC_RELEASE);
+}
+
+void parkedProducer(MpmcBlockingQueue<int>* queue)
+{
+    queue->put(1);
+    __atomic_add_fetch(&g_put, 1, __ATOMIC_RELEASE);
+}
+
+}   // namespace
+
+BOOST_AUTO_TEST_CASE(testWakeup)
+{
+    // 空队列上睡眠的消费者被put唤醒
+    {
+        g_taken = 0;
+        MpmcBlockingQueue<int> queue(4);
+        Thread consumer(boost::bind(parkedConsumer, &queue), "consumer");
+        consumer.start();
+        ::usleep(100 * 1000);           // 足够自旋结束并进入futex等待
+        BOOST_CHECK_EQUAL(g_taken, 0);
+        queue.put(1);
+        BOOST_CHECK(waitFor(&g_taken, 1));
+        consumer.join();
+    }
+    {
+        g_taken = 0;
+        SpscBlockingQueue<int> queue(4);
+        Thread consumer(boost::bind(parkedSpscConsumer, &queue), "consumer");
+        consumer.start();
+        ::usleep(100 * 1000);
+        BOOST_CHECK_EQUAL(g_taken, 0);
+        queue.put(1);
+        BOOST_CHECK(waitFor(&g_taken, 1));
+        consumer.join();
+    }
+
+    // 满队列上睡眠的生产者被take唤醒, 每取走一个放入一个
+    {
+        g_put = 0;
+        MpmcBlockingQueue<int> queue(4);
+        for (size_t i = 0; i < queue.capacity(); ++i)
+        {
+            queue.put(0);
+        }
+        boost::ptr_vector<Thread> producers;
+        for (int i = 0; i < 2; ++i)
+        {
+            producers.push_back(new Thread(boost::bind(parkedProducer, &queue), "producer"));
+            producers.back().start();
+        }
+        ::usleep(100 * 1000);
+        BOOST_CHECK_EQUAL(g_put, 0);
+        queue.take();
+        BOOST_CHECK(waitFor(&g_put, 1));
+        ::usleep(10 * 1000);
+        BOOST_CHECK_EQUAL(g_put, 1);       // 只空出一个位置
+        queue.take();
+        BOOST_CHECK(waitFor(&g_put, 2));
+        for (int i = 0; i < 2; ++i)
+        {
+            producers[i].join();
+        }
+        BOOST_CHECK_EQUAL(queue.size(), queue.capacity());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(testMpmcCapacityOne)
+{
+    // 容量为1时序号算法无法区分满和空, 实际容量至少为2
+    MpmcBlockingQueue<int> queue(1);
+    BOOST_CHECK_EQUAL(queue.capacity(), 2u);
+    BOOST_CHECK(queue.tryPut(1));
+    BOOST_CHECK(queue.tryPut(2));
+    BOOST_CHECK(!queue.tryPut(3));
+    int x = 0;
+    BOOST_CHECK(queue.tryTake(&x));
+    BOOST_CHECK_EQUAL(x, 1);
+    BOOST_CHECK(queue.tryTake(&x));
+    BOOST_CHECK_EQUAL(x, 2);
+    BOOST_CHECK(!queue.tryTake(&x));
+
+    MpmcBlockingQueue<int> zero(0);
+    BOOST_CHECK_EQUAL(zero.capacity(), 2u);
+    BOOST_CHECK(zero.tryPut(1));
+    BOOST_CHECK(zero.tryPut(2));
+    BOOST_CHECK(!zero.tryPut(3));
+}
\ No newline at end of file
@@ -1,6 +1,7 @@
 ﻿#include <muduo/base/LogStream.h>
 #include <muduo/base/Timestamp.h>
 
+#include <algorithm>
 #include <sstream>
 #include <stdio.h>
 #define __STDC_FORMAT_MACROS
@@ -60,6 +61,75 @@ void benchLogStream()
     printf("benchLogStream %f\n", timeDifference(end, start));
 }
 
+template<typename T>
+void benchLogStreamScaled(double scale)
+{
+    Timestamp start(Timestamp::now());
+    LogStream os;
+    for (size_t i = 0; i < N; ++i)
+    {
+        os << (T)((double)(i) * scale);
+        os.resetBuffer();
+    }
+    Timestamp end(Timestamp::now());
+
+    printf("benchLogStream %f\n", timeDifference(end, start));
+}
+
+// 改用查表两位一次和Grisu2之前LogStream的实现, 用作对比
+const char digits[] = "9876543210123456789";
+const char* zero = digits + 9;
+
+template<typename T>
+size_t convertOld(char buf[], T value)
+{
+    T i = value;
+    char* p = buf;
+
+    do
+    {
+        int lsd = static_cast<int>(i % 10);
+        i /= 10;
+        *p++ = zero[lsd];
+    } while (i != 0);
+
+    if (value < 0)
+    {
+        *p++ = '-';
+    }
+    *p = '\0';
+    std::reverse(buf, p);
+
+    return p - buf;
+}
+
+volatile size_t g_sink;     // 防止结果没被使用而整个循环被优化掉
+
+template<typename T>
+void benchOldConvert(double scale = 1.0)
+{
+    char buf[32];
+    size_t total = 0;
+    Timestamp start(Timestamp::now());
+    for (size_t i = 0; i < N; ++i)
+        total += convertOld(buf, (T)((double)(i) * scale));
+    Timestamp end(Timestamp::now());
+    g_sink = total;
+
+    printf("benchOldConvert %f\n", timeDifference(end, start));
+}
+
+void benchPrintfDouble(const char* fmt, double scale)
+{
+    char buf[32];
+    Timestamp start(Timestamp::now());
+    for (size_t i = 0; i < N; ++i)
+        snprintf(buf, sizeof buf, fmt, (double)(i) * scale);
+    Timestamp end(Timestamp::now());
+
+    printf("benchPrintf(%s) %f\n", fmt, timeDifference(end, start));
+}
+
 int main()
 {
     benchPrintf<int>("%d");
@@ -67,6 +137,7 @@ int main()
     puts("int");
     benchPrintf<int>("%d");
     benchStringStream<int>();
+    benchOldConvert<int>();
     benchLogStream<int>();
 
     puts("double");
@@ -74,11 +145,27 @@ int main()
     benchStringStream<double>();
     benchLogStream<double>();
 
+    // 带小数的值才能体现浮点格式化的差别, "%.17g"是snprintf保证读回原值的写法
+    puts("double (i * 0.001)");
+    benchPrintfDouble("%.12g", 0.001);
+    benchPrintfDouble("%.17g", 0.001);
+    benchLogStreamScaled<double>(0.001);
+
+    puts("double (i * 3.14159e-7)");
+    benchPrintfDouble("%.12g", 3.14159e-7);
+    benchPrintfDouble("%.17g", 3.14159e-7);
+    benchLogStreamScaled<double>(3.14159e-7);
+
     puts("int64_t");
     benchPrintf<int64_t>("%" PRId64);
     benchStringStream<int64_t>();
+    benchOldConvert<int64_t>();
     benchLogStream<int64_t>();
 
+    puts("int64_t (large)");
+    benchOldConvert<int64_t>(1e9);
+    benchLogStreamScaled<int64_t>(1e9);
+
     puts("void*");
     benchPrintf<void*>("%p");
     benchStringStream<void*>();
@@ -2,6 +2,8 @@
 
 #include <limits>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
 //#define BOOST_TEST_MODULE LogStreamTest
 #define BOOST_TEST_MAIN
@@ -150,8 +152,8 @@ BOOST_AUTO_TEST_CASE(testLogStreamFloats)
     BOOST_CHECK_EQUAL(buf.asString(), string("0.15"));
     os.resetBuffer();
 
-    os << a + b;
-    BOOST_CHECK_EQUAL(buf.asString(), string("0.15"));
+    os << a + b;    // 最短的能读回原值的表示
+    BOOST_CHECK_EQUAL(buf.asString(), string("0.15000000000000002"));
     os.resetBuffer();
 
     BOOST_CHECK(a + b != c);
@@ -167,6 +169,37 @@ BOOST_AUTO_TEST_CASE(testLogStreamFloats)
     os << -123.456;
     BOOST_CHECK_EQUAL(buf.asString(), string("-123.456"));
     os.resetBuffer();
+
+    os << 1e20 << ' ' << 1e-5 << ' ' << 5e-324 << ' ' << -0.0;
+    BOOST_CHECK_EQUAL(buf.asString(), string("1e+20 1e-05 5e-324 -0"));
+    os.resetBuffer();
+
+    os << 0.1f << ' ' << 3.14159f;
+    BOOST_CHECK_EQUAL(buf.asString(), string("0.1 3.14159"));
+    os.resetBuffer();
+
+    os << std::numeric_limits<double>::max();
+    BOOST_CHECK_EQUAL(buf.asString(), string("1.7976931348623157e+308"));
+    os.resetBuffer();
+
+    // 输出总能被strtod读回同一个值
+    uint64_t bits = 88172645463325252ULL;
+    for (int i = 0; i < 100000; ++i)
+    {
+        bits ^= bits << 13;
+        bits ^= bits >> 7;
+        bits ^= bits << 17;
+        double v;
+        memcpy(&v, &bits, sizeof v);
+        if (v != v)
+        {
+            continue;
+        }
+        os << v;
+        double back = strtod(buf.asString().c_str(), NULL);
+        BOOST_CHECK(memcmp(&back, &v, sizeof v) == 0);
+        os.resetBuffer();
+    }
 }
 
 BOOST_AUTO_TEST_CASE(testLogStreamVoid)
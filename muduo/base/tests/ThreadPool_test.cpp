@@ -1,9 +1,12 @@
 ﻿#include <muduo/base/ThreadPool.h>
+#include <muduo/base/Atomic.h>
 #include <muduo/base/CountDownLatch.h>
 #include <muduo/base/CurrentThread.h>
 
 #include <boost/bind.hpp>
+#include <assert.h>
 #include <stdio.h>
+#include <unistd.h>
 
 void print()
 {
@@ -15,6 +18,94 @@ void printString(const std::string& str)
     printf("tid=%d, str=%s\n", muduo::CurrentThread::tid(), str.c_str());
 }
 
+void slow()
+{
+    usleep(1000);
+}
+
+int g_rejected = 0;     // 拒绝回调在提交线程中执行, 不需要加锁
+pid_t g_callerTid = 0;
+muduo::AtomicInt32 g_callerRan;     // 在提交线程中执行的任务数
+
+void slowRecordingThread()
+{
+    if (muduo::CurrentThread::tid() == g_callerTid)
+    {
+        g_callerRan.increment();
+    }
+    slow();
+}
+
+void onReject(const muduo::ThreadPool::Task&)
+{
+    ++g_rejected;
+}
+
+// 队列长度为maxSize的线程池在各拒绝策略下的行为
+void testBounded(muduo::ThreadPool::RejectPolicy policy)
+{
+    muduo::ThreadPool pool("BoundedThreadPool");
+    pool.setMaxQueueSize(5);
+    pool.setRejectPolicy(policy);
+    pool.setRejectCallback(onReject);
+    pool.start(2);
+
+    g_rejected = 0;
+    g_callerTid = muduo::CurrentThread::tid();
+    g_callerRan.getAndSet(0);
+    for (int i = 0; i < 100; ++i)
+    {
+        pool.run(slowRecordingThread);
+    }
+    bool accepted = true;
+    for (int i = 0; i < 100 && accepted; ++i)
+    {
+        accepted = pool.tryRun(slow);
+    }
+    muduo::CountDownLatch latch(1);
+    while (!pool.tryRun(boost::bind(&muduo::CountDownLatch::countDown, &latch)))
+    {
+        usleep(100);
+    }
+    latch.wait();
+
+    muduo::ThreadPool::Stats s = pool.stats();
+    printf("policy=%d submitted=%lld executed=%lld rejected=%lld tryRunFailures=%lld "
+           "callerRuns=%lld peak=%zu avgLatency=%.6f maxLatency=%.6f callbacks=%d callerRan=%d\n",
+           policy, static_cast<long long>(s.submitted), static_cast<long long>(s.executed),
+           static_cast<long long>(s.rejected), static_cast<long long>(s.tryRunFailures),
+           static_cast<long long>(s.callerRuns), s.peakQueueSize,
+           s.avgQueueLatency, s.maxQueueLatency, g_rejected, g_callerRan.get());
+    assert(s.peakQueueSize <= 5);
+    assert(!accepted);
+    assert(s.tryRunFailures > 0);   // tryRun失败单独计数, 不受策略影响
+    switch (policy)
+    {
+    case muduo::ThreadPool::kBlock:
+        assert(s.rejected == 0);
+        assert(s.callerRuns == 0 && g_callerRan.get() == 0);
+        break;
+    case muduo::ThreadPool::kReject:
+        assert(s.rejected > 0);
+        assert(g_rejected == s.rejected);
+        assert(s.callerRuns == 0 && g_callerRan.get() == 0);
+        break;
+    case muduo::ThreadPool::kCallerRuns:
+        assert(s.rejected == 0 && g_rejected == 0);
+        assert(s.callerRuns > 0);
+        assert(g_callerRan.get() == s.callerRuns);
+        break;
+    case muduo::ThreadPool::kDiscardOldest:
+        assert(s.rejected > 0);
+        assert(g_rejected == s.rejected);
+        // 最后入队的latch任务已执行, 队列为空, 每个入队的任务不是执行了就是被丢弃了
+        assert(s.queueSize == 0);
+        assert(s.submitted == s.executed + s.rejected);
+        break;
+    }
+    pool.stop();
+}
+
 int main()
 {
     muduo::ThreadPool pool("MainThreadPool");
@@ -39,4 +130,9 @@ int main()
     pool.run(boost::bind(&muduo::CountDownLatch::countDown, &latch));
     latch.wait();
     pool.stop();
+
+    testBounded(muduo::ThreadPool::kBlock);
+    testBounded(muduo::ThreadPool::kReject);
+    testBounded(muduo::ThreadPool::kCallerRuns);
+    testBounded(muduo::ThreadPool::kDiscardOldest);
 }
\ No newline at end of file
@@ -0,0 +1,124 @@
+﻿#include <muduo/base/CoarseClock.h>
+#include <muduo/base/TimeZone.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+//#define BOOST_TEST_MODULE TimeZoneTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+namespace CoarseClock = muduo::CoarseClock;
+using muduo::string;
+using muduo::TimeZone;
+using muduo::Timestamp;
+
+namespace
+{
+
+bool sameTm(const struct tm& a, const struct tm& b)
+{
+    return a.tm_year == b.tm_year && a.tm_mon == b.tm_mon && a.tm_mday == b.tm_mday
+        && a.tm_hour == b.tm_hour && a.tm_min == b.tm_min && a.tm_sec == b.tm_sec
+        && a.tm_wday == b.tm_wday && a.tm_yday == b.tm_yday;
+}
+
+// 与设置了TZ环境变量的localtime_r对比
+void checkZone(const char* name)
+{
+    char zonefile[256];
+    snprintf(zonefile, sizeof zonefile, "/usr/share/zoneinfo/%s", name);
+    TimeZone tz(zonefile);
+    if (!tz.valid())
+    {
+        BOOST_TEST_MESSAGE("skip " << name << ", no zone file");
+        return;
+    }
+    setenv("TZ", name, 1);
+    tzset();
+
+    // 32位tzfile时间的范围, 其后的规则来自文件末尾的POSIX TZ串
+    for (time_t t = -2000000000; t < 2100000000; t += 3600 * 7 + 61)
+    {
+        struct tm expected;
+        ::localtime_r(&t, &expected);
+        struct tm local = tz.toLocalTime(t);
+        BOOST_REQUIRE_MESSAGE(sameTm(expected, local), name << " toLocalTime at " << t);
+        BOOST_REQUIRE_EQUAL(expected.tm_gmtoff, local.tm_gmtoff);
+        BOOST_REQUIRE_EQUAL(expected.tm_isdst, local.tm_isdst);
+        BOOST_REQUIRE_EQUAL(string(expected.tm_zone), string(local.tm_zone));
+
+        // 切换前后一小时内的本地时间可能重复或不存在, 其余都能换算回来
+        struct tm before = tz.toLocalTime(t - 3600);
+        struct tm after = tz.toLocalTime(t + 3600);
+        if (before.tm_gmtoff == local.tm_gmtoff && after.tm_gmtoff == local.tm_gmtoff)
+        {
+            BOOST_REQUIRE_EQUAL(tz.fromLocalTime(local), t);
+        }
+    }
+}
+
+}   // namespace
+
+// 与glibc的gmtime_r/timegm对比, 覆盖1970年前后
+BOOST_AUTO_TEST_CASE(testUtc)
+{
+    for (time_t t = -5000000000; t < 5000000000; t += 86399 * 7 + 3601)
+    {
+        struct tm expected;
+        ::gmtime_r(&t, &expected);
+        struct tm utc = TimeZone::toUtcTime(t);
+        BOOST_REQUIRE_MESSAGE(sameTm(expected, utc), "toUtcTime at " << t);
+        BOOST_REQUIRE_EQUAL(TimeZone::fromUtcTime(utc), t);
+    }
+    BOOST_CHECK_EQUAL(TimeZone::fromUtcTime(2000, 3, 1, 0, 0, 0), 951868800);
+}
+
+BOOST_AUTO_TEST_CASE(testZoneFiles)
+{
+    checkZone("America/New_York");
+    checkZone("Europe/London");
+    checkZone("Asia/Shanghai");
+    checkZone("Australia/Sydney");
+}
+
+BOOST_AUTO_TEST_CASE(testFixed)
+{
+    TimeZone tz(8 * 3600, "CST");
+    struct tm local = tz.toLocalTime(0);
+    BOOST_CHECK_EQUAL(local.tm_hour, 8);
+    BOOST_CHECK_EQUAL(local.tm_gmtoff, 8 * 3600);
+    BOOST_CHECK_EQUAL(string(local.tm_zone), string("CST"));
+    BOOST_CHECK_EQUAL(tz.fromLocalTime(local), 0);
+    BOOST_CHECK(!TimeZone("/nonexistent").valid());
+}
+
+BOOST_AUTO_TEST_CASE(testCoarseClock)
+{
+    Timestamp now(Timestamp::now());
+    time_t seconds = static_cast<time_t>(now.microSecondsSinceEpoch() / Timestamp::kMicroSecondsPerSecond);
+    char buf[CoarseClock::kSecondLength] = { 0 };
+    CoarseClock::update(now);
+    BOOST_CHECK(CoarseClock::now() == now);
+    BOOST_CHECK(CoarseClock::formatUtc(seconds, buf));
+    BOOST_CHECK(!CoarseClock::formatUtc(seconds + 2, buf));     // 不是当前这一秒
+
+    char expected[32];
+    struct tm tm_time;
+    ::gmtime_r(&seconds, &tm_time);
+    strftime(expected, sizeof expected, "%Y%m%d %H:%M:%S", &tm_time);
+    BOOST_CHECK_EQUAL(string(buf, CoarseClock::kSecondLength), string(expected));
+    BOOST_CHECK_EQUAL(now.toFormattedString().substr(0, CoarseClock::kSecondLength), string(expected));
+
+    CoarseClock::setTimeZone(TimeZone(8 * 3600, "CST"));
+    CoarseClock::update(now);
+    BOOST_CHECK(CoarseClock::formatLocal(seconds, buf));
+    time_t shifted = seconds + 8 * 3600;
+    ::gmtime_r(&shifted, &tm_time);
+    strftime(expected, sizeof expected, "%Y%m%d %H:%M:%S", &tm_time);
+    BOOST_CHECK_EQUAL(string(buf, CoarseClock::kSecondLength), string(expected));
+    CoarseClock::setTimeZone(TimeZone());
+}
\ No newline at end of file
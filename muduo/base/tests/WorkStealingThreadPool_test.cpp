@@ -0,0 +1,103 @@
+﻿#include <muduo/base/WorkStealingThreadPool.h>
+#include <muduo/base/ThreadPool.h>
+#include <muduo/base/Atomic.h>
+#include <muduo/base/CountDownLatch.h>
+#include <muduo/base/Timestamp.h>
+
+#include <boost/bind.hpp>
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+muduo::AtomicInt64 g_sum;
+
+void work(int n)
+{
+    int64_t x = 0;
+    for (int i = 0; i < n; ++i)
+    {
+        x += i % 7;
+    }
+    g_sum.add(x);
+}
+
+void workAndCountDown(muduo::CountDownLatch* latch)
+{
+    work(1000);
+    latch->countDown();
+}
+
+// 在工作线程中递归提交子任务, 测试本地提交与窃取
+void spawn(muduo::WorkStealingThreadPool* pool, muduo::CountDownLatch* latch, int depth)
+{
+    if (depth == 0)
+    {
+        work(1000);
+        latch->countDown();
+        return;
+    }
+    pool->run(boost::bind(spawn, pool, latch, depth - 1));
+    pool->run(boost::bind(spawn, pool, latch, depth - 1));
+}
+
+template<typename Pool>
+double bench(Pool* pool, int numTasks)
+{
+    muduo::CountDownLatch latch(numTasks);
+    muduo::Timestamp start(muduo::Timestamp::now());
+    for (int i = 0; i < numTasks; ++i)
+    {
+        pool->run(boost::bind(workAndCountDown, &latch));
+    }
+    latch.wait();
+    return timeDifference(muduo::Timestamp::now(), start);
+}
+
+int main(int argc, char* argv[])
+{
+    int numThreads = argc > 1 ? atoi(argv[1]) : 4;
+    const int kTasks = 100 * 1000;
+
+    {
+        muduo::ThreadPool pool("ThreadPool");
+        pool.start(numThreads);
+        printf("ThreadPool             %d threads %.3fs\n", numThreads, bench(&pool, kTasks));
+    }
+
+    {
+        muduo::WorkStealingThreadPool pool("WorkStealingThreadPool");
+        pool.start(numThreads);
+        printf("WorkStealingThreadPool %d threads %.3fs\n", numThreads, bench(&pool, kTasks));
+
+        std::vector<muduo::WorkStealingThreadPool::Task> batch;
+        muduo::CountDownLatch latch(1000);
+        for (int i = 0; i < 1000; ++i)
+        {
+            batch.push_back(boost::bind(&muduo::CountDownLatch::countDown, &latch));
+        }
+        pool.run(batch);
+        latch.wait();
+
+        const int kDepth = 12;
+        muduo::CountDownLatch leaves(1 << kDepth);
+        g_sum.getAndSet(0);
+        pool.run(boost::bind(spawn, &pool, &leaves, kDepth));
+        leaves.wait();
+        int64_t expected = 0;
+        for (int i = 0; i < 1000; ++i)
+        {
+            expected += i % 7;
+        }
+        expected <<= kDepth;
+        printf("spawn sum=%lld expected=%lld\n", static_cast<long long>(g_sum.get()), static_cast<long long>(expected));
+        assert(g_sum.get() == expected);
+        pool.stop();
+    }
+
+    muduo::WorkStealingThreadPool inlinePool;
+    inlinePool.start(0);
+    muduo::CountDownLatch latch(1);
+    inlinePool.run(boost::bind(&muduo::CountDownLatch::countDown, &latch));
+    assert(latch.getCount() == 0);
+    (void) latch;
+}
\ No newline at end of file
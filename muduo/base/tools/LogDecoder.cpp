@@ -0,0 +1,56 @@
+﻿#include <muduo/base/BinaryLog.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+/*
+    muduo_logdecoder [file ...]
+    把含有二进制日志记录的文件还原为文本输出到标准输出, 没有参数时读标准输入
+    日志文件开头带有BinaryLog::siteTable时每个文件可以单独解码,
+    否则应从第一个文件开始按顺序一起解码
+*/
+
+using namespace muduo;
+
+int decodeFile(FILE* fp, BinaryLogDecoder* decoder)
+{
+    char buf[64 * 1024];
+    string pending;     // 上次未解码完的不完整记录
+    string out;
+    size_t n = 0;
+    while ((n = fread(buf, 1, sizeof buf, fp)) > 0)
+    {
+        pending.append(buf, n);
+        size_t consumed = decoder->decode(pending.data(), pending.size(), &out);
+        pending.erase(0, consumed);
+        fwrite(out.data(), 1, out.size(), stdout);
+        out.clear();
+    }
+    decoder->decode(pending.data(), pending.size(), &out, true);
+    fwrite(out.data(), 1, out.size(), stdout);
+    return ferror(fp) ? 1 : 0;
+}
+
+int main(int argc, char* argv[])
+{
+    BinaryLogDecoder decoder;
+    if (argc < 2)
+    {
+        return decodeFile(stdin, &decoder);
+    }
+    int ret = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        FILE* fp = fopen(argv[i], "rb");
+        if (fp == NULL)
+        {
+            fprintf(stderr, "cannot open %s: %s\n", argv[i], strerror_tl(errno));
+            ret = 1;
+            continue;
+        }
+        ret |= decodeFile(fp, &decoder);
+        fclose(fp);
+    }
+    return ret;
+}
\ No newline at end of file
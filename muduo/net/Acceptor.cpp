@@ -1,5 +1,6 @@
 ﻿#include <muduo/net/Acceptor.h>
 
+#include <muduo/base/Logging.h>
 #include <muduo/net/EventLoop.h>
 #include <muduo/net/InetAddress.h>
 #include <muduo/net/SocketsOps.h>
@@ -14,19 +15,30 @@
 using namespace muduo;
 using namespace muduo::net;
 
-Acceptor::Acceptor(EventLoop* loop, const InetAddress& listenAddr)
+namespace
+{
+const int kDefaultAcceptBurst = 32;
+}
+
+Acceptor::Acceptor(EventLoop* loop, const InetAddress& listenAddr, bool reuseport)
     : loop_(loop),
     acceptSocket_(sockets::createNonblockingOrDie()),
     acceptChannel_(loop, acceptSocket_.fd()),
     listenning_(false),
-    idleFd_(::open("/dev/null", O_RDONLY | O_CLOEXEC))  // 预先准备一个套接字
+    idleFd_(::open("/dev/null", O_RDONLY | O_CLOEXEC)),  // 预先准备一个套接字
+    acceptBurst_(kDefaultAcceptBurst),
+    acceptedTotal_(0),
+    rateSecond_(0),
+    acceptedInSecond_(0),
+    lastRate_(0)
 {
     assert(idleFd_ >= 0);
     acceptSocket_.setReuseAddr(true);           // 设置地址重复利用
+    acceptSocket_.setReusePort(reuseport);      // 多个Acceptor绑定同一端口
     acceptSocket_.bindAddress(listenAddr);      // 绑定
     acceptChannel_.setReadCallback(             // 设置读回调函数
-        boost::bind(&Acceptor::handleRead, this));  // 有些疑问, void setReadCallback(const ReadEventCallback& cb)回调函数类型应该是Timestamp
-}                                                   // typedef boost::function<void(Timestamp)> ReadEventCallback;
+        boost::bind(&Acceptor::handleRead, this, _1));
+}
 
 Acceptor::~Acceptor()
 {
@@ -40,39 +52,122 @@ void Acceptor::listen()
     loop_->assertInLoopThread();    // 断言在IO线程中
     listenning_ = true;
     acceptSocket_.listen();
+    if (loop_->supportsCompletion())
+    {
+        acceptChannel_.setCompletion(Channel::kCompleteAccept);    // 由poller提交multishot accept
+    }
     acceptChannel_.enableReading(); // 关注可读事件
 }
 
-void Acceptor::handleRead()
+// 监听套接字是电平触发, 每次可读事件最多accept acceptBurst_个连接, 剩余的下一轮poll继续处理,
+// 避免连接洪峰时每个连接都要经过一次poll, 又不会让accept饿死已连接套接字的IO
+void Acceptor::handleRead(Timestamp receiveTime)
 {
     loop_->assertInLoopThread();
-    InetAddress peerAddr(0);        // 对等端地址 
-    //FIXME loop until no more
-    int connfd = acceptSocket_.accept(&peerAddr);
-    if (connfd >= 0)
+    if (acceptChannel_.completion() != Channel::kNoCompletion)
     {
-        // string hostport = peerAddr.toIpPort();
-        // LOG_TRACE << "Accepts of " << hostport;
-        if (newConnectionCallback_)
+        handleAccepted(receiveTime);
+        return;
+    }
+    int accepted = 0;
+    while (accepted < acceptBurst_)
+    {
+        InetAddress peerAddr(0);    // 对等端地址
+        int connfd = acceptSocket_.accept(&peerAddr);   // accept4, 已设置SOCK_NONBLOCK|SOCK_CLOEXEC
+        if (connfd < 0)
         {
-            newConnectionCallback_(connfd, peerAddr);   // 回调上层用户回调函数
+            // Read the section named "The special problem of
+            // accept()ing when you can't" in libev's doc.
+            // By Marc Lehmann, author of livev.
+            if (errno == EMFILE)    // 文件描述符使用完, 使用电平触发, 若不处理会一直触发
+            {
+                handleEmfile();
+            }
+            break;                  // EAGAIN: 已取完
         }
-        else
+        ++accepted;
+        // string hostport = peerAddr.toIpPort();
+        // LOG_TRACE << "Accepts of " << hostport;
+        newConnection(connfd, peerAddr);
+    }
+    updateAcceptRate(receiveTime, accepted);
+}
+
+// poller已经接受的连接, multishot accept不带对端地址
+void Acceptor::handleAccepted(Timestamp receiveTime)
+{
+    const Channel::CompletionList& results = acceptChannel_.completions();
+    int accepted = 0;
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        int connfd = results[i].result;
+        if (connfd < 0)
         {
-            sockets::close(connfd);                     // 没有设置回调函数把文件描述符关闭
+            errno = -connfd;
+            if (errno == EMFILE)
+            {
+                handleEmfile();
+            }
+            else
+            {
+                LOG_SYSERR << "Acceptor::handleAccepted";
+            }
+            continue;
         }
+        ++accepted;
+        newConnection(connfd, InetAddress(sockets::getPeerAddr(connfd)));
+    }
+    updateAcceptRate(receiveTime, accepted);
+}
+
+// 接受并立即关闭一个连接, 否则监听套接字一直可读
+void Acceptor::handleEmfile()
+{
+    ::close(idleFd_);                                       // 把空闲文件描述符关闭, 腾出文件描述符
+    idleFd_ = ::accept(acceptSocket_.fd(), NULL, NULL);     // 这时可接收
+    ::close(idleFd_);                                       // 关闭
+    idleFd_ = ::open("/dev/null", O_RDONLY | O_CLOEXEC);    // 继续等于空闲文件描述符
+}
+
+void Acceptor::newConnection(int connfd, const InetAddress& peerAddr)
+{
+    if (newConnectionCallback_)
+    {
+        newConnectionCallback_(connfd, peerAddr);   // 回调上层用户回调函数
     }
     else
     {
-        // Read the section named "The special problem of
-        // accept()ing when you can't" in libev's doc.
-        // By Marc Lehmann, author of livev.
-        if (errno == EMFILE)    // 文件描述符使用完, 使用电平触发, 若不处理会一直触发
-        {
-            ::close(idleFd_);                                       // 把空闲文件描述符关闭, 腾出文件描述符
-            idleFd_ = ::accept(acceptSocket_.fd(), NULL, NULL);     // 这时可接收
-            ::close(idleFd_);                                       // 关闭
-            idleFd_ = ::open("/dev/null", O_RDONLY | O_CLOEXEC);    // 继续等于空闲文件描述符
-        }
+        sockets::close(connfd);                     // 没有设置回调函数把文件描述符关闭
+    }
+}
+
+void Acceptor::updateAcceptRate(Timestamp receiveTime, int accepted)
+{
+    int64_t second = receiveTime.microSecondsSinceEpoch() / Timestamp::kMicroSecondsPerSecond;
+    if (second != rateSecond_)
+    {
+        // 跨过了整秒, 上一秒的计数成为速率; 中间有空闲的秒则速率为0
+        int64_t rate = second == rateSecond_ + 1 ? acceptedInSecond_ : 0;
+        __atomic_store_n(&lastRate_, rate, __ATOMIC_RELAXED);
+        __atomic_store_n(&rateSecond_, second, __ATOMIC_RELAXED);
+        acceptedInSecond_ = 0;
+    }
+    __atomic_store_n(&acceptedInSecond_, acceptedInSecond_ + accepted, __ATOMIC_RELAXED);
+    __atomic_store_n(&acceptedTotal_, acceptedTotal_ + accepted, __ATOMIC_RELAXED);
+}
+
+int64_t Acceptor::acceptRate() const
+{
+    // 一段时间没有新连接时rateSecond_不再更新, 按当前时间判断速率是否过期
+    int64_t now = Timestamp::now().microSecondsSinceEpoch() / Timestamp::kMicroSecondsPerSecond;
+    int64_t second = __atomic_load_n(&rateSecond_, __ATOMIC_RELAXED);
+    if (now == second)
+    {
+        return __atomic_load_n(&lastRate_, __ATOMIC_RELAXED);
+    }
+    else if (now == second + 1)
+    {
+        return __atomic_load_n(&acceptedInSecond_, __ATOMIC_RELAXED);
     }
+    return 0;
 }
\ No newline at end of file
@@ -24,7 +24,7 @@ class Acceptor : boost::noncopyable
 public:
     typedef boost::function<void(int sockfd, const InetAddress&)> NewConnectionCallback;
 
-    Acceptor(EventLoop* loop, const InetAddress& listenAddr);
+    Acceptor(EventLoop* loop, const InetAddress& listenAddr, bool reuseport = false);
     ~Acceptor();
 
     void setNewConnectionCallback(const NewConnectionCallback& cb)
@@ -32,11 +32,28 @@ public:
         newConnectionCallback_ = cb;
     }
 
+    /// At most @c burst connections are accepted per readable event,
+    /// 1 restores one accept per poll round-trip.
+    /// Ignored when the poller accepts itself, see Channel::setCompletion.
+    void setAcceptBurst(int burst) { acceptBurst_ = burst > 0 ? burst : 1; }
+
+    /// Connections accepted in the last whole second, thread safe.
+    int64_t acceptRate() const;
+    /// Connections accepted since construction, thread safe.
+    int64_t acceptedTotal() const { return __atomic_load_n(&acceptedTotal_, __ATOMIC_RELAXED); }
+
+    /// see Socket::setIncomingCpu, must be called before listen()
+    void setIncomingCpu(int cpu) { acceptSocket_.setIncomingCpu(cpu); }
+
     bool listenning() const { return listenning_; } // acceptChannel_.enableReading 关注可读事件
     void listen();
 
 private:
-    void handleRead();
+    void handleRead(Timestamp receiveTime);
+    void handleAccepted(Timestamp receiveTime);
+    void handleEmfile();
+    void newConnection(int connfd, const InetAddress& peerAddr);
+    void updateAcceptRate(Timestamp receiveTime, int accepted);
 
     EventLoop   *loop_;             // acceptChannel_所属的EventLoop
     Socket      acceptSocket_;      // 监听套接字   
@@ -44,6 +61,12 @@ private:
     NewConnectionCallback newConnectionCallback_;
     bool        listenning_;
     int         idleFd_;            // 预先准备一个空闲的文件描述符
+    int         acceptBurst_;       // 每次可读事件最多accept的连接数
+    // 以下只在loop线程中修改, 其它线程只读
+    int64_t     acceptedTotal_;     // 累计accept的连接数
+    int64_t     rateSecond_;        // acceptedInSecond_所属的秒
+    int64_t     acceptedInSecond_;  // rateSecond_这一秒内accept的连接数
+    int64_t     lastRate_;          // rateSecond_之前一秒accept的连接数
 };
 
 }       // namespace net
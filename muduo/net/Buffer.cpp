@@ -1,7 +1,10 @@
 ﻿#include <muduo/net/Buffer.h>
 
+#include <muduo/net/EventLoop.h>
 #include <muduo/net/SocketsOps.h>
 
+#include <boost/static_assert.hpp>
+
 #include <errno.h>
 #include <sys/uio.h>
 
@@ -13,14 +16,28 @@ const char Buffer::kCRLF[] = "\r\n";
 const size_t Buffer::kCheapPrepend;
 const size_t Buffer::kInitialSize;
 
-// 结合栈上的空间，避免内存使用过大，提高内存使用率
+// 默认构造的Buffer恰好占用BufferPool最小的一级
+BOOST_STATIC_ASSERT(Buffer::kCheapPrepend + Buffer::kInitialSize == BufferPool::kMinBlockSize);
+
+// 结合额外的溢出区，避免内存使用过大，提高内存使用率
 // 如果有5K个连接，每个连接就分配64K+64K的缓冲区的话，将占用640M内存，
 // 而大多数时候，这些缓冲区的使用率很低
+// 溢出区优先使用当前线程EventLoop的共享区域, 不再每次在栈上开辟64K
 ssize_t Buffer::readFd(int fd, int* savedErrno)
+{
+    EventLoop* loop = EventLoop::getEventLoopOfCurrentThread();
+    if (loop)
+    {
+        return readFd(fd, savedErrno, loop->readOverflow(), loop->readOverflowSize());
+    }
+    char extrabuf[65536];		// 不在IO线程中, 退化为栈上64k缓存区
+    return readFd(fd, savedErrno, extrabuf, sizeof extrabuf);
+}
+
+ssize_t Buffer::readFd(int fd, int* savedErrno, char* extrabuf, size_t extrabufLen)
 {
     // saved an ioctl()/FIONREAD call to tell how much to read
     // 节省一次ioctl系统调用（获取有多少可读数据）
-    char extrabuf[65536];		// 64k缓存区
     struct iovec vec[2];
     const size_t writable = writableBytes();
     // 第一块缓冲区
@@ -28,8 +45,10 @@ ssize_t Buffer::readFd(int fd, int* savedErrno)
     vec[0].iov_len = writable;
     // 第二块缓冲区
     vec[1].iov_base = extrabuf;
-    vec[1].iov_len = sizeof extrabuf;
-    const ssize_t n = sockets::readv(fd, vec, 2);
+    vec[1].iov_len = extrabufLen;
+    // 缓冲区已经足够大时不使用溢出区, 数据只读入缓冲区, 不会多一次拷贝
+    const int iovcnt = (writable < extrabufLen) ? 2 : 1;
+    const ssize_t n = sockets::readv(fd, vec, iovcnt);
     if (n < 0)
     {
         *savedErrno = errno;
@@ -5,6 +5,7 @@
 #include <muduo/base/StringPiece.h>
 #include <muduo/base/Types.h>
 
+#include <muduo/net/BufferPool.h>
 #include <muduo/net/Endian.h>
 
 #include <algorithm>
@@ -41,13 +42,13 @@ public:
     static const size_t kCheapPrepend = 8;
     static const size_t kInitialSize = 1024;
 
-    Buffer()
-        : buffer_(kCheapPrepend + kInitialSize),
+    explicit Buffer(size_t initialSize = kInitialSize)
+        : buffer_(kCheapPrepend + initialSize),
         readerIndex_(kCheapPrepend),
         writerIndex_(kCheapPrepend)
     {
         assert(readableBytes() == 0);
-        assert(writableBytes() == kInitialSize);
+        assert(writableBytes() == initialSize);
         assert(prependableBytes() == kCheapPrepend);
     }
 
@@ -298,12 +299,22 @@ public:
         swap(other);
     }
 
+    size_t internalCapacity() const                     // 返回底层vector的容量
+    {
+        return buffer_.capacity();
+    }
+
     /// Read data directly into buffer.
     ///
     /// It may implement with readv(2)
     /// @return result of read(2), @c errno is saved
     ssize_t readFd(int fd, int* savedErrno);    // 从套接字fd读取数据并添加至缓冲区中
 
+    /// Read data directly into buffer, overflow goes to @c extrabuf first.
+    ///
+    /// @c extrabuf is scratch space shared by the caller, e.g. EventLoop::readOverflow()
+    ssize_t readFd(int fd, int* savedErrno, char* extrabuf, size_t extrabufLen);
+
 private:
 
     char* begin()                                       // 返回buffer_首地址
@@ -338,7 +349,7 @@ private:
     }
 
 private:
-    std::vector<char> buffer_;      // vector用于替代固定大小数组
+    std::vector<char, BufferAllocator<char> > buffer_;  // vector用于替代固定大小数组, 内存来自当前线程的BufferPool
     size_t readerIndex_;            // 读位置
     size_t writerIndex_;            // 写位置
 
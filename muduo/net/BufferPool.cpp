@@ -0,0 +1,160 @@
+﻿#include <muduo/net/BufferPool.h>
+
+#include <muduo/base/CurrentThread.h>
+#include <muduo/base/Mutex.h>
+
+#include <algorithm>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const size_t BufferPool::kMinBlockSize;
+const int BufferPool::kNumSizeClasses;
+const size_t BufferPool::kMaxCachedBytesPerClass;
+
+namespace
+{
+
+__thread BufferPool* t_bufferPool = 0;  // 当前线程的内存池, 由EventLoop创建
+
+// 所有内存池, 供stats()遍历
+MutexLock g_poolsMutex;
+std::vector<BufferPool*> g_pools;       // @GuardedBy g_poolsMutex
+
+size_t blockSize(int sizeClass)
+{
+    return BufferPool::kMinBlockSize << sizeClass;
+}
+
+}   // namespace
+
+BufferPool::BufferPool()
+    : tid_(CurrentThread::tid())
+{
+    if (t_bufferPool == NULL)   // 同一线程创建第二个EventLoop时由EventLoop报错
+    {
+        t_bufferPool = this;
+    }
+    MutexLockGuard lock(g_poolsMutex);
+    g_pools.push_back(this);
+}
+
+BufferPool::~BufferPool()
+{
+    {
+        MutexLockGuard lock(g_poolsMutex);
+        g_pools.erase(std::remove(g_pools.begin(), g_pools.end(), this), g_pools.end());
+    }
+    if (t_bufferPool == this)
+    {
+        t_bufferPool = NULL;
+    }
+    for (int i = 0; i < kNumSizeClasses; ++i)
+    {
+        for (size_t j = 0; j < freeLists_[i].size(); ++j)
+        {
+            ::operator delete(freeLists_[i][j]);
+        }
+    }
+}
+
+BufferPool* BufferPool::current()
+{
+    return t_bufferPool;
+}
+
+int BufferPool::sizeClass(size_t n)
+{
+    if (n < kMinBlockSize / 2)  // 太小的内存不池化, 如Buffer(0)只有kCheapPrepend
+    {
+        return -1;
+    }
+    for (int i = 0; i < kNumSizeClasses; ++i)
+    {
+        if (n <= blockSize(i))
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+char* BufferPool::allocate(size_t n)
+{
+    int sc = sizeClass(n);
+    if (sc < 0)                 // 太小或太大的内存不池化
+    {
+        return static_cast<char*>(::operator new(n));
+    }
+    BufferPool* pool = t_bufferPool;
+    if (pool)
+    {
+        return pool->get(sc);
+    }
+    // 按级别大小分配, 以便之后可以归还到任意线程的内存池
+    return static_cast<char*>(::operator new(blockSize(sc)));
+}
+
+void BufferPool::deallocate(char* p, size_t n)
+{
+    int sc = sizeClass(n);
+    BufferPool* pool = t_bufferPool;
+    if (sc >= 0 && pool)
+    {
+        pool->put(p, sc);
+    }
+    else
+    {
+        ::operator delete(p);
+    }
+}
+
+char* BufferPool::get(int sc)
+{
+    allocations_.increment();
+    std::vector<char*>& freeList = freeLists_[sc];
+    if (!freeList.empty())
+    {
+        hits_.increment();
+        cachedBytes_.add(-static_cast<int64_t>(blockSize(sc)));
+        char* p = freeList.back();
+        freeList.pop_back();
+        return p;
+    }
+    return static_cast<char*>(::operator new(blockSize(sc)));
+}
+
+void BufferPool::put(char* p, int sc)
+{
+    frees_.increment();
+    std::vector<char*>& freeList = freeLists_[sc];
+    if ((freeList.size() + 1) * blockSize(sc) <= kMaxCachedBytesPerClass)
+    {
+        recycled_.increment();
+        cachedBytes_.add(static_cast<int64_t>(blockSize(sc)));
+        freeList.push_back(p);
+    }
+    else                        // 空闲链表已满, 还给系统
+    {
+        ::operator delete(p);
+    }
+}
+
+std::vector<BufferPool::Stats> BufferPool::stats()
+{
+    std::vector<Stats> result;
+    MutexLockGuard lock(g_poolsMutex);
+    for (size_t i = 0; i < g_pools.size(); ++i)
+    {
+        BufferPool* pool = g_pools[i];
+        Stats s;
+        s.tid = pool->tid_;
+        s.allocations = pool->allocations_.get();
+        s.hits = pool->hits_.get();
+        s.frees = pool->frees_.get();
+        s.recycled = pool->recycled_.get();
+        s.cachedBytes = pool->cachedBytes_.get();
+        result.push_back(s);
+    }
+    return result;
+}
\ No newline at end of file
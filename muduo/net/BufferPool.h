@@ -0,0 +1,116 @@
+﻿#ifndef MUDUO_NET_BUFFERPOOL_H
+#define MUDUO_NET_BUFFERPOOL_H
+
+#include <muduo/base/Atomic.h>
+#include <muduo/base/Types.h>
+
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include <stddef.h>
+#include <sys/types.h>
+
+/*
+    Buffer底层存储的内存池, 每个EventLoop一个, 只在所属的IO线程中使用, 不需要加锁
+    按大小分级(size class)维护空闲链表, 连接建立/销毁时Buffer的内存直接从链表中取用和归还
+    当前线程没有EventLoop时退化为operator new/delete
+*/
+
+namespace muduo
+{
+
+namespace net
+{
+
+///
+/// Per-loop freelist pool for Buffer storage.
+///
+/// Not thread safe, except stats().
+class BufferPool : boost::noncopyable
+{
+public:
+    /// Size of the smallest class, equals Buffer::kCheapPrepend + Buffer::kInitialSize,
+    /// so that a default constructed Buffer and its doublings fit exactly.
+    static const size_t kMinBlockSize = 1032;
+    static const int kNumSizeClasses = 7;                   // 1032 ~ 66048
+    static const size_t kMaxCachedBytesPerClass = 4*1024*1024;
+
+    struct Stats
+    {
+        pid_t tid;
+        int64_t allocations;    // 可池化大小的分配次数
+        int64_t hits;           // 从空闲链表取得的次数
+        int64_t frees;          // 可池化大小的释放次数
+        int64_t recycled;       // 归还到空闲链表的次数
+        int64_t cachedBytes;    // 空闲链表中的字节数
+    };
+
+    BufferPool();
+    ~BufferPool();
+
+    /// Pool of the current thread, NULL if none.
+    static BufferPool* current();
+
+    /// Allocates from the current thread's pool, or operator new.
+    static char* allocate(size_t n);
+    /// Returns to the current thread's pool, or operator delete.
+    /// @c n must be the same as passed to allocate().
+    static void deallocate(char* p, size_t n);
+
+    /// Snapshot of all pools, thread safe.
+    static std::vector<Stats> stats();
+
+private:
+    static int sizeClass(size_t n);     // -1 if too small or too large to pool
+
+    char* get(int sizeClass);
+    void put(char* p, int sizeClass);
+
+    const pid_t tid_;
+    std::vector<char*> freeLists_[kNumSizeClasses];
+    AtomicInt64 allocations_;
+    AtomicInt64 hits_;
+    AtomicInt64 frees_;
+    AtomicInt64 recycled_;
+    AtomicInt64 cachedBytes_;
+};
+
+///
+/// Stateless allocator backed by BufferPool, used by Buffer.
+///
+/// Memory may be freed in another thread, it then goes to that thread's pool.
+template<typename T>
+class BufferAllocator
+{
+public:
+    typedef T value_type;
+
+    BufferAllocator() {}
+    template<typename U>
+    BufferAllocator(const BufferAllocator<U>&) {}
+
+    T* allocate(size_t n)
+    {
+        return reinterpret_cast<T*>(BufferPool::allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t n)
+    {
+        BufferPool::deallocate(reinterpret_cast<char*>(p), n * sizeof(T));
+    }
+};
+
+template<typename T, typename U>
+inline bool operator==(const BufferAllocator<T>&, const BufferAllocator<U>&)
+{ return true; }
+
+template<typename T, typename U>
+inline bool operator!=(const BufferAllocator<T>&, const BufferAllocator<U>&)
+{ return false; }
+
+}       // namespace net
+
+}       // namespace muduo
+
+#endif  // MUDUO_NET_BUFFERPOOL_H
\ No newline at end of file
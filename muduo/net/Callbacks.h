@@ -40,6 +40,7 @@ namespace net
     typedef boost::function<void (const TcpConnectionPtr&)> CloseCallback;
     typedef boost::function<void (const TcpConnectionPtr&)> WriteCompleteCallback;
     typedef boost::function<void (const TcpConnectionPtr&, size_t)> HighWaterMarkCallback;
+    typedef boost::function<void (const TcpConnectionPtr&, int fd)> SendFileCompleteCallback;
     
     // the data has been read to (buf, len)
     typedef boost::function<void (const TcpConnectionPtr&,
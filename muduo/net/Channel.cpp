@@ -20,6 +20,8 @@ Channel::Channel(EventLoop* loop, int fd__)
     revents_(0),
     index_(-1),                 // 初始状态-1, 还没有添加到poll/epoll中
     logHup_(true),
+    edgeTriggered_(false),
+    completion_(kNoCompletion),
     tied_(false),
     eventHandling_(false)
 {
@@ -94,10 +96,11 @@ void Channel::handleEventWithGuard(Timestamp receiveTime)
     {
         if (readCallback_) readCallback_(receiveTime);
     }
-    if (revents_ & POLLOUT)
+    if ((revents_ & POLLOUT) && (!edgeTriggered_ || isWriting()))  // 边沿触发时POLLOUT总在注册中, 只在需要写时回调
     {
         if (writeCallback_) writeCallback_();
     }
+    completions_.clear();
     eventHandling_ = false;
 }
 
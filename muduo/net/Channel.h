@@ -8,6 +8,8 @@
 
 #include <muduo/base/Timestamp.h>
 
+#include <vector>
+
 namespace muduo
 {
 
@@ -28,6 +30,22 @@ public:
     typedef boost::function<void()> EventCallback;              // 事件回调函数
     typedef boost::function<void(Timestamp)> ReadEventCallback; // 读事件处理多一个时间戳
 
+    /// See setCompletion().
+    enum CompletionMode
+    {
+        kNoCompletion,
+        kCompleteRecv,      // poller读取数据
+        kCompleteAccept     // poller接受连接
+    };
+
+    /// A recv or accept the poller performed for the channel.
+    struct Completion
+    {
+        int         result;     // 读到的字节数或新连接的fd, 失败时为-errno
+        const char* data;       // 读到的数据, 只在本次事件回调中有效
+    };
+    typedef std::vector<Completion> CompletionList;
+
     Channel(EventLoop* loop, int fd);				            // 一个EventLoop包含多个Channel, 但一个Channel只能由一个EventLoop负责
     ~Channel();
 
@@ -63,11 +81,38 @@ public:
     /* 设置事件属性 */
     void enableReading() { events_ |= kReadEvent; update(); }
     // void disableReading() { events_ &= ~kReadEvent; update(); }
-    void enableWriting() { events_ |= kWriteEvent; update(); }
-    void disableWriting() { events_ &= ~kWriteEvent; update(); }
+    // 边沿触发时POLLOUT一直注册在poller中, 开关写事件只改变events_, 不需要epoll_ctl
+    void enableWriting()
+    {
+        bool wasNone = isNoneEvent();
+        events_ |= kWriteEvent;
+        if (!edgeTriggered_ || wasNone) update();
+    }
+    void disableWriting()
+    {
+        events_ &= ~kWriteEvent;
+        if (!edgeTriggered_ || isNoneEvent()) update();
+    }
     void disableAll() { events_ = kNoneEvent; update(); }       // 不关注事件
     bool isWriting() const { return events_ & kWriteEvent; }
 
+    /// Registers with EPOLLET, owner must read and write until EAGAIN.
+    /// Only for pollers that support it, must be set before the first update.
+    void setEdgeTriggered(bool on) { edgeTriggered_ = on; }
+    bool isEdgeTriggered() const { return edgeTriggered_; }
+
+    /// The poller receives or accepts on the fd itself and reports the
+    /// results as a read event, the read callback takes them from completions().
+    /// Only for pollers that support it, must be set before the first update.
+    void setCompletion(CompletionMode mode) { completion_ = mode; }
+    CompletionMode completion() const { return completion_; }
+    const CompletionList& completions() const { return completions_; }
+    void addCompletion(int result, const char* data)    // used by pollers
+    {
+        Completion c = { result, data };
+        completions_.push_back(c);
+    }
+
     // for Poller
     int index() { return index_; }
     void set_index(int idx) { index_ = idx; }
@@ -95,6 +140,9 @@ private:
     int        revents_;    // poll/epoll返回的事件
     int        index_;      // used by Poller.表示在poll的事件数组中的序号, 小于0表示新增的事件, 还没有添加到数组中; 在epoll中表示通道的状态
     bool       logHup_;     // for POLLHUP
+    bool       edgeTriggered_;  // 边沿触发, 见setEdgeTriggered
+    CompletionMode completion_;
+    CompletionList completions_;    // 本轮poller完成的操作, 处理完事件后清空
 
     boost::weak_ptr<void> tie_;     //tie_类型为void, 任意类型指针
     bool tied_;
@@ -1,7 +1,10 @@
 ﻿#include <muduo/net/EventLoop.h>
 
+#include <muduo/base/CoarseClock.h>
 #include <muduo/base/Logging.h>
+#include <muduo/net/BufferPool.h>
 #include <muduo/net/Channel.h>
+#include <muduo/net/LoopStats.h>
 #include <muduo/net/Poller.h>
 #include <muduo/net/TimerQueue.h>
 
@@ -9,6 +12,7 @@
 #include <boost/bind.hpp>
 
 #include <signal.h>
+#include <stdlib.h>
 #include <sys/eventfd.h>
 
 using namespace muduo;
@@ -23,6 +27,8 @@ __thread EventLoop* t_loopInThisThread = 0; // 当前线程EventLoop指针
 
 const int kPollTimeMs = 10000;  // Poller等待事件
 
+const size_t kReadOverflowSize = 64*1024;   // 读溢出区大小
+
 int createEventfd()             // 创建唤醒线程的文件描述符
 {
     int evtfd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
@@ -62,11 +68,21 @@ EventLoop::EventLoop()
     eventHandling_(false),
     callingPendingFunctors_(false),
     threadId_(CurrentThread::tid()),
+    bufferPool_(new BufferPool),
+    pollReturnTime_(Timestamp::now()),
+    pollReturnMonotonicTime_(Timestamp::monotonicNow()),
+    coarseClock_(false),
+    busyPollMicroSeconds_(0),
+    lastEventTime_(Timestamp::monotonicNow()),
     poller_(Poller::newDefaultPoller(this)),
     timerQueue_(new TimerQueue(this)),
     wakeupFd_(createEventfd()),
     wakeupChannel_(new Channel(this, wakeupFd_)),
-    currentActiveChannel_(NULL)
+    currentActiveChannel_(NULL),
+    wakeupPending_(0),
+    pendingBytes_(0),
+    readOverflow_(kReadOverflowSize),
+    stats_(new LoopStats)
 {
     LOG_TRACE << "EventLoop created " << this << " in thread " << threadId_;
     // 如果当前线程已经创建了EventLoop对象，终止(LOG_FATAL)
@@ -82,6 +98,14 @@ EventLoop::EventLoop()
     wakeupChannel_->setReadCallback(boost::bind(&EventLoop::handleRead, this));     // wakeupChannel_回调函数, 用于唤醒Poller
     // we are always reading the wakeupfd
     wakeupChannel_->enableReading();
+    if (::getenv("MUDUO_USE_TIMER_WHEEL"))  // 与MUDUO_USE_POLL一样, 通过环境变量选择
+    {
+        useTimerWheel();
+    }
+    if (::getenv("MUDUO_USE_COARSE_CLOCK"))
+    {
+        setCoarseClock(true);
+    }
 }
 
 EventLoop::~EventLoop()
@@ -106,10 +130,24 @@ void EventLoop::loop()
     LOG_TRACE << "EventLoop " << this << " start looping";
 
     //::poll(NULL, 0, 5 * 1000);      // 等待5s没有做任何事
+    Timestamp pollStart(Timestamp::monotonicNow(coarseClock_));
     while (!quit_)
     {
         activeChannels_.clear();
-        pollReturnTime_ = poller_->poll(kPollTimeMs, &activeChannels_); // 超时时间10s, 调用poller_返回活动的通道
+        // 忙轮询模式下, 最近有事件时用0超时轮询, 避免阻塞后被唤醒的延迟; 空闲超过窗口后才阻塞
+        int timeoutMs = kPollTimeMs;
+        if (busyPollMicroSeconds_ > 0
+            && pollReturnMonotonicTime_.microSecondsSinceEpoch() - lastEventTime_.microSecondsSinceEpoch() < busyPollMicroSeconds_)
+        {
+            timeoutMs = 0;
+        }
+        pollReturnTime_ = poller_->poll(timeoutMs, &activeChannels_);  // 超时时间10s, 调用poller_返回活动的通道
+        pollReturnMonotonicTime_ = Timestamp::monotonicNow(coarseClock_); // 本轮的定时器都按它判断到期
+        CoarseClock::update(pollReturnTime_);                           // 顺带推进全局的粗粒度时钟
+        if (!activeChannels_.empty())
+        {
+            lastEventTime_ = pollReturnMonotonicTime_;
+        }
         //++iteration_;
         if (Logger::logLevel() <= Logger::TRACE)
         {
@@ -125,13 +163,35 @@ void EventLoop::loop()
         }                                                               // 而是在其他线程中调用quit, 这时IO线程不能马上处理完毕
         currentActiveChannel_ = NULL;
         eventHandling_ = false;
+        Timestamp eventsEnd(Timestamp::monotonicNow(coarseClock_));
         doPendingFunctors();        // 其他线程或当前线程添加的一些回调任务, IO线程也可以执行一些计算任务, 否则当IO不频繁时一直处于阻塞状态
+        Timestamp functorsEnd(Timestamp::monotonicNow(coarseClock_));  // 也是下一轮poll的开始
+        stats_->recordIteration(pollStart, pollReturnMonotonicTime_, eventsEnd, functorsEnd, activeChannels_.size());
+        pollStart = functorsEnd;
     }
 
     LOG_TRACE << "EventLoop " << this << "stop looping";
     looping_ = false;
 }
 
+void EventLoop::setBusyPoll(double spinSeconds, int cpu)
+{
+    assertInLoopThread();
+    busyPollMicroSeconds_ = static_cast<int64_t>(spinSeconds * Timestamp::kMicroSecondsPerSecond);
+    lastEventTime_ = Timestamp::monotonicNow(coarseClock_);
+    if (cpu >= 0 && !CurrentThread::setAffinity(cpu))
+    {
+        LOG_SYSERR << "EventLoop::setBusyPoll - cannot pin to cpu " << cpu;
+    }
+}
+
+void EventLoop::setCoarseClock(bool on)
+{
+    assertInLoopThread();
+    coarseClock_ = on;
+    poller_->setCoarseClock(on);
+}
+
 // 该函数可以跨线程调用
 void EventLoop::quit()
 {
@@ -159,34 +219,37 @@ void EventLoop::runInLoop(const Functor& cb)
 
 void EventLoop::queueInLoop(const Functor& cb)
 {
-    {
-        MutexLockGuard lock(mutex_);
-        pendingFunctors_.push_back(cb);
-    }
+    pendingFunctors_.put(cb);   // 无锁, 多个线程同时投递不会互相阻塞
 
     // 调用queueInLoop的线程不是当前IO线程需要唤醒, 以便IO线程及时执行任务
     // 或者调用queueInLoop的线程是当前IO线程，并且此时正在调用pending functor，需要唤醒(当前线程调用doPendingFunctors内部又调用queueInLoop需唤醒, 若不唤醒无法处理后添加的queueInLoop)
     // 只有IO线程的事件回调中调用queueInLoop才不需要唤醒, 因为handleEvent执行后接下来会执行doPendingFunctors
-    if (!isInLoopThread() || callingPendingFunctors_)
+    // 合并唤醒: IO线程取任务之后只有第一个投递者写eventfd, 其余的投递者不再产生系统调用
+    if ((!isInLoopThread() || callingPendingFunctors_)
+        && !__atomic_exchange_n(&wakeupPending_, 1, __ATOMIC_ACQ_REL))
     {
+        stats_->functorQueued();    // 只有唤醒者记录投递时间, 一批任务读一次时钟
         wakeup();
     }
 }
 
 TimerId EventLoop::runAt(const Timestamp& time, const TimerCallback& cb)
 {
-    return timerQueue_->addTimer(cb, time, 0.0);
+    // 墙上时间换算到单调时钟上. 起算时间总用精确时钟: 粗粒度时钟在CPU空闲后可能落后不止一个节拍, 会让定时器提前
+    int64_t delay = time.microSecondsSinceEpoch() - Timestamp::now().microSecondsSinceEpoch();
+    Timestamp when(Timestamp::monotonicNow().microSecondsSinceEpoch() + delay);
+    return timerQueue_->addTimer(cb, when, 0.0);
 }
 
 TimerId EventLoop::runAfter(double delay, const TimerCallback& cb)
 {
-    Timestamp time(addTime(Timestamp::now(), delay));
-    return runAt(time, cb);
+    Timestamp time(addTime(Timestamp::monotonicNow(), delay));
+    return timerQueue_->addTimer(cb, time, 0.0);
 }
 
 TimerId EventLoop::runEvery(double interval, const TimerCallback& cb)
 {
-    Timestamp time(addTime(Timestamp::now(), interval));
+    Timestamp time(addTime(Timestamp::monotonicNow(), interval));
     return timerQueue_->addTimer(cb, time, interval);
 }
 
@@ -195,6 +258,11 @@ void EventLoop::cancel(TimerId timerId)
     return timerQueue_->cancel(timerId);
 }
 
+void EventLoop::useTimerWheel(double tickSeconds)
+{
+    timerQueue_->useTimerWheel(tickSeconds);
+}
+
 void EventLoop::updateChannel(Channel* channel)
 {
     assert(channel->ownerLoop() == this);           // 断言channel属于本EventLoop负责
@@ -214,6 +282,16 @@ void EventLoop::removeChannel(Channel* channel)
     poller_->removeChannel(channel);
 }
 
+bool EventLoop::supportsEdgeTrigger() const
+{
+    return poller_->supportsEdgeTrigger();
+}
+
+bool EventLoop::supportsCompletion() const
+{
+    return poller_->supportsCompletion();
+}
+
 void EventLoop::abortNotInLoopThread()
 {
     LOG_FATAL << "EventLoop::abortNotInLoopThread - EventLoop " << this
@@ -244,7 +322,7 @@ void EventLoop::handleRead()
 }
 
 /*
-不是简单地在临界区内依次调用Functor，而是把回调列表swap到functors中，这样一方面减小了临界区的长度（意味着不会阻塞其它线程的queueInLoop()），另一方面，也避免了死锁（因为Functor可能再次调用queueInLoop()）
+pendingFunctors_是无锁队列, 不再有临界区, 其它线程的queueInLoop()不会被阻塞。先把当前可取的回调全部取到functors中再依次调用，避免Functor再次调用queueInLoop()加入的任务在本轮被执行
 
 由于doPendingFunctors()调用的Functor可能再次调用queueInLoop(cb)，这时，queueInLoop()就必须wakeup()，否则新增的cb可能就不能及时调用了
 
@@ -256,15 +334,21 @@ void EventLoop::doPendingFunctors()
     std::vector<Functor> functors;
     callingPendingFunctors_ = true;
 
+    // 先清除wakeupPending_再取任务, 之后投递的生产者会再次唤醒, 不会丢失任务
+    __atomic_exchange_n(&wakeupPending_, 0, __ATOMIC_ACQ_REL);
+    stats_->functorsTaken();
+    Functor functor;
+    while (pendingFunctors_.take(&functor))
     {
-        MutexLockGuard lock(mutex_);
-        functors.swap(pendingFunctors_);
+        functors.push_back(Functor());
+        functors.back().swap(functor);
     }
 
     for (size_t i = 0; i < functors.size(); ++i)
     {
         functors[i]();
     }
+    stats_->recordFunctors(functors.size());
     callingPendingFunctors_ = false;
 }
 
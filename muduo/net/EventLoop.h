@@ -6,6 +6,8 @@
 #include <boost/noncopyable.hpp>
 #include <boost/scoped_ptr.hpp>
 
+#include <muduo/base/Atomic.h>
+#include <muduo/base/MpscQueue.h>
 #include <muduo/base/Mutex.h>
 #include <muduo/base/Thread.h>
 #include <muduo/base/Timestamp.h>
@@ -18,6 +20,8 @@ namespace muduo
 namespace net
 {
 
+class BufferPool;
+class LoopStats;
 class Channel;
 class Poller;
 class TimerQueue;
@@ -44,8 +48,14 @@ public:
 
     ///
     /// Time when poll returns, usually means data arrivial.
+    /// Read once per loop iteration, callbacks in the loop thread that can
+    /// live with that precision should use it instead of Timestamp::now().
     ///
     Timestamp pollReturnTime() const { return pollReturnTime_; }    // 返回Poller触发时间
+    ///
+    /// Timestamp::monotonicNow() when poll returns, the clock timers run on.
+    ///
+    Timestamp pollReturnMonotonicTime() const { return pollReturnMonotonicTime_; }
 
     /// Runs callback immediately in the loop thread.
     /// It wakes up the loop, and run the cb.
@@ -60,6 +70,8 @@ public:
     /* timers */
     ///
     /// Runs callback at 'time'.
+    /// Timers run on the monotonic clock, 'time' is converted once here,
+    /// so later wall clock changes don't move the timer.
     /// Safe to call from other threads. 跨线程调用
     ///
     TimerId runAt(const Timestamp& time, const TimerCallback& cb);
@@ -78,11 +90,38 @@ public:
     /// Safe to call from other threads.
     ///
     void cancel(TimerId timerId);
+    ///
+    /// Uses a hierarchical timing wheel with O(1) add/cancel for this loop,
+    /// timers are rounded up to @c tickSeconds.
+    /// Must be called in the loop thread, e.g. from ThreadInitCallback.
+    /// Also enabled by environment variable MUDUO_USE_TIMER_WHEEL.
+    ///
+    void useTimerWheel(double tickSeconds = 0.001);
+
+    ///
+    /// Busy-polls with zero-timeout polls for @c spinSeconds after the last
+    /// event before blocking again, trading a core for wakeup latency.
+    /// Pins the loop thread to @c cpu if it is not negative. 0 disables.
+    /// Must be called in the loop thread, e.g. from ThreadInitCallback.
+    ///
+    void setBusyPoll(double spinSeconds, int cpu = -1);
+
+    ///
+    /// Reads CLOCK_REALTIME_COARSE and CLOCK_MONOTONIC_COARSE once per
+    /// iteration instead of gettimeofday and CLOCK_MONOTONIC, which costs
+    /// the clock tick (1~4ms) of precision in pollReturnTime().
+    /// Timers are still scheduled on the precise clock and never fire early.
+    /// Must be called in the loop thread, e.g. from ThreadInitCallback.
+    /// Also enabled by environment variable MUDUO_USE_COARSE_CLOCK.
+    ///
+    void setCoarseClock(bool on);
 
     // internal usage
     void wakeup();      // 唤醒当前线程, 因为跨线程调用quit时, 当前线程可能阻塞在poller_或handleEvent位置, 此时需唤醒操作
     void updateChannel(Channel* channel);		// 在Poller中添加或者更新通道
     void removeChannel(Channel* channel);		// 从Poller中移除通道
+    bool supportsEdgeTrigger() const;           // 当前Poller是否支持Channel::setEdgeTriggered
+    bool supportsCompletion() const;            // 当前Poller是否支持Channel::setCompletion
 
     void assertInLoopThread()
     {
@@ -93,6 +132,24 @@ public:
     }
     bool isInLoopThread() const { return threadId_ == CurrentThread::tid(); }
 
+    ///
+    /// Load of this loop, read by EventLoopThreadPool from the acceptor thread.
+    ///
+    int numConnections() { return numConnections_.get(); }
+    int64_t pendingBytes() const { return __atomic_load_n(&pendingBytes_, __ATOMIC_RELAXED); }
+    // 连接对象的创建与销毁可能在不同线程, 使用原子加减
+    void addConnections(int delta) { numConnections_.add(delta); }
+    // 只在loop线程中修改, 不需要原子加减
+    void addPendingBytes(int64_t delta)
+    { __atomic_store_n(&pendingBytes_, pendingBytes_ + delta, __ATOMIC_RELAXED); }
+
+    // 本loop所有连接共享的读溢出区, 供Buffer::readFd使用, 只能在loop线程中使用
+    char* readOverflow() { return &*readOverflow_.begin(); }
+    size_t readOverflowSize() const { return readOverflow_.size(); }
+
+    // 本loop的计数与延迟分布, 只在loop线程中记录
+    LoopStats* stats() { return stats_.get(); }
+
     static EventLoop* getEventLoopOfCurrentThread();
 
 private:
@@ -109,7 +166,12 @@ private:
     bool eventHandling_;            /* atomic */
     bool callingPendingFunctors_;   /* atomic */
     const pid_t     threadId_;		        // 当前对象所属线程ID
+    boost::scoped_ptr<BufferPool> bufferPool_;  // 本线程Buffer存储的内存池, 最先构造
     Timestamp       pollReturnTime_;
+    Timestamp       pollReturnMonotonicTime_;   // 与pollReturnTime_同时读取的单调时间
+    bool            coarseClock_;
+    int64_t         busyPollMicroSeconds_;  // 忙轮询窗口, 0表示不忙轮询
+    Timestamp       lastEventTime_;         // 最近一次poll返回活动通道的单调时间
     boost::scoped_ptr<Poller> poller_;      // 智能指针, 负责Poller的生命周期
     boost::scoped_ptr<TimerQueue> timerQueue_;
     int wakeupFd_;				            // 用于eventfd所创建的文件描述符
@@ -118,8 +180,12 @@ private:
     boost::scoped_ptr<Channel> wakeupChannel_;  // 该通道将会纳入poller_来管理, 与EventLoop构成组合的关系, EventLoop只负责wakeupChannel_生存期
     ChannelList     activeChannels_;            // Poller返回的活动通道
     Channel         *currentActiveChannel_;     // 当前正在处理的活动通道, 用于从activeChannels_取通道
-    MutexLock mutex_;
-    std::vector<Functor> pendingFunctors_;      // @BuardedBy mutex_
+    MpscQueue<Functor> pendingFunctors_;        // 无锁队列, 任意线程put, 只在IO线程take
+    int wakeupPending_;                         // 已有生产者写过wakeupFd_且IO线程还未取任务, 原子操作
+    AtomicInt32 numConnections_;                // 属于本loop的TcpConnection个数
+    int64_t pendingBytes_;                      // 本loop所有连接发送队列中的字节数
+    std::vector<char> readOverflow_;            // Buffer::readFd的共享溢出区, 替代每次调用在栈上的64K extrabuf
+    boost::scoped_ptr<LoopStats> stats_;
 };
 
 }       // namespace net
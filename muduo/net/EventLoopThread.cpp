@@ -1,5 +1,6 @@
 ﻿#include <muduo/net/EventLoopThread.h>
 
+#include <muduo/base/Logging.h>
 #include <muduo/net/EventLoop.h>
 
 #include <boost/bind.hpp>
@@ -44,6 +45,11 @@ EventLoop* EventLoopThread::startLoop()
 
 void EventLoopThread::threadFunc()
 {
+    // 先绑定CPU再创建EventLoop, EventLoop及其BufferPool的内存按first-touch分配在本地NUMA节点
+    if (!cpus_.empty() && !CpuAffinity::setCurrentThread(cpus_))
+    {
+        LOG_SYSERR << "EventLoopThread::threadFunc - cannot set cpu affinity";
+    }
     EventLoop loop;
 
     if (callback_)			// 可以在构造函数中传递进来
@@ -2,6 +2,7 @@
 #define MUDUO_NET_EVENTLOOPTHREAD_H
 
 #include <muduo/base/Condition.h>
+#include <muduo/base/CpuAffinity.h>
 #include <muduo/base/Mutex.h>
 #include <muduo/base/Thread.h>
 
@@ -22,6 +23,9 @@ public:
 
     EventLoopThread(const ThreadInitCallback &cb = ThreadInitCallback());
     ~EventLoopThread();
+    /// Pins the thread before its EventLoop is created, so the loop's memory
+    /// is first touched on the local NUMA node. Must be called before startLoop().
+    void setCpus(const CpuAffinity::CpuSet& cpus) { cpus_ = cpus; }
     EventLoop* startLoop(); // 通过调用Thread::start来启动线程, 该线程成为IO线程(会在这个线程中创建EventLoop对象)
 
 private:
@@ -33,6 +37,7 @@ private:
     MutexLock   mutex_;     // 与条件变量一起使用
     Condition   cond_;      // 用于等待线程函数threadFunc创建EventLoop对象
     ThreadInitCallback  callback_;  // 回调函数在EventLoop::loop循环之前被调用
+    CpuAffinity::CpuSet cpus_;      // 为空则不绑定CPU
 };
 
 }       // namespace net;
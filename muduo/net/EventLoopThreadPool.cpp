@@ -5,14 +5,38 @@
 
 #include <boost/bind.hpp>
 
+#include <algorithm>
+
 using namespace muduo;
 using namespace muduo::net;
 
+namespace
+{
+
+const int kVirtualNodes = 128;  // 每个loop在哈希环上的虚拟节点数
+
+// 64位整数混合函数(splitmix64), 使相邻的输入在环上分散开
+size_t mixHash(uint64_t x)
+{
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return static_cast<size_t>(x ^ (x >> 31));
+}
+
+bool ringLess(const std::pair<size_t, EventLoop*>& lhs, size_t rhs)
+{
+    return lhs.first < rhs;
+}
+
+}
+
 EventLoopThreadPool::EventLoopThreadPool(EventLoop* baseLoop)
     : baseLoop_(baseLoop),
     started_(false),
     numThreads_(0),
-    next_(0)
+    next_(0),
+    policy_(kRoundRobin)
 {
 }
 
@@ -32,6 +56,10 @@ void EventLoopThreadPool::start(const ThreadInitCallback& cb)   // ThreadInitCal
     for (int i = 0; i < numThreads_; ++i)
     {
         EventLoopThread* t = new EventLoopThread(cb);
+        if (!cpuSets_.empty())
+        {
+            t->setCpus(cpuSets_[i % cpuSets_.size()]);
+        }
         threads_.push_back(t);
         loops_.push_back(t->startLoop());   // 启动EventLoopThread线程，在进入事件循环之前，会调用cb
     }
@@ -40,6 +68,47 @@ void EventLoopThreadPool::start(const ThreadInitCallback& cb)   // ThreadInitCal
         // 只有一个EventLoop，在这个EventLoop进入事件循环之前，调用cb
         cb(baseLoop_);
     }
+    buildHashRing();
+    buildCpuMap();
+}
+
+// 一个CPU上有多个loop时(如按NUMA节点绑定), 把这些CPU轮流分给这些loop
+void EventLoopThreadPool::buildCpuMap()
+{
+    cpuLoops_.clear();
+    if (cpuSets_.empty())
+    {
+        return;
+    }
+    for (size_t i = 0; i < loops_.size(); ++i)
+    {
+        const CpuAffinity::CpuSet& cpus = cpuSets_[i % cpuSets_.size()];
+        for (size_t j = 0; j < cpus.size(); ++j)
+        {
+            size_t cpu = cpus[j];
+            if (cpu >= cpuLoops_.size())
+            {
+                cpuLoops_.resize(cpu + 1);
+            }
+            cpuLoops_[cpu].push_back(loops_[i]);
+        }
+    }
+    cpuNext_.assign(cpuLoops_.size(), 0);
+}
+
+void EventLoopThreadPool::buildHashRing()
+{
+    ring_.clear();
+    ring_.reserve(loops_.size() * kVirtualNodes);
+    for (size_t i = 0; i < loops_.size(); ++i)
+    {
+        for (int v = 0; v < kVirtualNodes; ++v)
+        {
+            uint64_t key = (static_cast<uint64_t>(i) << 32) | static_cast<uint32_t>(v);
+            ring_.push_back(RingEntry(mixHash(key), loops_[i]));
+        }
+    }
+    std::sort(ring_.begin(), ring_.end());
 }
 
 /* 新连接到来时, 要选择一个EventLoop对象进行处理 */
@@ -52,9 +121,28 @@ EventLoop* EventLoopThreadPool::getNextLoop()
     // 如果不为空，按照round-robin（RR，轮叫）的调度方式选择一个EventLoop
     if (!loops_.empty())                // loops_为空则没有创建出新的线程, 所选择的EventLoop对象还是mainReactor的EventLoop, 就是单线程模式
     {                                   // 这时不仅处理监听套接字还处理已连接套接字
+        size_t chosen = next_;
+        if (policy_ == kLeastConnections || policy_ == kLeastPendingBytes)
+        {
+            // 从next_开始扫描, 负载相同时取最先扫到的, 使其退化为round-robin
+            // 计数由各IO线程更新, 这里读到的是近似值, 足够用于负载均衡
+            int64_t minLoad = -1;
+            for (size_t i = 0; i < loops_.size(); ++i)
+            {
+                size_t idx = (next_ + i) % loops_.size();
+                int64_t load = policy_ == kLeastConnections
+                               ? loops_[idx]->numConnections()
+                               : loops_[idx]->pendingBytes();
+                if (minLoad < 0 || load < minLoad)
+                {
+                    minLoad = load;
+                    chosen = idx;
+                }
+            }
+        }
         // round-robin
-        loop = loops_[next_];
-        ++next_;                        // 下一个EventLoop下标
+        loop = loops_[chosen];
+        next_ = static_cast<int>(chosen) + 1;   // 下一个EventLoop下标
         if (implicit_cast<size_t>(next_) >= loops_.size())
         {
             next_ = 0;                  // 如果大于loops_.size()则从0重新算起
@@ -62,3 +150,66 @@ EventLoop* EventLoopThreadPool::getNextLoop()
     }
     return loop;
 }
+
+/* 一致性哈希选择EventLoop, 相同hashCode总是落到同一个loop */
+EventLoop* EventLoopThreadPool::getLoopForHash(size_t hashCode)
+{
+    baseLoop_->assertInLoopThread();
+    if (ring_.empty())
+    {
+        return baseLoop_;
+    }
+    // 顺时针找到第一个不小于hashCode的虚拟节点, 越过末尾则回到环首
+    std::vector<RingEntry>::const_iterator it =
+        std::lower_bound(ring_.begin(), ring_.end(), mixHash(hashCode), ringLess);
+    if (it == ring_.end())
+    {
+        it = ring_.begin();
+    }
+    return it->second;
+}
+
+EventLoop* EventLoopThreadPool::getLoopForCpu(int cpu)
+{
+    baseLoop_->assertInLoopThread();
+    if (cpu < 0 || implicit_cast<size_t>(cpu) >= cpuLoops_.size())
+    {
+        return NULL;
+    }
+    const std::vector<EventLoop*>& loops = cpuLoops_[cpu];
+    if (loops.empty())
+    {
+        return NULL;
+    }
+    // 多个loop共用该CPU(如按NUMA节点绑定)时在它们之间轮叫
+    return loops[cpuNext_[cpu]++ % loops.size()];
+}
+
+CpuAffinity::CpuSet EventLoopThreadPool::getLoopCpus(EventLoop* loop)
+{
+    baseLoop_->assertInLoopThread();
+    if (!cpuSets_.empty())
+    {
+        for (size_t i = 0; i < loops_.size(); ++i)
+        {
+            if (loops_[i] == loop)
+            {
+                return cpuSets_[i % cpuSets_.size()];
+            }
+        }
+    }
+    return CpuAffinity::CpuSet();
+}
+
+std::vector<EventLoop*> EventLoopThreadPool::getAllLoops()
+{
+    baseLoop_->assertInLoopThread();
+    if (loops_.empty())
+    {
+        return std::vector<EventLoop*>(1, baseLoop_);
+    }
+    else
+    {
+        return loops_;
+    }
+}
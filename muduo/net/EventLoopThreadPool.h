@@ -2,8 +2,10 @@
 #define MUDUO_NET_EVENTLOOPTHREADPOOL_H
 
 #include <muduo/base/Condition.h>
+#include <muduo/base/CpuAffinity.h>
 #include <muduo/base/Mutex.h>
 
+#include <utility>
 #include <vector>
 #include <boost/function.hpp>
 #include <boost/noncopyable.hpp>
@@ -23,19 +25,62 @@ class EventLoopThreadPool : boost::noncopyable
 public:
     typedef boost::function<void(EventLoop*)> ThreadInitCallback;
 
+    /// 新连接选择IO线程的策略
+    enum SelectPolicy
+    {
+        kRoundRobin,            // 轮叫
+        kLeastConnections,      // 连接数最少的loop
+        kLeastPendingBytes,     // 发送队列积压字节最少的loop
+        kPeerAddressHash,       // 按对端地址一致性哈希, 由调用方使用getLoopForHash
+        kIncomingCpu,           // 交给绑定在接收该连接数据包的CPU上的loop, 由调用方使用getLoopForCpu
+    };
+
     EventLoopThreadPool(EventLoop* baseLoop);
     ~EventLoopThreadPool();
     void setThreadNum(int numThreads) { numThreads_ = numThreads; }
+    /// Pins loop i to cpus[i % cpus.size()], must be called before start().
+    void setThreadCpus(const std::vector<int>& cpus)
+    { cpuSets_ = CpuAffinity::eachCpu(cpus); }
+    /// Binds loop i to all cpus of NUMA node nodes[i % nodes.size()],
+    /// must be called before start().
+    void setThreadNumaNodes(const std::vector<int>& nodes)
+    { cpuSets_ = CpuAffinity::eachNumaNode(nodes); }
     void start(const ThreadInitCallback& cb = ThreadInitCallback());
+    void setSelectPolicy(SelectPolicy policy) { policy_ = policy; }
+    SelectPolicy selectPolicy() const { return policy_; }
+
+    /// chooses a loop by the select policy, baseLoop_ if no thread created
     EventLoop* getNextLoop();
 
+    /// with consistent hashing, same hashCode always gets the same loop
+    EventLoop* getLoopForHash(size_t hashCode);
+
+    /// the loop pinned to @c cpu, NULL if there is none
+    EventLoop* getLoopForCpu(int cpu);
+
+    /// cpus the loop is pinned to, empty if not pinned
+    CpuAffinity::CpuSet getLoopCpus(EventLoop* loop);
+
+    /// with round-robin order, baseLoop_ if no thread created
+    std::vector<EventLoop*> getAllLoops();
+
 private:
+    typedef std::pair<size_t, EventLoop*> RingEntry;
+
+    void buildHashRing();
+    void buildCpuMap();
+
     EventLoop* baseLoop_;   // 与Acceptor所属EventLoop相同
     bool started_;          // 是否启动
     int numThreads_;        // 线程数, 0为单线程模式
     int next_;              // 新连接到来，所选择的EventLoop对象下标, 一旦选择EventLoop对象, 就是选择对应线程来处理新到来连接
+    SelectPolicy policy_;   // 选择策略, 默认kRoundRobin
     boost::ptr_vector<EventLoopThread> threads_;    // IO线程列表, 当ptr_vector对象销毁后, 它所管理的EventLoopThread对象一起销毁
     std::vector<EventLoop*> loops_;                 // EventLoop列表, 一个IO线程对应一个EventLoop对象, 这些对象都是栈上对象不需要由EventLoopThreadPool销毁, 因而这里不需要ptr_vector
+    std::vector<RingEntry> ring_;                   // 一致性哈希环, 按哈希值排序, 每个loop有kVirtualNodes个虚拟节点
+    std::vector<CpuAffinity::CpuSet> cpuSets_;      // 第i个IO线程绑定cpuSets_[i % size()], 为空则不绑定
+    std::vector<std::vector<EventLoop*> > cpuLoops_;    // 以CPU编号为下标, 绑定在该CPU上的loop
+    std::vector<size_t> cpuNext_;                       // 以CPU编号为下标, 在cpuLoops_[cpu]中轮叫的位置
 };
 
 }       // namespace net
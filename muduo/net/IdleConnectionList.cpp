@@ -0,0 +1,70 @@
+﻿#include <muduo/net/IdleConnectionList.h>
+
+#include <muduo/base/Logging.h>
+#include <muduo/net/EventLoop.h>
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+
+using namespace muduo;
+using namespace muduo::net;
+
+IdleConnectionList::IdleConnectionList(EventLoop* loop, double idleSeconds)
+    : loop_(loop),
+    idleSeconds_(idleSeconds),
+    interval_(std::min(idleSeconds, 1.0))
+{
+}
+
+IdleConnectionList::~IdleConnectionList()
+{
+    connections_.clear();
+}
+
+void IdleConnectionList::start()
+{
+    // 定时器只持有weak_ptr, 列表销毁后不再重新设置定时器
+    loop_->runAfter(interval_, boost::bind(&IdleConnectionList::onTimer,
+                                           boost::weak_ptr<IdleConnectionList>(shared_from_this())));
+}
+
+void IdleConnectionList::touch(TcpConnection* conn)
+{
+    loop_->assertInLoopThread();
+    conn->idleHook_.unlink();
+    conn->lastActiveTime_ = loop_->pollReturnMonotonicTime();
+    connections_.push_back(*conn);
+}
+
+void IdleConnectionList::remove(TcpConnection* conn)
+{
+    loop_->assertInLoopThread();
+    conn->idleHook_.unlink();
+}
+
+void IdleConnectionList::onTimer(const boost::weak_ptr<IdleConnectionList>& wkList)
+{
+    boost::shared_ptr<IdleConnectionList> list(wkList.lock());
+    if (list)
+    {
+        list->sweep();
+        list->loop_->runAfter(list->interval_, boost::bind(&IdleConnectionList::onTimer, wkList));
+    }
+}
+
+void IdleConnectionList::sweep()
+{
+    loop_->assertInLoopThread();
+    Timestamp now(loop_->pollReturnMonotonicTime());   // 与touch()同一时钟
+    // 链表按活动时间有序, 遇到第一个未超时的连接即可停止
+    while (!connections_.empty()
+           && timeDifference(now, connections_.front().lastActiveTime_) > idleSeconds_)
+    {
+        TcpConnection& conn = connections_.front();
+        connections_.pop_front();
+        LOG_INFO << "IdleConnectionList::sweep - connection " << conn.name()
+                 << " idle for " << timeDifference(now, conn.lastActiveTime_) << " seconds";
+        conn.forceClose();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+﻿#ifndef MUDUO_NET_IDLECONNECTIONLIST_H
+#define MUDUO_NET_IDLECONNECTIONLIST_H
+
+#include <muduo/base/Timestamp.h>
+#include <muduo/net/TcpConnection.h>
+
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/intrusive/list.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/weak_ptr.hpp>
+
+/*
+    TcpServer::setIdleTimeout的实现, 每个EventLoop一个
+    连接按最近活动时间排成链表(examples/idleconnection/sortedlist.cc的做法), 有活动时移到表尾, O(1)
+    一个定时器定期从表头开始关闭超时的连接, 一次处理一批
+*/
+
+namespace muduo
+{
+
+namespace net
+{
+
+class EventLoop;
+
+///
+/// Connections of one loop ordered by last activity, for idle timeout.
+///
+/// Not thread safe except start(), all others are called in the loop thread.
+class IdleConnectionList : boost::noncopyable,
+                           public boost::enable_shared_from_this<IdleConnectionList>
+{
+public:
+    IdleConnectionList(EventLoop* loop, double idleSeconds);
+    ~IdleConnectionList();
+
+    /// Starts the periodic sweep, thread safe.
+    void start();
+
+    /// Adds or moves @c conn to the tail, O(1).
+    /// Stamped with EventLoop::pollReturnMonotonicTime(), so a wall clock
+    /// step neither closes live connections nor keeps idle ones.
+    void touch(TcpConnection* conn);
+    void remove(TcpConnection* conn);
+
+    size_t size() const { return connections_.size(); }
+
+private:
+    typedef boost::intrusive::member_hook<TcpConnection, TcpConnection::IdleHook,
+                                          &TcpConnection::idleHook_> HookOption;
+    typedef boost::intrusive::list<TcpConnection, HookOption,
+                                   boost::intrusive::constant_time_size<false> > ConnectionList;
+
+    static void onTimer(const boost::weak_ptr<IdleConnectionList>& wkList);
+    void sweep();
+
+    EventLoop* loop_;
+    const double idleSeconds_;
+    const double interval_;         // 检查间隔, 连接最多晚这么久被关闭
+    ConnectionList connections_;    // 表头是最久没有活动的连接
+};
+
+}       // namespace net
+
+}       // namespace muduo
+
+#endif  // MUDUO_NET_IDLECONNECTIONLIST_H
\ No newline at end of file
@@ -0,0 +1,126 @@
+﻿#include <muduo/net/LoopStats.h>
+
+#include <muduo/base/CurrentThread.h>
+#include <muduo/base/Mutex.h>
+
+#include <algorithm>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+
+// 所有loop的统计, 供snapshots()遍历
+MutexLock g_statsMutex;
+std::vector<LoopStats*> g_stats;        // @GuardedBy g_statsMutex
+
+int64_t microSecondsBetween(Timestamp low, Timestamp high)
+{
+    return high.microSecondsSinceEpoch() - low.microSecondsSinceEpoch();
+}
+
+}   // namespace
+
+LoopStats::LoopStats()
+    : tid_(CurrentThread::tid()),
+    name_(CurrentThread::name()),
+    created_(Timestamp::monotonicNow()),
+    iterations_(0),
+    events_(0),
+    functors_(0),
+    maxFunctorBatch_(0),
+    timers_(0),
+    busyMicroSeconds_(0),
+    lastFunctorBatch_(0),
+    firstQueued_(0)
+{
+    MutexLockGuard lock(g_statsMutex);
+    g_stats.push_back(this);
+}
+
+LoopStats::~LoopStats()
+{
+    MutexLockGuard lock(g_statsMutex);
+    g_stats.erase(std::remove(g_stats.begin(), g_stats.end(), this), g_stats.end());
+}
+
+void LoopStats::recordIteration(Timestamp pollStart, Timestamp pollEnd, Timestamp eventsEnd,
+                                Timestamp functorsEnd, size_t numEvents)
+{
+    increase(&iterations_, 1);
+    increase(&events_, static_cast<int64_t>(numEvents));
+    increase(&busyMicroSeconds_, microSecondsBetween(pollEnd, functorsEnd));
+    pollWait_.record(microSecondsBetween(pollStart, pollEnd));
+    if (numEvents > 0)
+    {
+        callback_.record(microSecondsBetween(pollEnd, eventsEnd));
+    }
+    if (lastFunctorBatch_ > 0)
+    {
+        functor_.record(microSecondsBetween(eventsEnd, functorsEnd));
+        lastFunctorBatch_ = 0;
+    }
+}
+
+void LoopStats::recordFunctors(size_t count)
+{
+    lastFunctorBatch_ = count;
+    int64_t n = static_cast<int64_t>(count);
+    increase(&functors_, n);
+    if (n > maxFunctorBatch_)
+    {
+        __atomic_store_n(&maxFunctorBatch_, n, __ATOMIC_RELAXED);
+    }
+}
+
+void LoopStats::recordTimer(int64_t latenessMicroSeconds)
+{
+    increase(&timers_, 1);
+    timerLateness_.record(latenessMicroSeconds > 0 ? latenessMicroSeconds : 0);   // 时间轮按槽推进, 不会早于到期, 防御性地截断
+}
+
+void LoopStats::functorQueued()
+{
+    // 只有唤醒loop的那个生产者会调用, 不是每次queueInLoop都读时钟
+    int64_t expected = 0;
+    __atomic_compare_exchange_n(&firstQueued_, &expected, Timestamp::monotonicNow().microSecondsSinceEpoch(),
+                                false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+}
+
+void LoopStats::functorsTaken()
+{
+    int64_t queued = __atomic_exchange_n(&firstQueued_, 0, __ATOMIC_RELAXED);
+    if (queued != 0)
+    {
+        functorDelay_.record(Timestamp::monotonicNow().microSecondsSinceEpoch() - queued);
+    }
+}
+
+std::vector<LoopStats::Snapshot> LoopStats::snapshots()
+{
+    std::vector<Snapshot> result;
+    Timestamp now(Timestamp::monotonicNow());
+    MutexLockGuard lock(g_statsMutex);
+    result.resize(g_stats.size());
+    for (size_t i = 0; i < g_stats.size(); ++i)
+    {
+        const LoopStats* stats = g_stats[i];
+        Snapshot& s = result[i];
+        s.tid = stats->tid_;
+        s.name = stats->name_;
+        s.elapsedMicroSeconds = microSecondsBetween(stats->created_, now);
+        s.iterations = __atomic_load_n(&stats->iterations_, __ATOMIC_RELAXED);
+        s.events = __atomic_load_n(&stats->events_, __ATOMIC_RELAXED);
+        s.functors = __atomic_load_n(&stats->functors_, __ATOMIC_RELAXED);
+        s.maxFunctorBatch = __atomic_load_n(&stats->maxFunctorBatch_, __ATOMIC_RELAXED);
+        s.timers = __atomic_load_n(&stats->timers_, __ATOMIC_RELAXED);
+        s.busyMicroSeconds = __atomic_load_n(&stats->busyMicroSeconds_, __ATOMIC_RELAXED);
+        stats->pollWait_.snapshot(&s.pollWait);
+        stats->callback_.snapshot(&s.callback);
+        stats->functor_.snapshot(&s.functor);
+        stats->functorDelay_.snapshot(&s.functorDelay);
+        stats->timerLateness_.snapshot(&s.timerLateness);
+    }
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,90 @@
+﻿#ifndef MUDUO_NET_LOOPSTATS_H
+#define MUDUO_NET_LOOPSTATS_H
+
+#include <muduo/base/LatencyHistogram.h>
+#include <muduo/base/Timestamp.h>
+#include <muduo/base/Types.h>
+
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include <sys/types.h>
+
+namespace muduo
+{
+
+namespace net
+{
+
+///
+/// Counters and latency histograms of one EventLoop.
+///
+/// Written only by the loop thread, apart from functorQueued().
+/// snapshots() is thread safe, it is what /loop/stats of Inspector prints.
+class LoopStats : boost::noncopyable
+{
+public:
+    struct Snapshot
+    {
+        pid_t tid;
+        string name;                    // 线程名
+        int64_t elapsedMicroSeconds;    // 自loop创建以来
+        int64_t iterations;
+        int64_t events;                 // 处理的活动通道数
+        int64_t functors;               // 执行的pending functor数
+        int64_t maxFunctorBatch;        // 一次doPendingFunctors取到的最多任务数
+        int64_t timers;                 // 到期执行的定时器数
+        int64_t busyMicroSeconds;       // 处理事件与functor的累计时间, 不含poll等待
+        LatencyHistogram::Snapshot pollWait;        // poll阻塞时间
+        LatencyHistogram::Snapshot callback;        // 一轮中处理活动通道的时间
+        LatencyHistogram::Snapshot functor;         // 一轮中执行functor的时间
+        LatencyHistogram::Snapshot functorDelay;    // 跨线程投递的functor等到执行的时间
+        LatencyHistogram::Snapshot timerLateness;   // 定时器实际执行晚于到期时间多少
+    };
+
+    LoopStats();
+    ~LoopStats();
+
+    /// One loop iteration, times from Timestamp::monotonicNow(),
+    /// functors of this iteration are recorded first by recordFunctors().
+    void recordIteration(Timestamp pollStart, Timestamp pollEnd, Timestamp eventsEnd,
+                         Timestamp functorsEnd, size_t numEvents);
+    void recordFunctors(size_t count);
+    void recordTimer(int64_t latenessMicroSeconds);
+
+    /// Called by a producer that wakes up the loop, thread safe.
+    void functorQueued();
+    /// Called when the loop takes its pending functors.
+    void functorsTaken();
+
+    /// Snapshot of all loops, thread safe.
+    static std::vector<Snapshot> snapshots();
+
+private:
+    static void increase(int64_t* counter, int64_t delta)
+    { __atomic_store_n(counter, *counter + delta, __ATOMIC_RELAXED); }
+
+    const pid_t tid_;
+    const string name_;
+    const Timestamp created_;
+    int64_t iterations_;
+    int64_t events_;
+    int64_t functors_;
+    int64_t maxFunctorBatch_;
+    int64_t timers_;
+    int64_t busyMicroSeconds_;
+    size_t lastFunctorBatch_;       // 本轮doPendingFunctors取到的任务数
+    int64_t firstQueued_;           // 最早一个未取走的跨线程functor的投递时间, 0表示没有
+    LatencyHistogram pollWait_;
+    LatencyHistogram callback_;
+    LatencyHistogram functor_;
+    LatencyHistogram functorDelay_;
+    LatencyHistogram timerLateness_;
+};
+
+}       // namespace net
+
+}       // namespace muduo
+
+#endif  // MUDUO_NET_LOOPSTATS_H
\ No newline at end of file
@@ -0,0 +1,222 @@
+﻿#include <muduo/net/OutputQueue.h>
+
+#include <muduo/base/Logging.h>
+#include <muduo/net/SocketsOps.h>
+
+#include <algorithm>
+
+#include <errno.h>
+#include <string.h>
+#include <sys/uio.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const size_t OutputQueue::kMinChunkSize;
+const int OutputQueue::kMaxIovecs;
+
+OutputQueue::OutputQueue()
+    : bytes_(0),
+    tailUsed_(0)
+{
+}
+
+void OutputQueue::append(const char* data, size_t len)
+{
+    if (len == 0)
+    {
+        return;
+    }
+    bytes_ += len;
+
+    // 队尾正好是tailChunk_中最后写入的数据, 直接追加, 避免每次send产生一个片
+    if (tailChunk_ && !slices_.empty())
+    {
+        Slice& last = slices_.back();
+        char* tailEnd = tailChunk_->data() + tailUsed_;
+        if (last.owner == tailChunk_
+            && last.data + last.len == tailEnd
+            && tailChunk_->capacity() - tailUsed_ >= len)
+        {
+            ::memcpy(tailEnd, data, len);
+            tailUsed_ += len;
+            last.len += len;
+            return;
+        }
+    }
+
+    if (!tailChunk_ || tailChunk_->capacity() - tailUsed_ < len)
+    {
+        tailChunk_.reset(new Chunk(std::max(len, kMinChunkSize)));
+        tailUsed_ = 0;
+    }
+    char* dest = tailChunk_->data() + tailUsed_;
+    ::memcpy(dest, data, len);
+    tailUsed_ += len;
+    Slice slice = { tailChunk_, dest, len, -1, 0, SendFileCompleteCallback() };
+    slices_.push_back(slice);
+}
+
+void OutputQueue::append(const char* data, size_t len, const boost::shared_ptr<void>& owner)
+{
+    assert(owner);
+    if (len == 0)
+    {
+        return;
+    }
+    bytes_ += len;
+    Slice slice = { owner, data, len, -1, 0, SendFileCompleteCallback() };
+    slices_.push_back(slice);
+}
+
+void OutputQueue::appendFile(int fd, off_t offset, size_t len, const SendFileCompleteCallback& cb)
+{
+    assert(fd >= 0);
+    bytes_ += len;
+    Slice slice = { boost::shared_ptr<void>(), NULL, len, fd, offset, cb };
+    slices_.push_back(slice);
+}
+
+void OutputQueue::clear(CompletedFileList* dropped)
+{
+    for (SliceList::const_iterator it = slices_.begin(); it != slices_.end(); ++it)
+    {
+        if (it->fd >= 0)
+        {
+            CompletedFile file = { it->fd, it->callback };
+            dropped->push_back(file);
+        }
+    }
+    slices_.clear();
+    bytes_ = 0;
+    tailChunk_.reset();
+    tailUsed_ = 0;
+}
+
+ssize_t OutputQueue::writeFd(int sockfd, int* savedErrno, CompletedFileList* completed,
+                             size_t maxBytes)
+{
+    ssize_t total = 0;
+    *savedErrno = 0;
+    while (!slices_.empty())
+    {
+        size_t attempted = 0;
+        ssize_t n = slices_.front().fd < 0 ? writeSlices(sockfd, &attempted)
+                                           : writeFile(sockfd, &attempted, completed);
+        if (n < 0)
+        {
+            *savedErrno = errno;
+            break;
+        }
+        total += n;
+        if (implicit_cast<size_t>(n) < attempted    // 没写完说明内核发送缓冲区已满
+            || implicit_cast<size_t>(total) >= maxBytes)
+        {
+            break;
+        }
+    }
+    return total;
+}
+
+ssize_t OutputQueue::writeSlices(int sockfd, size_t* attempted)
+{
+    struct iovec vec[kMaxIovecs];
+    int count = 0;
+    size_t len = 0;
+    for (SliceList::const_iterator it = slices_.begin();
+        it != slices_.end() && it->fd < 0 && count < kMaxIovecs;
+        ++it, ++count)
+    {
+        vec[count].iov_base = const_cast<char*>(it->data);
+        vec[count].iov_len = it->len;
+        len += it->len;
+    }
+    assert(count > 0);
+    *attempted = len;
+
+    ssize_t n = sockets::writev(sockfd, vec, count);
+    if (n > 0)
+    {
+        retrieve(n);
+    }
+    return n;
+}
+
+ssize_t OutputQueue::writeFile(int sockfd, size_t* attempted, CompletedFileList* completed)
+{
+    Slice& slice = slices_.front();
+    assert(slice.fd >= 0);
+    ssize_t n = 0;
+    *attempted = slice.len;
+    if (slice.len > 0)
+    {
+        n = sockets::sendfile(sockfd, slice.fd, &slice.offset, slice.len);
+        if (n < 0)
+        {
+            if (errno != EAGAIN && errno != EINTR)
+            {
+                // 不可恢复的错误, 放弃这个文件片并交回其回调, 不让它留在队首一直重试
+                int savedErrno = errno;
+                CompletedFile failed = { slice.fd, slice.callback };
+                completed->push_back(failed);
+                bytes_ -= slice.len;
+                slices_.pop_front();
+                retrieve(0);
+                errno = savedErrno;
+            }
+            return n;
+        }
+
+        size_t sent = implicit_cast<size_t>(n);
+        if (n == 0)
+        {
+            // 文件被截断, 放弃剩余部分, 避免一直触发POLLOUT
+            LOG_ERROR << "OutputQueue::writeFile - fd " << slice.fd
+                      << " ends with " << slice.len << " bytes unsent";
+            sent = slice.len;
+            *attempted = 0;
+        }
+        slice.len -= sent;
+        bytes_ -= sent;
+    }
+
+    if (slice.len == 0)
+    {
+        CompletedFile done = { slice.fd, slice.callback };
+        completed->push_back(done);
+        slices_.pop_front();
+        retrieve(0);
+    }
+    return n;
+}
+
+void OutputQueue::retrieve(size_t len)
+{
+    bytes_ -= len;
+    while (len > 0)
+    {
+        assert(!slices_.empty() && slices_.front().fd < 0);
+        Slice& front = slices_.front();
+        if (len < front.len)
+        {
+            front.data += len;
+            front.len -= len;
+            len = 0;
+        }
+        else
+        {
+            len -= front.len;
+            slices_.pop_front();
+        }
+    }
+
+    if (slices_.empty() && tailChunk_)
+    {
+        // 队列已清空, 没有片再引用tailChunk_, 可以从头复用; 大块内存则还回去
+        if (tailChunk_->capacity() > kMinChunkSize)
+        {
+            tailChunk_.reset();
+        }
+        tailUsed_ = 0;
+    }
+}
@@ -0,0 +1,111 @@
+﻿#ifndef MUDUO_NET_OUTPUTQUEUE_H
+#define MUDUO_NET_OUTPUTQUEUE_H
+
+#include <muduo/net/BufferPool.h>
+#include <muduo/net/Callbacks.h>
+
+#include <deque>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <sys/types.h>
+
+/*
+    TcpConnection的发送队列, 由若干片(slice)组成, 每片引用一段内存或一个文件区间
+    内存片通过shared_ptr持有所引用的内存, 因此send时可以不拷贝用户数据
+    相邻的内存片由一次writev发送, 文件片由sendfile发送
+*/
+
+namespace muduo
+{
+
+namespace net
+{
+
+///
+/// Scatter-gather output queue of a TcpConnection.
+///
+/// Not thread safe, always used in the connection's loop thread.
+class OutputQueue : boost::noncopyable
+{
+public:
+    /// A file range whose last byte has been handed to the kernel.
+    struct CompletedFile
+    {
+        int fd;
+        SendFileCompleteCallback callback;
+    };
+    typedef std::vector<CompletedFile> CompletedFileList;
+
+    static const size_t kMinChunkSize = 4096;
+    static const int kMaxIovecs = 64;
+
+    OutputQueue();
+
+    /// Bytes not written yet, including file ranges.
+    size_t readableBytes() const { return bytes_; }
+    bool empty() const { return slices_.empty(); }
+
+    /// Copies data into the tail chunk, small writes are coalesced.
+    void append(const char* data, size_t len);
+    /// References data without copying, @c owner keeps it alive until written.
+    void append(const char* data, size_t len, const boost::shared_ptr<void>& owner);
+    void appendFile(int fd, off_t offset, size_t len, const SendFileCompleteCallback& cb);
+    /// Drops everything, file ranges not finished are returned in @c dropped.
+    void clear(CompletedFileList* dropped);
+
+    /// Writes with writev(2) and sendfile(2) until the queue is empty, the
+    /// socket would block, or at least @c maxBytes are written.
+    /// A file range whose sendfile fails with other than EAGAIN/EINTR is
+    /// dropped and returned in @c completed.
+    /// @return bytes written, @c errno of the failed call is saved in @c savedErrno
+    ssize_t writeFd(int sockfd, int* savedErrno, CompletedFileList* completed,
+                    size_t maxBytes = static_cast<size_t>(-1));
+
+private:
+    struct Slice
+    {
+        boost::shared_ptr<void> owner;  // 内存片的持有者, 文件片为空
+        const char* data;
+        size_t      len;
+        int         fd;                 // 文件片的文件描述符, 内存片为-1
+        off_t       offset;
+        SendFileCompleteCallback callback;
+    };
+
+    // append拷贝数据所用的内存块, 不像vector那样先清零
+    class Chunk : boost::noncopyable
+    {
+    public:
+        explicit Chunk(size_t capacity)
+            : data_(BufferPool::allocate(capacity)),
+            capacity_(capacity)
+        { }
+        ~Chunk() { BufferPool::deallocate(data_, capacity_); }
+
+        char* data() { return data_; }
+        size_t capacity() const { return capacity_; }
+
+    private:
+        char* const data_;
+        const size_t capacity_;
+    };
+    typedef std::deque<Slice> SliceList;
+
+    ssize_t writeSlices(int sockfd, size_t* attempted);     // 一次writev发送队首的连续内存片
+    ssize_t writeFile(int sockfd, size_t* attempted, CompletedFileList* completed);
+    void retrieve(size_t len);          // 移除已发送的len字节内存数据
+
+    SliceList slices_;
+    size_t    bytes_;
+    boost::shared_ptr<Chunk> tailChunk_;    // append拷贝数据所用的内存块
+    size_t    tailUsed_;                    // tailChunk_已使用的字节数
+};
+
+}       // namespace net
+
+}       // namespace muduo
+
+#endif  // MUDUO_NET_OUTPUTQUEUE_H
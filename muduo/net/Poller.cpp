@@ -1,13 +1,30 @@
 ﻿#include <muduo/net/Poller.h>
 
+#include <algorithm>
+
+#include <assert.h>
+
 using namespace muduo;
 using namespace muduo::net;
 
 Poller::Poller(EventLoop* loop)
-    : ownerLoop_(loop)
+    : ownerLoop_(loop),
+    coarseClock_(false)
 {
 }
 
 Poller::~Poller()
 {
+}
+
+void Poller::addChannel(int fd, Channel* channel)
+{
+    assert(fd >= 0);
+    if (implicit_cast<size_t>(fd) >= channels_.size())
+    {
+        // 成倍增长, 连接风暴中不会每个新fd都重新分配
+        channels_.resize(std::max(implicit_cast<size_t>(fd) + 1, 2 * channels_.size()), NULL);
+    }
+    assert(channels_[fd] == NULL);
+    channels_[fd] = channel;
 }
\ No newline at end of file
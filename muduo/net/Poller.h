@@ -5,6 +5,7 @@
 #include <boost/noncopyable.hpp>
 
 #include <muduo/base/Timestamp.h>
+#include <muduo/base/Types.h>
 #include <muduo/net/EventLoop.h>
 
 namespace muduo
@@ -39,6 +40,15 @@ public:
     /// Must be called in the loop thread.
     virtual void removeChannel(Channel* channel) = 0;                       // 从Poller中移除对应的Channel
 
+    /// Whether Channel::setEdgeTriggered is honored.
+    virtual bool supportsEdgeTrigger() const { return false; }
+
+    /// Whether Channel::setCompletion is honored.
+    virtual bool supportsCompletion() const { return false; }
+
+    /// poll() returns Timestamp::coarseNow() instead of Timestamp::now().
+    void setCoarseClock(bool on) { coarseClock_ = on; }
+
     static Poller* newDefaultPoller(EventLoop* loop);                       // 静态成员函数, 通过环境变量来确定使用PollPoller还是EPollPoller
 
     void assertInLoopThread()                                               // 确保在当前线程中
@@ -46,8 +56,25 @@ public:
         ownerLoop_->assertInLoopThread();
     }
 
+protected:
+    /// Channels indexed by fd, fds are small dense integers so lookups
+    /// are O(1) instead of a tree walk.
+    typedef std::vector<Channel*> ChannelMap;   // 下标是文件描述符, 未注册的为NULL
+
+    Channel* findChannel(int fd) const
+    { return implicit_cast<size_t>(fd) < channels_.size() ? channels_[fd] : NULL; }
+    void addChannel(int fd, Channel* channel);  // 按需增长
+    void eraseChannel(int fd) { channels_[fd] = NULL; }
+
+    // poll返回的时间, 每轮循环只读这一次墙上时钟
+    Timestamp pollReturnTime() const
+    { return coarseClock_ ? Timestamp::coarseNow() : Timestamp::now(); }
+
+    ChannelMap channels_;
+
 private:
     EventLoop *ownerLoop_;          // Poller所属EventLoop
+    bool coarseClock_;
 };
 
 }       // namespace net
@@ -0,0 +1,43 @@
+﻿#include <muduo/net/ReadSizePredictor.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const size_t ReadSizePredictor::kMinReadSize;
+const size_t ReadSizePredictor::kInitialReadSize;
+const size_t ReadSizePredictor::kMaxReadSize;
+
+ReadSizePredictor::ReadSizePredictor()
+    : nextReadSize_(kInitialReadSize),
+    decreaseNow_(false)
+{
+}
+
+// 预测值在[kMinReadSize, kMaxReadSize]之间按2倍放大或缩小
+void ReadSizePredictor::record(size_t actualReadBytes)
+{
+    if (actualReadBytes >= nextReadSize_)           // 读满了, 内核中可能还有数据
+    {
+        if (nextReadSize_ < kMaxReadSize)
+        {
+            nextReadSize_ *= 2;
+        }
+        decreaseNow_ = false;
+    }
+    else if (actualReadBytes <= nextReadSize_ / 2)  // 小一级的大小已经足够
+    {
+        if (decreaseNow_ && nextReadSize_ > kMinReadSize)
+        {
+            nextReadSize_ /= 2;
+            decreaseNow_ = false;
+        }
+        else
+        {
+            decreaseNow_ = true;
+        }
+    }
+    else
+    {
+        decreaseNow_ = false;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+﻿#ifndef MUDUO_NET_READSIZEPREDICTOR_H
+#define MUDUO_NET_READSIZEPREDICTOR_H
+
+#include <muduo/base/copyable.h>
+
+#include <stddef.h>
+
+namespace muduo
+{
+
+namespace net
+{
+
+///
+/// Adaptive read size predictor, modeled after netty's AdaptiveRecvByteBufAllocator.
+///
+/// 根据最近几次read的实际字节数预测下一次要读的大小:
+/// 一次读满预测值就放大, 连续两次读到的数据不足更小一级就缩小.
+/// TcpConnection据此预留inputBuffer_的空间, 活跃连接的数据直接读入缓冲区,
+/// 空闲连接则通过Buffer::shrink归还内存.
+class ReadSizePredictor : public muduo::copyable
+{
+public:
+    static const size_t kMinReadSize = 512;
+    static const size_t kInitialReadSize = 1024;
+    static const size_t kMaxReadSize = 64*1024;
+
+    ReadSizePredictor();
+
+    size_t nextReadSize() const { return nextReadSize_; }
+
+    /// 记录一次read实际读到的字节数, 调整下一次的预测值
+    void record(size_t actualReadBytes);
+
+private:
+    size_t nextReadSize_;
+    bool decreaseNow_;      // 上一次已经读不满更小一级, 再有一次就缩小
+};
+
+}       // namespace net
+
+}       // namespace muduo
+
+#endif  // MUDUO_NET_READSIZEPREDICTOR_H
\ No newline at end of file
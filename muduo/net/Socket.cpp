@@ -1,5 +1,6 @@
 ﻿#include <muduo/net/Socket.h>
 
+#include <muduo/base/Logging.h>
 #include <muduo/net/InetAddress.h>
 #include <muduo/net/SocketsOps.h>
 
@@ -58,6 +59,37 @@ void Socket::setReuseAddr(bool on)
     // FIXME CHECK
 }
 
+void Socket::setReusePort(bool on)
+{
+#ifdef SO_REUSEPORT
+    int optval = on ? 1 : 0;
+    int ret = ::setsockopt(sockfd_, SOL_SOCKET, SO_REUSEPORT,
+                           &optval, sizeof optval);
+    if (ret < 0 && on)
+    {
+        LOG_SYSERR << "SO_REUSEPORT failed.";
+    }
+#else
+    if (on)
+    {
+        LOG_ERROR << "SO_REUSEPORT is not supported.";
+    }
+#endif
+}
+
+void Socket::setIncomingCpu(int cpu)
+{
+#ifdef SO_INCOMING_CPU
+    if (::setsockopt(sockfd_, SOL_SOCKET, SO_INCOMING_CPU, &cpu, sizeof cpu) < 0)
+    {
+        LOG_SYSERR << "SO_INCOMING_CPU failed.";
+    }
+#else
+    (void)cpu;
+    LOG_ERROR << "SO_INCOMING_CPU is not supported.";
+#endif
+}
+
 void Socket::setKeepAlive(bool on)
 {
     int optval = on ? 1 : 0;
@@ -54,6 +54,18 @@ public:
     ///
     void setReuseAddr(bool on);	// 设置地址重复利用
 
+    ///
+    /// Enable/disable SO_REUSEPORT
+    ///
+    // 多个套接字可以绑定同一端口, 由内核在它们之间分配新连接
+    void setReusePort(bool on);
+
+    ///
+    /// Sets SO_INCOMING_CPU, with SO_REUSEPORT the kernel prefers the
+    /// listening socket whose cpu processed the SYN.
+    ///
+    void setIncomingCpu(int cpu);
+
     ///
     /// Enable/disable SO_KEEPALIVE
     ///
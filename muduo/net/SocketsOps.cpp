@@ -8,7 +8,9 @@
 #include <fcntl.h>
 #include <stdio.h>  // snprintf
 #include <strings.h>  // bzero
+#include <sys/sendfile.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 using namespace muduo;
@@ -103,7 +105,10 @@ int sockets::accept(int sockfd, struct sockaddr_in* addr)
     if (connfd < 0)
     {
         int savedErrno = errno;		// LOG_SYSERR可能调用系统调用或库函数, 可能更改errno的值, 这里先保存
-        LOG_SYSERR << "Socket::accept";
+        if (savedErrno != EAGAIN)   // Acceptor批量accept直到EAGAIN, 这是正常结束
+        {
+            LOG_SYSERR << "Socket::accept";
+        }
         switch (savedErrno)
         {
         case EAGAIN:
@@ -155,6 +160,18 @@ ssize_t sockets::write(int sockfd, const void *buf, size_t count)
     return ::write(sockfd, buf, count);
 }
 
+// writev与write不同之处在于，可以一次发送多个缓冲区中的数据
+ssize_t sockets::writev(int sockfd, const struct iovec *iov, int iovcnt)
+{
+    return ::writev(sockfd, iov, iovcnt);
+}
+
+// 由内核直接把文件内容拷贝到套接字发送缓冲区, 不经过用户空间
+ssize_t sockets::sendfile(int sockfd, int infd, off_t *offset, size_t count)
+{
+    return ::sendfile(sockfd, infd, offset, count);
+}
+
 void sockets::close(int sockfd)
 {
     if (::close(sockfd) < 0)
@@ -215,6 +232,22 @@ int sockets::getSocketError(int sockfd)
     }
 }
 
+int sockets::getIncomingCpu(int sockfd)
+{
+#ifdef SO_INCOMING_CPU
+    int cpu = -1;
+    socklen_t optlen = sizeof cpu;
+    if (::getsockopt(sockfd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, &optlen) < 0)
+    {
+        return -1;
+    }
+    return cpu;
+#else
+    (void)sockfd;
+    return -1;
+#endif
+}
+
 struct sockaddr_in sockets::getLocalAddr(int sockfd)    // 获取本地地址
 {
     struct sockaddr_in localaddr;
@@ -23,6 +23,8 @@ int  accept(int sockfd, struct sockaddr_in* addr);
 ssize_t read(int sockfd, void *buf, size_t count);
 ssize_t readv(int sockfd, const struct iovec *iov, int iovcnt);
 ssize_t write(int sockfd, const void *buf, size_t count);
+ssize_t writev(int sockfd, const struct iovec *iov, int iovcnt);
+ssize_t sendfile(int sockfd, int infd, off_t *offset, size_t count);
 void close(int sockfd);
 void shutdownWrite(int sockfd);
 
@@ -34,6 +36,8 @@ void fromIpPort(const char* ip, uint16_t port,
 struct sockaddr_in* addr);
 
 int getSocketError(int sockfd);
+/// CPU that processed the socket's packets (SO_INCOMING_CPU), -1 if unknown
+int getIncomingCpu(int sockfd);
 
 struct sockaddr_in getLocalAddr(int sockfd);
 struct sockaddr_in getPeerAddr(int sockfd);
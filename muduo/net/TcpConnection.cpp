@@ -3,6 +3,7 @@
 #include <muduo/base/Logging.h>
 #include <muduo/net/Channel.h>
 #include <muduo/net/EventLoop.h>
+#include <muduo/net/IdleConnectionList.h>
 #include <muduo/net/Socket.h>
 #include <muduo/net/SocketsOps.h>
 
@@ -40,7 +41,10 @@ TcpConnection::TcpConnection(EventLoop* loop,
     channel_(new Channel(loop, sockfd)),
     localAddr_(localAddr),
     peerAddr_(peerAddr),
-    highWaterMark_(64*1024*1024)
+    highWaterMark_(64*1024*1024),
+    inputBuffer_(0),                // 构造在accept线程, 真正的存储在IO线程第一次读时从该loop的BufferPool分配
+    reportedPendingBytes_(0),
+    ioBudget_(0)
 {
     // 通道可读事件到来的时候，回调TcpConnection::handleRead，_1是事件发生时间
     channel_->setReadCallback(boost::bind(&TcpConnection::handleRead, this, _1));
@@ -53,12 +57,14 @@ TcpConnection::TcpConnection(EventLoop* loop,
     LOG_DEBUG << "TcpConnection::ctor[" << name_ << "] at " << this
         << " fd=" << sockfd;
     socket_->setKeepAlive(true);
+    loop_->addConnections(1);       // 在构造时计数, 使accept线程连续选择loop时能看到刚分配的连接
 }
 
 TcpConnection::~TcpConnection()
 {
     LOG_DEBUG << "TcpConnection::dtor[" << name_ << "] at " << this
               << " fd=" << channel_->fd();
+    loop_->addConnections(-1);      // 与构造函数配对, 未经connectDestroyed销毁的连接也不会一直占着计数; 可能在其它线程, 计数是原子的
 }
 
 // 线程安全，可以跨线程调用
@@ -72,11 +78,14 @@ void TcpConnection::send(const void* data, size_t len)
         }
         else
         {
-            string message(static_cast<const char*>(data), len);    // 跨线程调用由一定的开销
+            // 跨线程调用由一定的开销, 拷贝一次后由发送队列直接引用
+            boost::shared_ptr<string> message(new string(static_cast<const char*>(data), len));
             loop_->runInLoop(
                 boost::bind(&TcpConnection::sendInLoop,
                             this,
-                            message));
+                            message->data(),
+                            message->size(),
+                            boost::shared_ptr<void>(message)));
         }
     }
 }
@@ -92,10 +101,13 @@ void TcpConnection::send(const StringPiece& message)
         }
         else
         {
+            boost::shared_ptr<string> copy(new string(message.data(), message.size()));
             loop_->runInLoop(
                 boost::bind(&TcpConnection::sendInLoop,
                             this,
-                            message.as_string()));
+                            copy->data(),
+                            copy->size(),
+                            boost::shared_ptr<void>(copy)));
                             //std::forward<string>(message)));
         }
     }
@@ -106,20 +118,80 @@ void TcpConnection::send(Buffer* buf)
 {
     if (state_ == kConnected)
     {
-        if (loop_->isInLoopThread())
+        if (loop_->isInLoopThread() && buf->readableBytes() < OutputQueue::kMinChunkSize)
         {
             sendInLoop(buf->peek(), buf->readableBytes());
             buf->retrieveAll();     // 缓冲区数据移出
         }
         else
+        {
+            // 交换出buf的内存由发送队列直接引用, 不拷贝数据, buf变为空缓冲区
+            boost::shared_ptr<Buffer> message(new Buffer);
+            message->swap(*buf);
+            if (loop_->isInLoopThread())
+            {
+                sendInLoop(message->peek(), message->readableBytes(), message);
+            }
+            else
+            {
+                loop_->runInLoop(
+                    boost::bind(&TcpConnection::sendInLoop,
+                                this,
+                                message->peek(),
+                                message->readableBytes(),
+                                boost::shared_ptr<void>(message)));
+            }
+        }
+    }
+}
+
+// 线程安全，可以跨线程调用
+void TcpConnection::send(const void* data, size_t len, const boost::shared_ptr<void>& owner)
+{
+    if (state_ == kConnected)
+    {
+        if (loop_->isInLoopThread())
+        {
+            sendInLoop(data, len, owner);
+        }
+        else
         {
             loop_->runInLoop(
                 boost::bind(&TcpConnection::sendInLoop,
                             this,
-                            buf->retrieveAllAsString()));
-                            //std::forward<string>(message)));
+                            data,
+                            len,
+                            owner));
+        }
+    }
+}
+
+// 线程安全，可以跨线程调用
+void TcpConnection::sendFile(int fd, off_t offset, size_t len,
+                             const SendFileCompleteCallback& cb)
+{
+    if (state_ == kConnected)
+    {
+        if (loop_->isInLoopThread())
+        {
+            sendFileInLoop(fd, offset, len, cb);
+        }
+        else
+        {
+            loop_->runInLoop(
+                boost::bind(&TcpConnection::sendFileInLoop,
+                            this,
+                            fd,
+                            offset,
+                            len,
+                            cb));
         }
     }
+    else if (cb)
+    {
+        // 连接已不可用也要回调, 调用方在cb中关闭fd; 总是排队执行, 不在调用者的栈上重入
+        loop_->queueInLoop(boost::bind(cb, shared_from_this(), fd));
+    }
 }
 
 void TcpConnection::sendInLoop(const StringPiece& message)
@@ -128,6 +200,12 @@ void TcpConnection::sendInLoop(const StringPiece& message)
 }
 
 void TcpConnection::sendInLoop(const void* data, size_t len)
+{
+    sendInLoop(data, len, boost::shared_ptr<void>());
+}
+
+// owner为空时剩余数据拷贝到发送队列, 否则发送队列直接引用data
+void TcpConnection::sendInLoop(const void* data, size_t len, const boost::shared_ptr<void>& owner)
 {
     /*
     loop_->assertInLoopThread();
@@ -143,8 +221,8 @@ void TcpConnection::sendInLoop(const void* data, size_t len)
         return;
     }
     // if no thing in output queue, try writing directly
-    // 通道没有关注可写事件并且发送缓冲区没有数据，直接write
-    if (!channel_->isWriting() && outputBuffer_.readableBytes() == 0)
+    // 通道没有关注可写事件并且发送队列没有数据，直接write
+    if (!channel_->isWriting() && outputQueue_.empty())
     {
         nwrote = sockets::write(channel_->fd(), data, len);
         if (nwrote >= 0)
@@ -170,11 +248,11 @@ void TcpConnection::sendInLoop(const void* data, size_t len)
     }
 
     assert(remaining <= len);
-    // 没有错误，并且还有未写完的数据（说明内核发送缓冲区满，要将未写完的数据添加到output buffer中）
+    // 没有错误，并且还有未写完的数据（说明内核发送缓冲区满，要将未写完的数据添加到发送队列中）
     if (!error && remaining > 0)
     {
         LOG_TRACE << "I am going to write more data";
-        size_t oldLen = outputBuffer_.readableBytes();
+        size_t oldLen = outputQueue_.readableBytes();
         // 如果超过highWaterMark_（高水位标），回调highWaterMarkCallback_
         if (oldLen + remaining >= highWaterMark_
             && oldLen < highWaterMark_
@@ -182,7 +260,16 @@ void TcpConnection::sendInLoop(const void* data, size_t len)
         {
             loop_->queueInLoop(boost::bind(highWaterMarkCallback_, shared_from_this(), oldLen + remaining));
         }
-        outputBuffer_.append(static_cast<const char*>(data)+nwrote, remaining);
+        const char* rest = static_cast<const char*>(data) + nwrote;
+        if (owner)
+        {
+            outputQueue_.append(rest, remaining, owner);
+        }
+        else
+        {
+            outputQueue_.append(rest, remaining);
+        }
+        updatePendingBytes();
         if (!channel_->isWriting())         // 还有数据要发送, 检查是否关注POLLOUT
         {
             channel_->enableWriting();      // 若没有关注POLLOUT, 则关注POLLOUT事件
@@ -190,6 +277,85 @@ void TcpConnection::sendInLoop(const void* data, size_t len)
     }
 }
 
+void TcpConnection::sendFileInLoop(int fd, off_t offset, size_t len,
+                                   const SendFileCompleteCallback& cb)
+{
+    loop_->assertInLoopThread();
+    size_t remaining = len;
+    bool error = false;
+    if (state_ == kDisconnected)
+    {
+        LOG_WARN << "disconnected, give up sending file";
+        if (cb)
+        {
+            loop_->queueInLoop(boost::bind(cb, shared_from_this(), fd));
+        }
+        return;
+    }
+    // 发送队列为空时直接sendfile, 与sendInLoop相同
+    if (!channel_->isWriting() && outputQueue_.empty() && len > 0)
+    {
+        ssize_t nwrote = sockets::sendfile(channel_->fd(), fd, &offset, len);
+        if (nwrote > 0)
+        {
+            remaining = len - nwrote;
+        }
+        else if (nwrote == 0)
+        {
+            LOG_ERROR << "TcpConnection::sendFileInLoop - fd " << fd
+                      << " ends before " << len << " bytes";
+            remaining = 0;
+        }
+        else // nwrote < 0
+        {
+            // 除EAGAIN/EINTR外都不会自行恢复(fd是管道时ESPIPE/EINVAL, EBADF, EIO, EPIPE...),
+            // 排队重试只会让POLLOUT一直触发
+            if (errno != EWOULDBLOCK && errno != EINTR)
+            {
+                LOG_SYSERR << "TcpConnection::sendFileInLoop";
+                error = true;
+            }
+        }
+    }
+
+    if (error)
+    {
+        if (cb)
+        {
+            loop_->queueInLoop(boost::bind(cb, shared_from_this(), fd));
+        }
+        forceClose();   // 文件内容缺失, 对端收到的字节流已不完整
+        return;
+    }
+
+    if (remaining == 0 && outputQueue_.empty() && !channel_->isWriting())  // 文件已全部发送
+    {
+        if (cb)
+        {
+            loop_->queueInLoop(boost::bind(cb, shared_from_this(), fd));
+        }
+        if (writeCompleteCallback_)
+        {
+            loop_->queueInLoop(boost::bind(writeCompleteCallback_, shared_from_this()));
+        }
+        return;
+    }
+
+    size_t oldLen = outputQueue_.readableBytes();
+    if (oldLen + remaining >= highWaterMark_
+        && oldLen < highWaterMark_
+        && highWaterMarkCallback_)
+    {
+        loop_->queueInLoop(boost::bind(highWaterMarkCallback_, shared_from_this(), oldLen + remaining));
+    }
+    outputQueue_.appendFile(fd, offset, remaining, cb);
+    updatePendingBytes();
+    if (!channel_->isWriting())
+    {
+        channel_->enableWriting();
+    }
+}
+
 void TcpConnection::shutdown()              // 如果缓冲区还有数据写入, 则关闭操作只改变状态没有其余操作
 {
     // FIXME: use compare and swap
@@ -201,6 +367,26 @@ void TcpConnection::shutdown()              // 如果缓冲区还有数据写入
     }
 }
 
+void TcpConnection::forceClose()
+{
+    // FIXME: use compare and swap
+    if (state_ == kConnected || state_ == kDisconnecting)
+    {
+        setState(kDisconnecting);
+        loop_->queueInLoop(boost::bind(&TcpConnection::forceCloseInLoop, shared_from_this()));
+    }
+}
+
+void TcpConnection::forceCloseInLoop()
+{
+    loop_->assertInLoopThread();
+    if (state_ == kConnected || state_ == kDisconnecting)
+    {
+        // as if we received 0 byte in handleRead();
+        handleClose();
+    }
+}
+
 void TcpConnection::shutdownInLoop()
 {
     loop_->assertInLoopThread();
@@ -224,7 +410,20 @@ void TcpConnection::connectEstablished()
     setState(kConnected);
     LOG_TRACE << "[3] usecount=" << shared_from_this().use_count(); // 当前对象转换为shared_ptr对象, 引用计数+1, 引用计数=3, 由于是临时对象, 创建后立即销毁, 之后变为2
     channel_->tie(shared_from_this());  // 当前TcpConnection对象转换成shared_ptr对象, tie中弱引用不会更改计数, 引用计数+1=3, 临时对象销毁变为2 
+    if (ioBudget_ > 0 && !loop_->supportsEdgeTrigger())
+    {
+        ioBudget_ = 0;                  // poll(2)只有水平触发
+    }
+    channel_->setEdgeTriggered(ioBudget_ > 0);
+    if (ioBudget_ == 0 && loop_->supportsCompletion())
+    {
+        channel_->setCompletion(Channel::kCompleteRecv);  // 由poller读入provided buffer
+    }
     channel_->enableReading();          // TcpConnection所对应的通道加入到Poller关注
+    if (idleList_)
+    {
+        idleList_->touch(this);
+    }
 
     connectionCallback_(shared_from_this());    // 连接建立时用户回调函数, 临时对象建立又销毁, 引用计数不变 
     LOG_TRACE << "[4] usecount=" << shared_from_this().use_count(); // 当前对象转换为shared_ptr对象, 引用计数+1, 引用计数=3, 由于是临时对象, 创建后立即销毁, 之后变为2
@@ -233,6 +432,10 @@ void TcpConnection::connectEstablished()
 void TcpConnection::connectDestroyed()
 {
     loop_->assertInLoopThread();
+    if (idleList_)
+    {
+        idleList_->remove(this);    // 必须在IO线程中摘除, 最后一个引用可能在其它线程释放
+    }
     if (state_ == kConnected)
     {
         setState(kDisconnected);
@@ -241,6 +444,36 @@ void TcpConnection::connectDestroyed()
         connectionCallback_(shared_from_this());    // 实际上不会回调用户回调函数, 因为handleClose已经把状态设置为kDisconnected, if条件进不去 
     }
     channel_->remove();                             // Channel从Poller中移除
+    dropOutput();                                   // 未经handleClose直接销毁时, 发送队列可能还有文件片
+    // 连接从本loop移除, 撤销其对loop负载计数的贡献
+    loop_->addPendingBytes(-reportedPendingBytes_);
+    reportedPendingBytes_ = 0;
+}
+
+// 剩余数据不会再发送了, 文件片的cb在这里直接回调, 此时connected()已为false
+void TcpConnection::dropOutput()
+{
+    OutputQueue::CompletedFileList dropped;
+    outputQueue_.clear(&dropped);
+    updatePendingBytes();
+    for (size_t i = 0; i < dropped.size(); ++i)
+    {
+        if (dropped[i].callback)
+        {
+            dropped[i].callback(shared_from_this(), dropped[i].fd);
+        }
+    }
+}
+
+// 把发送队列长度的变化累加到loop的pendingBytes, 在每次修改outputQueue_后调用
+void TcpConnection::updatePendingBytes()
+{
+    int64_t pending = static_cast<int64_t>(outputQueue_.readableBytes());
+    if (pending != reportedPendingBytes_)
+    {
+        loop_->addPendingBytes(pending - reportedPendingBytes_);
+        reportedPendingBytes_ = pending;
+    }
 }
 
 void TcpConnection::handleRead(Timestamp receiveTime)
@@ -248,11 +481,30 @@ void TcpConnection::handleRead(Timestamp receiveTime)
 
     // 使用Buffer缓冲区 
     loop_->assertInLoopThread();
+    if (ioBudget_ > 0)
+    {
+        handleReadEdgeTriggered(receiveTime);
+        return;
+    }
+    if (channel_->completion() != Channel::kNoCompletion)
+    {
+        handleReadCompletions(receiveTime);
+        return;
+    }
     int savedErrno = 0;
-    ssize_t n = inputBuffer_.readFd(channel_->fd(), &savedErrno);
+    // 按预测值预留空间, 活跃连接的数据直接读入inputBuffer_, 超出部分才经过EventLoop的共享溢出区
+    inputBuffer_.ensureWritableBytes(readSizePredictor_.nextReadSize());
+    ssize_t n = inputBuffer_.readFd(channel_->fd(), &savedErrno,
+                                    loop_->readOverflow(), loop_->readOverflowSize());
     if (n > 0)
     {
+        readSizePredictor_.record(n);
+        if (idleList_)
+        {
+            idleList_->touch(this);    // 有活动, 移到空闲链表尾部
+        }
         messageCallback_(shared_from_this(), &inputBuffer_, receiveTime);
+        trimInputBuffer();
     }
     else if (n == 0)
     {
@@ -288,43 +540,170 @@ void TcpConnection::handleRead(Timestamp receiveTime)
     */
 }
 
+// 边沿触发: 读到EAGAIN或读不满为止, 否则不会再有可读通知
+// 每次最多读ioBudget_字节, 读满预算后让出IO线程, 剩余数据在本轮事件处理之后继续读
+void TcpConnection::handleReadEdgeTriggered(Timestamp receiveTime)
+{
+    if (state_ == kDisconnected)        // 继续读的任务排队期间连接已关闭
+    {
+        return;
+    }
+    size_t total = 0;
+    bool drained = false;
+    ssize_t n = 0;
+    int savedErrno = 0;
+    while (total < ioBudget_)
+    {
+        inputBuffer_.ensureWritableBytes(readSizePredictor_.nextReadSize());
+        // 与Buffer::readFd一致: 缓冲区足够大时不使用溢出区
+        size_t writable = inputBuffer_.writableBytes();
+        size_t offered = writable < loop_->readOverflowSize() ? writable + loop_->readOverflowSize() : writable;
+        n = inputBuffer_.readFd(channel_->fd(), &savedErrno,
+                                loop_->readOverflow(), loop_->readOverflowSize());
+        if (n <= 0)
+        {
+            break;
+        }
+        readSizePredictor_.record(n);
+        total += n;
+        if (implicit_cast<size_t>(n) < offered)   // 没读满说明接收缓冲区已空, 省去一次返回EAGAIN的read
+        {
+            drained = true;
+            break;
+        }
+    }
+
+    if (total > 0)
+    {
+        if (idleList_)
+        {
+            idleList_->touch(this);
+        }
+        messageCallback_(shared_from_this(), &inputBuffer_, receiveTime);   // 本次读到的数据只回调一次
+        trimInputBuffer();
+    }
+    if (n == 0)
+    {
+        handleClose();
+    }
+    else if (n < 0)
+    {
+        if (savedErrno != EAGAIN)
+        {
+            errno = savedErrno;
+            LOG_SYSERR << "TcpConnection::handleRead";
+            handleError();
+        }
+    }
+    else if (!drained)                  // 用完预算, 可能还有数据
+    {
+        loop_->queueInLoop(boost::bind(&TcpConnection::handleReadEdgeTriggered,
+                                       shared_from_this(), receiveTime));
+    }
+}
+
+// poller已经读好的数据复制进inputBuffer_, 省去readv; 结果为0或负数时与readFd的返回值一样处理
+void TcpConnection::handleReadCompletions(Timestamp receiveTime)
+{
+    const Channel::CompletionList& results = channel_->completions();
+    size_t total = 0;
+    int result = 1;
+    for (size_t i = 0; i < results.size() && result > 0; ++i)
+    {
+        result = results[i].result;
+        if (result > 0)
+        {
+            inputBuffer_.append(results[i].data, result);
+            total += result;
+        }
+    }
+
+    if (total > 0)
+    {
+        if (idleList_)
+        {
+            idleList_->touch(this);
+        }
+        messageCallback_(shared_from_this(), &inputBuffer_, receiveTime);   // 本轮读到的数据只回调一次
+        trimInputBuffer();
+    }
+    if (result == 0)
+    {
+        handleClose();
+    }
+    else if (result < 0)
+    {
+        errno = -result;
+        LOG_SYSERR << "TcpConnection::handleRead";
+        handleError();
+    }
+}
+
+// 数据已被取完并且容量远大于预测值, 归还多余的内存
+void TcpConnection::trimInputBuffer()
+{
+    if (inputBuffer_.readableBytes() == 0
+        && inputBuffer_.internalCapacity() > Buffer::kCheapPrepend + 2 * readSizePredictor_.nextReadSize())
+    {
+        inputBuffer_.shrink(readSizePredictor_.nextReadSize());
+    }
+}
+
 // 内核发送缓冲区有空间了，回调该函数, POLLOUT事件触发了
+// 连续的内存片一次writev发送, 文件片用sendfile发送, 直到全部发送完或内核发送缓冲区满
 void TcpConnection::handleWrite()
 {
     loop_->assertInLoopThread();
     if (channel_->isWriting())
     {
-        ssize_t n = sockets::write(channel_->fd(),      // 不确定是否能把所有数据写入
-                                   outputBuffer_.peek(),
-                                   outputBuffer_.readableBytes());
-        if (n > 0)
+        int savedErrno = 0;
+        OutputQueue::CompletedFileList completed;
+        // 边沿触发时最多写ioBudget_字节, 水平触发时一直写到队列为空或内核缓冲区满
+        size_t maxBytes = ioBudget_ > 0 ? ioBudget_ : static_cast<size_t>(-1);
+        ssize_t n = outputQueue_.writeFd(channel_->fd(), &savedErrno, &completed, maxBytes);
+        updatePendingBytes();
+        if (n > 0 && idleList_)
+        {
+            idleList_->touch(this);
+        }
+        LOG_TRACE << "TcpConnection::handleWrite wrote " << n << " bytes";
+        for (size_t i = 0; i < completed.size(); ++i)
         {
-            outputBuffer_.retrieve(n);
-            if (outputBuffer_.readableBytes() == 0)     // 发送缓冲区已清空
+            if (completed[i].callback)
             {
-                channel_->disableWriting();     // 停止关注POLLOUT事件，以免出现busy loop
-                if (writeCompleteCallback_)     // 回调writeCompleteCallback_
-                {
-                    // 应用层发送缓冲区被清空，就回调用writeCompleteCallback_
-                    loop_->queueInLoop(boost::bind(writeCompleteCallback_, shared_from_this()));
-                }
-                if (state_ == kDisconnecting)   // 发送缓冲区已清空并且连接状态是kDisconnecting(之前调用过TcpConnection::shutdown), 要关闭连接
-                {
-                    shutdownInLoop();           // 前面发生完已经disableWriting了, shutdownInLoop会关闭连接
-                }
+                loop_->queueInLoop(boost::bind(completed[i].callback, shared_from_this(), completed[i].fd));
             }
-            else
+        }
+        if (savedErrno != 0 && savedErrno != EWOULDBLOCK && savedErrno != EINTR)
+        {
+            errno = savedErrno;
+            LOG_SYSERR << "TcpConnection::handleWrite";
+            // 出错的文件片已从队列移除并回调, 剩余数据也无法按序送达, 关闭连接, 否则POLLOUT会一直触发
+            forceCloseInLoop();
+            return;
+        }
+
+        if (outputQueue_.empty())           // 发送队列已清空
+        {
+            channel_->disableWriting();     // 停止关注POLLOUT事件，以免出现busy loop
+            if (writeCompleteCallback_)     // 回调writeCompleteCallback_
+            {
+                // 应用层发送缓冲区被清空，就回调用writeCompleteCallback_
+                loop_->queueInLoop(boost::bind(writeCompleteCallback_, shared_from_this()));
+            }
+            if (state_ == kDisconnecting)   // 发送缓冲区已清空并且连接状态是kDisconnecting(之前调用过TcpConnection::shutdown), 要关闭连接
             {
-                LOG_TRACE << "I am going to write more data";
+                shutdownInLoop();           // 前面发生完已经disableWriting了, shutdownInLoop会关闭连接
             }
         }
         else
         {
-            LOG_SYSERR << "TcpConnection::handleWrite";
-            // if (state_ == kDisconnecting)
-            // {
-            //   shutdownInLoop();
-            // }
+            LOG_TRACE << "I am going to write more data";
+            if (ioBudget_ > 0 && savedErrno == 0 && implicit_cast<size_t>(n) >= maxBytes)
+            {
+                // 边沿触发下用完预算时内核缓冲区可能还有空间, 不会再有POLLOUT, 排队继续写
+                loop_->queueInLoop(boost::bind(&TcpConnection::handleWrite, shared_from_this()));
+            }
         }
     }
     else
@@ -342,6 +721,11 @@ void TcpConnection::handleClose()
     // we don't close fd, leave it to dtor, so we can find leaks easily.
     setState(kDisconnected);                        // connectionCallback_若注释, 这行状态改变也应该注释掉
     channel_->disableAll();
+    dropOutput();
+    if (idleList_)
+    {
+        idleList_->remove(this);
+    }
 
     //TcpConnectionPtr guardThis(This);             // 相当于又构造一个独立的shared_ptr对象, 引用计数=1, 而不是+1
     TcpConnectionPtr guardThis(shared_from_this()); // 返回自身对象的shared_ptr, shared_ptr被接收后引用计数=3
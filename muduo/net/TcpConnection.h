@@ -7,9 +7,12 @@
 #include <muduo/net/Callbacks.h>
 #include <muduo/net/Buffer.h>
 #include <muduo/net/InetAddress.h>
+#include <muduo/net/OutputQueue.h>
+#include <muduo/net/ReadSizePredictor.h>
 
 #include <boost/any.hpp>
 #include <boost/enable_shared_from_this.hpp>
+#include <boost/intrusive/list_hook.hpp>
 #include <boost/noncopyable.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
@@ -37,6 +40,7 @@ namespace net
 
 class Channel;
 class EventLoop;
+class IdleConnectionList;
 class Socket;
 
 ///
@@ -68,7 +72,19 @@ public:
     void send(const StringPiece& message);
     // void send(Buffer&& message); // C++11
     void send(Buffer* message);     // this one will swap data
+    /// Sends without copying, @c message must stay valid as long as @c owner is alive.
+    /// Thread safe.
+    void send(const void* message, size_t len, const boost::shared_ptr<void>& owner);
+    /// Sends [offset, offset+len) of file @c fd with sendfile(2),
+    /// ordered after everything already passed to send().
+    /// @c fd is not owned, keep it open until @c cb is called.
+    /// @c cb is called exactly once, also when the connection is closed or
+    /// sendfile fails before the whole range is sent, check connected() there.
+    /// Thread safe.
+    void sendFile(int fd, off_t offset, size_t len,
+                  const SendFileCompleteCallback& cb = SendFileCompleteCallback());
     void shutdown();                // NOT thread safe, no simultaneous calling, 服务端主动断开与客户端的连接, 这意味着客户端read返回0, 会close(conn)
+    void forceClose();              // 直接关闭连接, 不等待发送队列清空
     void setTcpNoDelay(bool on);
 
     void setContext(const boost::any& context)
@@ -99,6 +115,16 @@ public:
     void setCloseCallback(const CloseCallback& cb)	// 内部使用
     { closeCallback_ = cb; }
 
+    /// Internal use only, set before connectEstablished().
+    void setIdleList(const boost::shared_ptr<IdleConnectionList>& list)
+    { idleList_ = list; }
+
+    /// Registers the socket edge-triggered if the poller supports it, reads and
+    /// writes until EAGAIN but at most @c ioBudget bytes each per wakeup.
+    /// Internal use only, set before connectEstablished().
+    void setEdgeTriggered(size_t ioBudget)
+    { ioBudget_ = ioBudget; }
+
     // called when TcpServer accepts a new connection
     void connectEstablished();  // should be called only once
     // called when TcpServer has removed me from its map
@@ -107,13 +133,21 @@ public:
 private:
     enum StateE { kDisconnected, kConnecting, kConnected, kDisconnecting };
     void handleRead(Timestamp receiveTime);
+    void handleReadEdgeTriggered(Timestamp receiveTime);
+    void handleReadCompletions(Timestamp receiveTime);
+    void trimInputBuffer();
     void handleWrite();
     void handleClose();
     void handleError();         // Channel中可能会有些错误事件
     void sendInLoop(const StringPiece& message);
     void sendInLoop(const void* message, size_t len);
+    void sendInLoop(const void* message, size_t len, const boost::shared_ptr<void>& owner);
+    void sendFileInLoop(int fd, off_t offset, size_t len, const SendFileCompleteCallback& cb);
     void shutdownInLoop();
+    void forceCloseInLoop();
     void setState(StateE s) { state_ = s; }
+    void updatePendingBytes();
+    void dropOutput();          // 连接关闭时丢弃发送队列, 回调其中文件片的cb
 
     EventLoop   *loop_;         // 所属EventLoop
     string      name_;          // 连接名
@@ -126,14 +160,25 @@ private:
     ConnectionCallback  connectionCallback_;
     MessageCallback     messageCallback_;
     WriteCompleteCallback writeCompleteCallback_;   // 数据发送完毕回调函数，即所有的用户数据都已拷贝到内核缓冲区时回调该函数
-                                                    // outputBuffer_被清空也会回调该函数，可以理解为低水位标回调函数
-    HighWaterMarkCallback highWaterMarkCallback_;   // 高水位标回调函数, writeCompleteCallback_调用不及时, outputBuffer_不断增大, 
+                                                    // outputQueue_被清空也会回调该函数，可以理解为低水位标回调函数
+    HighWaterMarkCallback highWaterMarkCallback_;   // 高水位标回调函数, writeCompleteCallback_调用不及时, outputQueue_不断增大, 
                                                     // 使用这个函数可以断开与对方连接, 避免内存不断增大
     CloseCallback       closeCallback_;		// Callback.h中定义, 内部连接断开回调函数, 即TcpServer中removeConnection回调函数, 不是用户外部回调函数
     size_t highWaterMark_;      // 高水位标
     Buffer inputBuffer_;        // 应用层接收缓冲区
-    Buffer outputBuffer_;       // 应用层发送缓冲区
+    ReadSizePredictor readSizePredictor_;   // 根据最近的读取量调整inputBuffer_的预留空间
+    OutputQueue outputQueue_;   // 应用层发送队列, 内存片与文件片按顺序发送
+    int64_t reportedPendingBytes_;  // 已计入loop_->pendingBytes()的发送队列长度
+    size_t ioBudget_;           // 边沿触发时每次事件最多读/写的字节数, 0表示水平触发
     boost::any context_;        // 绑定一个未知类型的上下文对象
+
+    // 空闲连接检测, 由IdleConnectionList使用
+    friend class IdleConnectionList;
+    typedef boost::intrusive::list_member_hook<
+        boost::intrusive::link_mode<boost::intrusive::auto_unlink> > IdleHook;
+    boost::shared_ptr<IdleConnectionList> idleList_;    // TcpServer::setIdleTimeout未设置时为空
+    IdleHook    idleHook_;
+    Timestamp   lastActiveTime_;    // 最近一次读写的单调时间
 };
 
 typedef boost::shared_ptr<TcpConnection> TcpConnectionPtr;  // 会不会与Callbacks.h中TcpConnectionPtr重复?
@@ -1,9 +1,11 @@
 ﻿#include <muduo/net/TcpServer.h>
 
+#include <muduo/base/CountDownLatch.h>
 #include <muduo/base/Logging.h>
 #include <muduo/net/Acceptor.h>
 #include <muduo/net/EventLoop.h>
 #include <muduo/net/EventLoopThreadPool.h>
+#include <muduo/net/IdleConnectionList.h>
 #include <muduo/net/SocketsOps.h>
 
 #include <boost/bind.hpp>
@@ -15,20 +17,29 @@ using namespace muduo::net;
 
 TcpServer::TcpServer(EventLoop* loop,
                      const InetAddress& listenAddr,
-                     const string& nameArg)
+                     const string& nameArg,
+                     Option option)
     : loop_(CHECK_NOTNULL(loop)),           // Logging.h确保loop不为NULL
+    listenAddr_(listenAddr),
+    reusePort_(option == kReusePort),
     hostport_(listenAddr.toIpPort()),
     name_(nameArg),
-    acceptor_(new Acceptor(loop, listenAddr)),
+    acceptor_(reusePort_ ? NULL : new Acceptor(loop, listenAddr)),  // kReusePort模式的Acceptor在start()中为每个IO线程创建
     threadPool_(new EventLoopThreadPool(loop)),
     connectionCallback_(defaultConnectionCallback),     // 默认回调函数, 在TcpConnection中定义
     messageCallback_(defaultMessageCallback),           // 默认回调函数, 在TcpConnection中定义
     started_(false),
-    nextConnId_(1)
+    ioBudget_(0),
+    acceptBurst_(0),
+    idleSeconds_(0.0)
 {
-    // Acceptor::handleRead函数中会回调用TcpServer::newConnection
-    // _1对应的是socket文件描述符，_2对应的是对等方的地址(InetAddress)
-    acceptor_->setNewConnectionCallback(boost::bind(&TcpServer::newConnection, this, _1, _2));
+    nextConnId_.getAndSet(1);
+    if (acceptor_)
+    {
+        // Acceptor::handleRead函数中会回调用TcpServer::newConnection
+        // _1对应的是socket文件描述符，_2对应的是对等方的地址(InetAddress)
+        acceptor_->setNewConnectionCallback(boost::bind(&TcpServer::newConnection, this, _1, _2));
+    }
 }
 
 TcpServer::~TcpServer()
@@ -36,6 +47,18 @@ TcpServer::~TcpServer()
     loop_->assertInLoopThread();
     LOG_TRACE << "TcpServer::~TcpServer [" << name_ << "] destructing";
 
+    if (!loopAcceptors_.empty())
+    {
+        // Acceptor与连接只能在各自的IO线程中销毁, 等待全部完成
+        CountDownLatch latch(static_cast<int>(loopAcceptors_.size()));
+        for (AcceptorMap::iterator it = loopAcceptors_.begin();
+            it != loopAcceptors_.end(); ++it)
+        {
+            it->first->runInLoop(boost::bind(&TcpServer::stopInLoop, this, it->first, &latch));
+        }
+        latch.wait();
+    }
+
     for (ConnectionMap::iterator it(connections_.begin());
         it != connections_.end(); ++it)
     {
@@ -52,6 +75,36 @@ void TcpServer::setThreadNum(int numThreads)
     threadPool_->setThreadNum(numThreads);      // 设置线程池中IO线程的个数, 不包含mainReactor所属的IO线程, 实际线程数量numThreads+1
 }
 
+void TcpServer::setAcceptBurst(int burst)
+{
+    acceptBurst_ = burst;
+    if (acceptor_)
+    {
+        acceptor_->setAcceptBurst(burst);
+    }
+}
+
+int64_t TcpServer::acceptRate() const
+{
+    loop_->assertInLoopThread();
+    if (acceptor_)
+    {
+        return acceptor_->acceptRate();
+    }
+    int64_t rate = 0;
+    for (AcceptorMap::const_iterator it = loopAcceptors_.begin();
+        it != loopAcceptors_.end(); ++it)
+    {
+        rate += it->second->acceptRate();
+    }
+    return rate;
+}
+
+void TcpServer::setThreadSelectPolicy(EventLoopThreadPool::SelectPolicy policy)
+{
+    threadPool_->setSelectPolicy(policy);
+}
+
 // 该函数多次调用是无害的
 // 该函数可以跨线程调用
 void TcpServer::start()
@@ -60,9 +113,49 @@ void TcpServer::start()
     {
         started_ = true;
         threadPool_->start(threadInitCallback_);    // 线程初始化回调函数, 通过setThreadInitCallback来设置
+        std::vector<EventLoop*> loops = threadPool_->getAllLoops();
+        if (idleSeconds_ > 0.0)
+        {
+            for (size_t i = 0; i < loops.size(); ++i)
+            {
+                boost::shared_ptr<IdleConnectionList> list(new IdleConnectionList(loops[i], idleSeconds_));
+                list->start();
+                idleLists_[loops[i]] = list;
+            }
+        }
+        if (reusePort_)
+        {
+            // 每个IO线程一个绑定同一端口的Acceptor, 由内核分配新连接, 不再经过loop_
+            for (size_t i = 0; i < loops.size(); ++i)
+            {
+                boost::shared_ptr<Acceptor> acceptor(new Acceptor(loops[i], listenAddr_, true));
+                if (acceptBurst_ > 0)
+                {
+                    acceptor->setAcceptBurst(acceptBurst_);
+                }
+                if (threadPool_->selectPolicy() == EventLoopThreadPool::kIncomingCpu)
+                {
+                    // 让内核把SYN由该loop所绑定CPU处理的连接交给这个监听套接字
+                    CpuAffinity::CpuSet cpus = threadPool_->getLoopCpus(loops[i]);
+                    if (!cpus.empty())
+                    {
+                        acceptor->setIncomingCpu(cpus[0]);
+                    }
+                }
+                acceptor->setNewConnectionCallback(
+                    boost::bind(&TcpServer::newLocalConnection, this, loops[i], _1, _2));
+                loopConnections_[loops[i]];
+                loopAcceptors_[loops[i]] = acceptor;
+            }
+            // 两个map都填好之后再开始监听, 否则先启动的loop在newLocalConnection中查找时, 这里还在插入
+            for (size_t i = 0; i < loops.size(); ++i)
+            {
+                loops[i]->runInLoop(boost::bind(&Acceptor::listen, get_pointer(loopAcceptors_.find(loops[i])->second)));
+            }
+        }
     }
 
-    if (!acceptor_->listenning())   // 第二次调用start时, acceptor_->listening()处于true状态
+    if (acceptor_ && !acceptor_->listenning())   // 第二次调用start时, acceptor_->listening()处于true状态
     {
         // get_pointer返回原生指针
         loop_->runInLoop(           // runInLoop, 可以跨线程调用
@@ -73,11 +166,45 @@ void TcpServer::start()
 void TcpServer::newConnection(int sockfd, const InetAddress& peerAddr)
 {
     loop_->assertInLoopThread();
-    // 按照轮叫的方式选择一个EventLoop
-    EventLoop* ioLoop = threadPool_->getNextLoop();
+    // 按照线程池的选择策略选择一个EventLoop, 默认轮叫
+    EventLoop* ioLoop = NULL;
+    switch (threadPool_->selectPolicy())
+    {
+    case EventLoopThreadPool::kPeerAddressHash:
+        ioLoop = threadPool_->getLoopForHash(peerAddr.ipNetEndian());
+        break;
+    case EventLoopThreadPool::kIncomingCpu:
+        ioLoop = threadPool_->getLoopForCpu(sockets::getIncomingCpu(sockfd));
+        break;
+    default:
+        break;
+    }
+    if (ioLoop == NULL)     // 没有绑定在该CPU上的loop时退回轮叫
+    {
+        ioLoop = threadPool_->getNextLoop();
+    }
+    TcpConnectionPtr conn(createConnection(ioLoop, sockfd, peerAddr));
+    connections_[conn->name()] = conn;                      // 加入到列表中
+    LOG_TRACE << "[2] usecount=" << conn.use_count();       // 引用计数=2
+
+    //conn->connectEstablished();       // 直接调用意味着在当前IO线程内调用, 应该让ioLoop所属的IO线程调用connectEstablished
+    ioLoop->runInLoop(boost::bind(&TcpConnection::connectEstablished, conn));
+    LOG_TRACE << "[5] usecount=" << conn.use_count();
+}   // conn是一个临时对象, 跳出newConnection后, 引用计数为1, 列表connections_列表中有一个shared_ptr对象
+
+// kReusePort模式, 连接在accept它的IO线程中建立, 不需要跨线程
+void TcpServer::newLocalConnection(EventLoop* ioLoop, int sockfd, const InetAddress& peerAddr)
+{
+    ioLoop->assertInLoopThread();
+    TcpConnectionPtr conn(createConnection(ioLoop, sockfd, peerAddr));
+    loopConnections_.find(ioLoop)->second[conn->name()] = conn;
+    conn->connectEstablished();
+}
+
+TcpConnectionPtr TcpServer::createConnection(EventLoop* ioLoop, int sockfd, const InetAddress& peerAddr)
+{
     char buf[32];
-    snprintf(buf, sizeof buf, ":%s#%d", hostport_.c_str(), nextConnId_);
-    ++nextConnId_;
+    snprintf(buf, sizeof buf, ":%s#%d", hostport_.c_str(), nextConnId_.getAndAdd(1));
     string connName = name_ + buf;
 
     LOG_INFO << "TcpServer::newConnection [" << name_
@@ -97,19 +224,20 @@ void TcpServer::newConnection(int sockfd, const InetAddress& peerAddr)
                                             localAddr,
                                             peerAddr));
     LOG_TRACE << "[1] usecount=" << conn.use_count();       // 引用计数=1
-    connections_[connName] = conn;                          // 加入到列表中
-    LOG_TRACE << "[2] usecount=" << conn.use_count();       // 引用计数=2
     conn->setConnectionCallback(connectionCallback_);       // 连接到来回调函数
     conn->setMessageCallback(messageCallback_);             // 消息到来回调函数
     conn->setWriteCompleteCallback(writeCompleteCallback_); // 数据发送完毕回调函数
+    conn->setEdgeTriggered(ioBudget_);
 
     conn->setCloseCallback(
         boost::bind(&TcpServer::removeConnection, this, _1));
-    
-    //conn->connectEstablished();       // 直接调用意味着在当前IO线程内调用, 应该让ioLoop所属的IO线程调用connectEstablished
-    ioLoop->runInLoop(boost::bind(&TcpConnection::connectEstablished, conn));
-    LOG_TRACE << "[5] usecount=" << conn.use_count();
-}   // conn是一个临时对象, 跳出newConnection后, 引用计数为1, 列表connections_列表中有一个shared_ptr对象
+    IdleListMap::const_iterator idle = idleLists_.find(ioLoop);
+    if (idle != idleLists_.end())
+    {
+        conn->setIdleList(idle->second);
+    }
+    return conn;
+}
 
 void TcpServer::removeConnection(const TcpConnectionPtr& conn)
 {
@@ -131,19 +259,24 @@ void TcpServer::removeConnection(const TcpConnectionPtr& conn)
     LOG_TRACE << "[10] usecount=" << conn.use_count();
     */
 
-    loop_->runInLoop(boost::bind(&TcpServer::removeConnectionInLoop, this, conn));
+    // kReusePort模式下连接列表在连接所属的IO线程中
+    EventLoop* loop = reusePort_ ? conn->getLoop() : loop_;
+    loop->runInLoop(boost::bind(&TcpServer::removeConnectionInLoop, this, conn));
 
 }
 
 void TcpServer::removeConnectionInLoop(const TcpConnectionPtr& conn)
 {
-    loop_->assertInLoopThread();
+    EventLoop* loop = reusePort_ ? conn->getLoop() : loop_;
+    loop->assertInLoopThread();
+    // start()之后loopConnections_只查找不插入, 多个IO线程可以同时访问
+    ConnectionMap& connections = reusePort_ ? loopConnections_.find(loop)->second : connections_;
     LOG_INFO << "TcpServer::removeConnectionInLoop [" << name_
         << "] - connection " << conn->name();
 
 
     LOG_TRACE << "[8] usecount=" << conn.use_count();           // 引用计数不变, 仍为3
-    size_t n = connections_.erase(conn->name());                // 从列表中移除, 引用计数-1 
+    size_t n = connections.erase(conn->name());                 // 从列表中移除, 引用计数-1 
     LOG_TRACE << "[9] usecount=" << conn.use_count();           // 引用计数-1=2
 
     (void)n;
@@ -156,4 +289,20 @@ void TcpServer::removeConnectionInLoop(const TcpConnectionPtr& conn)
     //loop_->queueInLoop(
     //    boost::bind(&TcpConnection::connectDestroyed, conn));   // boost::bind得到一个boost::function对象, 引用计数+1
     LOG_TRACE << "[10] usecount=" << conn.use_count();          // 引用计数=3
+}
+
+void TcpServer::stopInLoop(EventLoop* ioLoop, CountDownLatch* latch)
+{
+    ioLoop->assertInLoopThread();
+    loopAcceptors_.find(ioLoop)->second.reset();    // 不再accept
+    ConnectionMap& connections = loopConnections_.find(ioLoop)->second;
+    for (ConnectionMap::iterator it(connections.begin());
+        it != connections.end(); ++it)
+    {
+        TcpConnectionPtr conn = it->second;
+        it->second.reset();
+        conn->connectDestroyed();
+    }
+    connections.clear();
+    latch->countDown();
 }
\ No newline at end of file
@@ -1,7 +1,9 @@
 ﻿#ifndef MUDUO_NET_TCPSERVER_H
 #define MUDUO_NET_TCPSERVER_H
 
+#include <muduo/base/Atomic.h>
 #include <muduo/base/Types.h>
+#include <muduo/net/EventLoopThreadPool.h>
 #include <muduo/net/TcpConnection.h>
 
 #include <map>
@@ -15,12 +17,14 @@
 namespace muduo
 {
 
+class CountDownLatch;
+
 namespace net
 {
 
 class Acceptor;
 class EventLoop;
-class EventLoopThreadPool;
+class IdleConnectionList;
 
 ///
 /// TCP server, supports single-threaded and thread-pool models.
@@ -30,11 +34,17 @@ class TcpServer : boost::noncopyable
 {
 public:
     typedef boost::function<void(EventLoop*)> ThreadInitCallback;
+    enum Option
+    {
+        kNoReusePort,   // 一个Acceptor在loop中accept, 新连接轮流分配给IO线程
+        kReusePort,     // 每个IO线程一个SO_REUSEPORT的Acceptor, 在本线程accept并处理连接
+    };
 
     //TcpServer(EventLoop* loop, const InetAddress& listenAddr);
     TcpServer(EventLoop* loop,
               const InetAddress& listenAddr,
-              const string& nameArg);
+              const string& nameArg,
+              Option option = kNoReusePort);
     ~TcpServer();  // force out-line dtor, for scoped_ptr members.
 
     const string& hostport() const { return hostport_; }    // 返回服务端口
@@ -51,9 +61,48 @@ public:
     /// - N means a thread pool with N threads, new connections
     ///   are assigned on a round-robin basis.
     void setThreadNum(int numThreads);
+
+    /// How new connections are assigned to I/O threads, round-robin by default.
+    /// kPeerAddressHash keeps connections from one peer IP on one loop.
+    /// kIncomingCpu hands a connection to the loop pinned to the cpu that
+    /// received its packets, see setThreadCpus.
+    /// Ignored with kReusePort, where each loop accepts for itself, except
+    /// kIncomingCpu which sets SO_INCOMING_CPU on each listening socket.
+    void setThreadSelectPolicy(EventLoopThreadPool::SelectPolicy policy);
+    /// Pins I/O thread i to cpus[i % cpus.size()].
+    /// Must be called before @c start
+    void setThreadCpus(const std::vector<int>& cpus)
+    { threadPool_->setThreadCpus(cpus); }
+    /// Binds I/O thread i to NUMA node nodes[i % nodes.size()].
+    /// Must be called before @c start
+    void setThreadNumaNodes(const std::vector<int>& nodes)
+    { threadPool_->setThreadNumaNodes(nodes); }
     void setThreadInitCallback(const ThreadInitCallback& cb)
     { threadInitCallback_ = cb; }
 
+    /// Closes connections without any read or write for @c seconds,
+    /// checked by one timer per loop, at most 1 second late.
+    /// 0 disables, which is the default.
+    /// Must be called before @c start
+    void setIdleTimeout(double seconds)
+    { idleSeconds_ = seconds; }
+
+    /// Registers connections edge-triggered (epoll only), each wakeup reads
+    /// and writes until EAGAIN but at most @c ioBudget bytes per direction,
+    /// leftovers continue after the other ready channels are handled.
+    /// Must be called before @c start
+    void setEdgeTriggered(bool on, size_t ioBudget = 256 * 1024)
+    { ioBudget_ = on ? ioBudget : 0; }
+
+    /// Accepts at most @c burst connections per readable event of
+    /// the listening socket, 32 by default.
+    /// Must be called before @c start
+    void setAcceptBurst(int burst);
+
+    /// Connections accepted in the last whole second, summed over acceptors.
+    /// Not thread safe, but in loop
+    int64_t acceptRate() const;
+
     /// Starts the server if it's not listenning.
     ///
     /// It's harmless to call it multiple times.
@@ -80,27 +129,44 @@ public:
 private:
     /// Not thread safe, but in loop
     void newConnection(int sockfd, const InetAddress& peerAddr);    // 连接到来时的回调函数
+    /// Not thread safe, but in ioLoop, kReusePort only
+    void newLocalConnection(EventLoop* ioLoop, int sockfd, const InetAddress& peerAddr);
+    TcpConnectionPtr createConnection(EventLoop* ioLoop, int sockfd, const InetAddress& peerAddr);
     /// Thread safe.
     void removeConnection(const TcpConnectionPtr& conn);
     /// Not thread safe, but in loop
     void removeConnectionInLoop(const TcpConnectionPtr& conn);
+    /// Not thread safe, but in ioLoop, kReusePort only
+    void stopInLoop(EventLoop* ioLoop, CountDownLatch* latch);
 
     /* key: 连接名称, value: 连接对象的指针,  */
     typedef std::map<string, TcpConnectionPtr> ConnectionMap;       // typedef boost::shared_ptr<TcpConnection> TcpConnectionPtr;
+    typedef std::map<EventLoop*, boost::shared_ptr<IdleConnectionList> > IdleListMap;
+    typedef std::map<EventLoop*, boost::shared_ptr<Acceptor> > AcceptorMap;
+    typedef std::map<EventLoop*, ConnectionMap> LoopConnectionMap;
 
     EventLoop *loop_;           // the acceptor loop, acceptor_所属的EventLoop, 不一定是连接所属的EventLoop
+    const InetAddress listenAddr_;
+    const bool reusePort_;      // kReusePort模式
     const string hostport_;     // 服务端口
     const string name_;         // 服务名
-    boost::scoped_ptr<Acceptor> acceptor_;              // avoid revealing Acceptor
+    boost::scoped_ptr<Acceptor> acceptor_;              // avoid revealing Acceptor, kReusePort模式下为空
     boost::scoped_ptr<EventLoopThreadPool> threadPool_;
     ConnectionCallback      connectionCallback_;        // 连接到来回调函数
     MessageCallback         messageCallback_;           // 消息到来回调函数
     WriteCompleteCallback   writeCompleteCallback_;     // 数据发送完毕，会回调此函数
     ThreadInitCallback      threadInitCallback_;        // IO线程池中的线程在进入事件循环前，会回调用此函数
     bool started_;
+    size_t ioBudget_;           // 边沿触发时每次事件的读写预算, 0表示水平触发
+    int acceptBurst_;           // 每次可读事件最多accept的连接数, 0表示使用Acceptor的默认值
+    AtomicInt32 nextConnId_;    // 下一个连接ID, kReusePort模式下多个IO线程同时分配
     // always in loop thread
-    int nextConnId_;            // 下一个连接ID
     ConnectionMap connections_;	// 连接列表
+    // kReusePort模式, start()之后外层map不再改变, 内层只在对应的IO线程中访问
+    AcceptorMap loopAcceptors_;
+    LoopConnectionMap loopConnections_;
+    double idleSeconds_;        // 空闲超时, 0表示不检测
+    IdleListMap idleLists_;     // 每个IO线程一个空闲连接链表
 };
 
 
@@ -2,6 +2,7 @@
 #define MUDUO_NET_TIMER_H
 
 #include <boost/noncopyable.hpp>
+#include <boost/intrusive/list_hook.hpp>
 
 #include <muduo/base/Atomic.h>
 #include <muduo/base/Timestamp.h>
@@ -21,7 +22,8 @@ public:
         expiration_(when),
         interval_(interval),
         repeat_(interval > 0.0),
-        sequence_(s_numCreated_.incrementAndGet())  // 先加后获取, 第一个定时器对象为1, 原子操作, 保证sequence_值唯一
+        sequence_(s_numCreated_.incrementAndGet()),  // 先加后获取, 第一个定时器对象为1, 原子操作, 保证sequence_值唯一
+        wheelTick_(0)
     { }
 
     void run() const                // 调用回调函数callback_
@@ -46,6 +48,13 @@ private:
     const int64_t   sequence_;      // 定时器序号
 
     static AtomicInt64 s_numCreated_;   // 定时器计数，当前已经创建的定时器数量
+
+    // 以下成员只由TimerWheel使用
+    friend class TimerWheel;
+    typedef boost::intrusive::list_member_hook<
+        boost::intrusive::link_mode<boost::intrusive::auto_unlink> > WheelHook;
+    WheelHook   wheelHook_;         // 时间轮槽位链表的节点, 析构时自动从链表中摘除
+    int64_t     wheelTick_;         // 到期的tick
 };
 
 }       // namespace net
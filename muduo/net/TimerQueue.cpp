@@ -3,8 +3,10 @@
 
 #include <muduo/base/Logging.h>
 #include <muduo/net/EventLoop.h>
+#include <muduo/net/LoopStats.h>
 #include <muduo/net/Timer.h>
 #include <muduo/net/TimerId.h>
+#include <muduo/net/TimerWheel.h>
 
 #include <boost/bind.hpp>
 
@@ -47,30 +49,21 @@ void readTimerfd(int timerfd, Timestamp now)
     }
 }
 
-// 计算超时时刻与当前时间的时间差
-struct timespec howMuchTimeFromNow(Timestamp when)
-{
-    int64_t microseconds = when.microSecondsSinceEpoch() - Timestamp::now().microSecondsSinceEpoch();
-    if (microseconds < 100)
-    {
-        microseconds = 100;
-    }
-    struct timespec ts;
-    ts.tv_sec = static_cast<time_t>(microseconds / Timestamp::kMicroSecondsPerSecond);
-    ts.tv_nsec = static_cast<long>((microseconds % Timestamp::kMicroSecondsPerSecond) * 1000);
-    return ts;
-}
-
 // 重置定时器的最近一次超时时间
+// 到期时间就是CLOCK_MONOTONIC上的绝对时间, 不必再读一次当前时间换算成相对值; 已过期的立即触发
 void resetTimerfd(int timerfd, Timestamp expiration)
 {
     // wake up loop by timerfd_settime()
     struct itimerspec newValue;
-    struct itimerspec oldValue;
     bzero(&newValue, sizeof newValue);
-    bzero(&oldValue, sizeof oldValue);
-    newValue.it_value = howMuchTimeFromNow(expiration);
-    int ret = ::timerfd_settime(timerfd, 0, &newValue, &oldValue);
+    int64_t microseconds = expiration.microSecondsSinceEpoch();
+    newValue.it_value.tv_sec = static_cast<time_t>(microseconds / Timestamp::kMicroSecondsPerSecond);
+    newValue.it_value.tv_nsec = static_cast<long>((microseconds % Timestamp::kMicroSecondsPerSecond) * 1000);
+    if (newValue.it_value.tv_sec == 0 && newValue.it_value.tv_nsec == 0)
+    {
+        newValue.it_value.tv_nsec = 1;      // 全零会解除定时器
+    }
+    int ret = ::timerfd_settime(timerfd, TFD_TIMER_ABSTIME, &newValue, NULL);
     if (ret)
     {
         LOG_SYSERR << "timerfd_settime()";
@@ -109,6 +102,11 @@ TimerQueue::~TimerQueue()
     {
         delete it->second;
     }
+    for (WheelTimerMap::iterator it = wheelTimers_.begin();
+         it != wheelTimers_.end(); ++it)
+    {
+        delete it->second;
+    }
 }
 
 TimerId TimerQueue::addTimer(const TimerCallback& cb,
@@ -132,6 +130,28 @@ void TimerQueue::cancel(TimerId timerId)
     //cancelInLoop(timerId);
 }
 
+void TimerQueue::useTimerWheel(double tickSeconds)
+{
+    loop_->assertInLoopThread();
+    if (wheel_)
+    {
+        return;
+    }
+    wheel_.reset(new TimerWheel(Timestamp::monotonicNow(), tickSeconds));
+    // 已有的定时器移到时间轮中
+    TimerList timers;
+    timers.swap(timers_);
+    activeTimers_.clear();
+    for (TimerList::iterator it = timers.begin(); it != timers.end(); ++it)
+    {
+        insert(it->second);
+    }
+    if (wheel_->nextExpiration().valid())
+    {
+        arm(wheel_->nextExpiration());
+    }
+}
+
 void TimerQueue::addTimerInLoop(Timer* timer)
 {
     loop_->assertInLoopThread();
@@ -140,14 +160,30 @@ void TimerQueue::addTimerInLoop(Timer* timer)
 
     if (earliestChanged)
     {
-        // 重置定时器的超时时刻(timerfd_settime)
-        resetTimerfd(timerfd_, timer->expiration());
+        // 重置定时器的超时时刻(timerfd_settime), 时间轮按tick到期
+        arm(wheel_ ? wheel_->nextExpiration() : timer->expiration());
     }
 }
 
 void TimerQueue::cancelInLoop(TimerId timerId)
 {
     loop_->assertInLoopThread();
+    if (wheel_)
+    {
+        // 时间轮模式: 按sequence查找, O(1)
+        WheelTimerMap::iterator it = wheelTimers_.find(timerId.sequence_);
+        if (it != wheelTimers_.end() && it->second == timerId.timer_)
+        {
+            wheel_->remove(it->second);
+            delete it->second;
+            wheelTimers_.erase(it);
+        }
+        else if (callingExpiredTimers_)
+        {
+            cancelingTimers_.insert(ActiveTimer(timerId.timer_, timerId.sequence_));
+        }
+        return;
+    }
     assert(timers_.size() == activeTimers_.size());
     ActiveTimer timer(timerId.timer_, timerId.sequence_);
     // 查找该定时器
@@ -170,7 +206,13 @@ void TimerQueue::cancelInLoop(TimerId timerId)
 void TimerQueue::handleRead()
 {
     loop_->assertInLoopThread();
-    Timestamp now(Timestamp::now());
+    // 用本轮poll返回时读到的单调时间, 不再读时钟
+    Timestamp now(loop_->pollReturnMonotonicTime());
+    if (now < armedExpiration_)
+    {
+        // timerfd触发说明已到armedExpiration_, 粗粒度时钟可能还没走到, 此时读一次精确时钟
+        now = Timestamp::monotonicNow();
+    }
     readTimerfd(timerfd_, now);             // 清除该事件，避免一直触发, 实际就是调用read
 
     // 获取该时刻之前所有的定时器列表(即超时定时器列表)
@@ -182,6 +224,8 @@ void TimerQueue::handleRead()
     for (std::vector<Entry>::iterator it = expired.begin();
         it != expired.end(); ++it)
     {
+        // 迟到时间按本轮poll返回时刻计, 不含同一批中前面定时器回调的耗时
+        loop_->stats()->recordTimer(now.microSecondsSinceEpoch() - it->first.microSecondsSinceEpoch());
         // 这里回调定时器处理函数
         it->second->run();
     }
@@ -194,8 +238,21 @@ void TimerQueue::handleRead()
 // rvo优化, 不会返回对象时不会再拷贝构造std::vector<Entry>
 std::vector<TimerQueue::Entry> TimerQueue::getExpired(Timestamp now)
 {
-    assert(timers_.size() == activeTimers_.size());
     std::vector<Entry> expired;
+    if (wheel_)
+    {
+        // 时间轮模式: 一次取出所有到期槽位
+        std::vector<Timer*> timers;
+        wheel_->advance(now, &timers);
+        for (std::vector<Timer*>::iterator it = timers.begin(); it != timers.end(); ++it)
+        {
+            size_t n = wheelTimers_.erase((*it)->sequence());
+            assert(n == 1); (void)n;
+            expired.push_back(Entry((*it)->expiration(), *it));
+        }
+        return expired;
+    }
+    assert(timers_.size() == activeTimers_.size());
     Entry sentry(now, reinterpret_cast<Timer*>(UINTPTR_MAX));
     // 返回第一个未到期的Timer的迭代器
     // lower_bound的含义是返回第一个值>=sentry的元素的iterator
@@ -242,7 +299,11 @@ void TimerQueue::reset(const std::vector<Entry>& expired, Timestamp now)
         }
     }
 
-    if (!timers_.empty())
+    if (wheel_)
+    {
+        nextExpire = wheel_->nextExpiration();
+    }
+    else if (!timers_.empty())
     {
         // 获取最早到期的定时器超时时间
         nextExpire = timers_.begin()->second->expiration();
@@ -251,13 +312,24 @@ void TimerQueue::reset(const std::vector<Entry>& expired, Timestamp now)
     if (nextExpire.valid())
     {
         // 重置定时器的超时时刻(timerfd_settime)
-        resetTimerfd(timerfd_, nextExpire);
+        arm(nextExpire);
     }
 }
 
+void TimerQueue::arm(Timestamp expiration)
+{
+    armedExpiration_ = expiration;
+    resetTimerfd(timerfd_, expiration);
+}
+
 bool TimerQueue::insert(Timer* timer)
 {
     loop_->assertInLoopThread();
+    if (wheel_)
+    {
+        wheelTimers_.insert(std::make_pair(timer->sequence(), timer));
+        return wheel_->insert(timer);
+    }
     assert(timers_.size() == activeTimers_.size());
     // 最早到期时间是否改变
     bool earliestChanged = false;
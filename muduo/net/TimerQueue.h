@@ -5,6 +5,8 @@
 #include <vector>
 
 #include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/unordered_map.hpp>
 
 #include <muduo/base/Mutex.h>
 #include <muduo/base/Timestamp.h>
@@ -25,6 +27,7 @@ namespace net
 class EventLoop;
 class Timer;
 class TimerId;
+class TimerWheel;
 
 class TimerQueue : boost::noncopyable
 {
@@ -35,6 +38,7 @@ public:
     ///
     /// Schedules the callback to be run at given time,
     /// repeats if @c interval > 0.0.
+    /// @c when is on the monotonic clock, see Timestamp::monotonicNow().
     ///
     /// Must be thread safe. Usually be called from other threads.
     // 一定是线程安全的，可以跨线程调用。通常情况下被其它线程调用(可以不在所属的EventLoop中调用)
@@ -44,6 +48,13 @@ public:
 
     void cancel(TimerId timerId);
 
+    ///
+    /// Switches to a hashed hierarchical timing wheel with O(1) add and cancel,
+    /// timers are rounded up to @c tickSeconds. Existing timers are moved over.
+    ///
+    /// Not thread safe, must be called in the loop thread.
+    void useTimerWheel(double tickSeconds);
+
 private:
     // FIXME: use unique_ptr<Timer> instead of raw pointers.
     // unique_ptr是C++ 11标准的一个独享所有权的智能指针
@@ -68,6 +79,7 @@ private:
     void reset(const std::vector<Entry>& expired, Timestamp now);   // 超时定时器重置, 超时定时器中可能有可重复定时器, 这时需重置
 
     bool insert(Timer* timer);          // 插入定时器, 返回值用于判断是否调整定时器列表
+    void arm(Timestamp expiration);     // timerfd_settime, 并记下armedExpiration_
 
     EventLoop* loop_;                   // 所属EventLoop
     const int timerfd_;                 // timerfd_create所创建的文件描述符
@@ -80,7 +92,13 @@ private:
     // timers_是按到期时间排序，activeTimers_是按对象地址排序
     ActiveTimerSet activeTimers_;
     bool callingExpiredTimers_;         /* atomic, 是否处于处理超时定时器当中 */
+    Timestamp armedExpiration_;         // timerfd当前设置的到期时间(单调时钟)
     ActiveTimerSet cancelingTimers_;    // 保存的是被取消的定时器
+
+    // 时间轮模式, wheel_不为空时timers_与activeTimers_不再使用
+    typedef boost::unordered_map<int64_t, Timer*> WheelTimerMap;
+    boost::scoped_ptr<TimerWheel> wheel_;
+    WheelTimerMap wheelTimers_;         // sequence -> Timer*, 用于cancel时判断定时器是否还存在
 };
 
 }       // namespace net
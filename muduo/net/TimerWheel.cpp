@@ -0,0 +1,202 @@
+﻿#define __STDC_LIMIT_MACROS
+#include <muduo/net/TimerWheel.h>
+
+#include <algorithm>
+
+#include <assert.h>
+#include <stdint.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const int TimerWheel::kNearBits;
+const int TimerWheel::kNearSlots;
+const int TimerWheel::kFarBits;
+const int TimerWheel::kFarSlots;
+const int TimerWheel::kFarLevels;
+
+namespace
+{
+
+const int64_t kNoTick = INT64_MAX;
+
+}   // namespace
+
+TimerWheel::TimerWheel(Timestamp start, double tickSeconds)
+    : startMicroSeconds_(start.microSecondsSinceEpoch()),
+    tickMicroSeconds_(std::max(static_cast<int64_t>(tickSeconds * Timestamp::kMicroSecondsPerSecond),
+                               static_cast<int64_t>(1))),
+    currentTick_(0),
+    nextTick_(kNoTick),
+    size_(0)
+{
+}
+
+TimerWheel::~TimerWheel()
+{
+    // 定时器由TimerQueue删除, 这里只摘除链表节点
+    for (int i = 0; i < kNearSlots; ++i)
+    {
+        near_[i].clear();
+    }
+    for (int level = 0; level < kFarLevels; ++level)
+    {
+        for (int i = 0; i < kFarSlots; ++i)
+        {
+            far_[level][i].clear();
+        }
+    }
+}
+
+int64_t TimerWheel::ceilTick(Timestamp when) const
+{
+    int64_t delta = when.microSecondsSinceEpoch() - startMicroSeconds_;
+    return delta <= 0 ? 0 : (delta + tickMicroSeconds_ - 1) / tickMicroSeconds_;
+}
+
+int64_t TimerWheel::floorTick(Timestamp when) const
+{
+    int64_t delta = when.microSecondsSinceEpoch() - startMicroSeconds_;
+    return delta <= 0 ? 0 : delta / tickMicroSeconds_;
+}
+
+bool TimerWheel::insert(Timer* timer)
+{
+    assert(!timer->wheelHook_.is_linked());
+    timer->wheelTick_ = ceilTick(timer->expiration());
+    place(timer, currentTick_ + 1);     // currentTick_已经处理过, 最早放到下一个tick
+    ++size_;
+    int64_t tick = std::max(timer->wheelTick_, currentTick_ + 1);
+    if (tick < nextTick_)
+    {
+        nextTick_ = tick;
+        return true;
+    }
+    return false;
+}
+
+void TimerWheel::remove(Timer* timer)
+{
+    assert(timer->wheelHook_.is_linked());
+    timer->wheelHook_.unlink();
+    --size_;
+}
+
+void TimerWheel::place(Timer* timer, int64_t minTick)
+{
+    int64_t tick = std::max(timer->wheelTick_, minTick);
+    int64_t delta = tick - currentTick_;
+    assert(delta >= 0);
+    if (delta < kNearSlots)
+    {
+        near_[tick & (kNearSlots - 1)].push_back(*timer);
+        return;
+    }
+    for (int level = 0; level < kFarLevels; ++level)
+    {
+        int shift = kNearBits + level * kFarBits;
+        if (delta < (static_cast<int64_t>(1) << (shift + kFarBits)) || level == kFarLevels - 1)
+        {
+            if (level == kFarLevels - 1 && delta >= (static_cast<int64_t>(1) << (shift + kFarBits)))
+            {
+                // 超出时间轮范围, 暂放在最高层最远的槽位, 级联时再按真实的到期tick放置
+                tick = currentTick_ + (static_cast<int64_t>(1) << (shift + kFarBits)) - 1;
+            }
+            far_[level][(tick >> shift) & (kFarSlots - 1)].push_back(*timer);
+            return;
+        }
+    }
+}
+
+void TimerWheel::cascade(int level)
+{
+    int shift = kNearBits + level * kFarBits;
+    Slot& slot = far_[level][(currentTick_ >> shift) & (kFarSlots - 1)];
+    Slot timers;
+    timers.splice(timers.end(), slot);
+    while (!timers.empty())
+    {
+        Timer& timer = timers.front();
+        timers.pop_front();
+        place(&timer, currentTick_);    // 在处理currentTick_之前级联, 到期的放入当前槽位
+    }
+}
+
+void TimerWheel::advance(Timestamp now, std::vector<Timer*>* expired)
+{
+    int64_t nowTick = floorTick(now);
+    while (currentTick_ < nowTick)
+    {
+        // 跳过没有定时器的tick, 每次只处理需要处理的tick
+        int64_t next = computeNextTick();
+        if (next > nowTick)
+        {
+            currentTick_ = nowTick;
+            break;
+        }
+        currentTick_ = next;
+        if ((currentTick_ & (kNearSlots - 1)) == 0)
+        {
+            // 从高层到低层依次级联, 高层落下的定时器可能紧接着被下一层级联
+            for (int level = kFarLevels - 1; level >= 0; --level)
+            {
+                int shift = kNearBits + level * kFarBits;
+                if ((currentTick_ & ((static_cast<int64_t>(1) << shift) - 1)) == 0)
+                {
+                    cascade(level);
+                }
+            }
+        }
+        Slot& slot = near_[currentTick_ & (kNearSlots - 1)];
+        while (!slot.empty())
+        {
+            Timer& timer = slot.front();
+            slot.pop_front();
+            assert(timer.wheelTick_ <= currentTick_);
+            --size_;
+            expired->push_back(&timer);
+        }
+    }
+    nextTick_ = computeNextTick();
+}
+
+int64_t TimerWheel::computeNextTick() const
+{
+    if (size_ == 0)
+    {
+        return kNoTick;
+    }
+    int64_t next = kNoTick;
+    for (int k = 1; k <= kNearSlots; ++k)
+    {
+        if (!near_[(currentTick_ + k) & (kNearSlots - 1)].empty())
+        {
+            next = currentTick_ + k;
+            break;
+        }
+    }
+    // 上层槽位的定时器在级联时才能确定, 级联的tick也需要处理
+    for (int level = 0; level < kFarLevels; ++level)
+    {
+        int shift = kNearBits + level * kFarBits;
+        int64_t base = currentTick_ >> shift;
+        for (int k = 1; k <= kFarSlots; ++k)
+        {
+            if (!far_[level][(base + k) & (kFarSlots - 1)].empty())
+            {
+                next = std::min(next, (base + k) << shift);
+                break;
+            }
+        }
+    }
+    return next;
+}
+
+Timestamp TimerWheel::nextExpiration() const
+{
+    if (size_ == 0 || nextTick_ == kNoTick)
+    {
+        return Timestamp::invalid();
+    }
+    return Timestamp(startMicroSeconds_ + nextTick_ * tickMicroSeconds_);
+}
\ No newline at end of file
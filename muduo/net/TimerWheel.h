@@ -0,0 +1,79 @@
+﻿#ifndef MUDUO_NET_TIMERWHEEL_H
+#define MUDUO_NET_TIMERWHEEL_H
+
+#include <vector>
+
+#include <boost/intrusive/list.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <muduo/base/Timestamp.h>
+#include <muduo/net/Timer.h>
+
+namespace muduo
+{
+
+namespace net
+{
+
+///
+/// Hashed hierarchical timing wheel, used by TimerQueue in timer wheel mode.
+///
+/// 4 levels: 256 slots of one tick, then 3 levels of 64 slots each,
+/// covering 2^26 ticks (about 18.6 hours with 1ms ticks). Later timers
+/// are parked in the last level and re-placed when cascaded.
+/// Insert and remove are O(1), expiry moves a whole slot at once.
+/// Never fires a timer before its expiration.
+///
+/// Not thread safe, owned by TimerQueue in the loop thread.
+/// Does not own the timers.
+class TimerWheel : boost::noncopyable
+{
+public:
+    TimerWheel(Timestamp start, double tickSeconds);
+    ~TimerWheel();
+
+    /// Returns true if the earliest tick to process changed.
+    bool insert(Timer* timer);
+    void remove(Timer* timer);
+
+    /// Moves out all timers expired by @c now.
+    void advance(Timestamp now, std::vector<Timer*>* expired);
+
+    /// Time of the next tick that needs processing, invalid if empty.
+    /// May be earlier than necessary after remove().
+    Timestamp nextExpiration() const;
+
+    size_t size() const { return size_; }
+
+private:
+    typedef boost::intrusive::member_hook<Timer, Timer::WheelHook, &Timer::wheelHook_> HookOption;
+    typedef boost::intrusive::list<Timer, HookOption,
+                                   boost::intrusive::constant_time_size<false> > Slot;
+
+    static const int kNearBits = 8;
+    static const int kNearSlots = 1 << kNearBits;
+    static const int kFarBits = 6;
+    static const int kFarSlots = 1 << kFarBits;
+    static const int kFarLevels = 3;
+
+    int64_t ceilTick(Timestamp when) const;
+    int64_t floorTick(Timestamp when) const;
+
+    void place(Timer* timer, int64_t minTick);  // 根据到期tick放入对应层的槽位
+    void cascade(int level);                    // 把上层当前槽位的定时器重新放置到下层
+    int64_t computeNextTick() const;
+
+    const int64_t startMicroSeconds_;
+    const int64_t tickMicroSeconds_;
+    int64_t currentTick_;                       // 已处理到的tick
+    int64_t nextTick_;                          // 下一个需要处理的tick
+    size_t  size_;
+    Slot    near_[kNearSlots];                  // 第0层, 每个槽位一个tick
+    Slot    far_[kFarLevels][kFarSlots];        // 第1~3层
+};
+
+}       // namespace net
+
+}       // namespace muduo
+
+#endif  // MUDUO_NET_TIMERWHEEL_H
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <muduo/net/EventLoop.h>
 #include <muduo/net/http/HttpRequest.h>
 #include <muduo/net/http/HttpResponse.h>
+#include <muduo/net/inspect/LoopInspector.h>
 #include <muduo/net/inspect/ProcessInspector.h>
 
 //#include <iostream>
@@ -50,13 +51,15 @@ Inspector::Inspector(EventLoop* loop,
                      const InetAddress& httpAddr,
                      const string& name)
     : server_(loop, httpAddr, "Inspector:" + name),
-    processInspector_(new ProcessInspector)
+    processInspector_(new ProcessInspector),
+    loopInspector_(new LoopInspector)
 {
     assert(CurrentThread::isMainThread());	    // 断言在主线程中构造
     assert(g_globalInspector == 0);
     g_globalInspector = this;
     server_.setHttpCallback(boost::bind(&Inspector::onRequest, this, _1, _2));
     processInspector_->registerCommands(this);  // 注册命令
+    loopInspector_->registerCommands(this);
     // 这样子做法是为了防止竞态问题
     // 如果直接调用start，（当前线程不是loop所属的IO线程，是主线程）那么有可能，当前构造函数还没返回，
     // HttpServer所在的IO线程可能已经收到了http客户端的请求了（因为这时候HttpServer已启动），那么就会回调
@@ -17,6 +17,7 @@ namespace net
 {
 
 class ProcessInspector;
+class LoopInspector;
 
 // A internal inspector of the running process, usually a singleton.
 class Inspector : boost::noncopyable
@@ -46,6 +47,7 @@ private:
 
     HttpServer  server_;
     boost::scoped_ptr<ProcessInspector> processInspector_;
+    boost::scoped_ptr<LoopInspector> loopInspector_;
     MutexLock   mutex_;
     std::map<string, CommandList>   commands_;
     std::map<string, HelpList>      helps_;
@@ -0,0 +1,91 @@
+﻿#include <muduo/net/inspect/LoopInspector.h>
+#include <muduo/net/BufferPool.h>
+#include <muduo/net/LoopStats.h>
+#include <stdio.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+void LoopInspector::registerCommands(Inspector* ins)
+{
+    ins->add("loop", "buffer_pool", LoopInspector::bufferPool, "print Buffer pool hit rate of each loop");
+    ins->add("loop", "stats", LoopInspector::stats, "print counters and latency percentiles of each loop");
+}
+
+namespace
+{
+
+// 一行延迟分布, 单位us, 百分位是桶的上界
+void appendHistogram(string* result, const char* name, const LatencyHistogram::Snapshot& h)
+{
+    char buf[256];
+    snprintf(buf, sizeof buf, "  %-14s count %lld mean %.1f p50 %lld p90 %lld p99 %lld p999 %lld max %lld\n",
+             name,
+             static_cast<long long>(h.count),
+             h.mean(),
+             static_cast<long long>(h.percentile(50)),
+             static_cast<long long>(h.percentile(90)),
+             static_cast<long long>(h.percentile(99)),
+             static_cast<long long>(h.percentile(99.9)),
+             static_cast<long long>(h.max));
+    *result += buf;
+}
+
+}   // namespace
+
+string LoopInspector::bufferPool(HttpRequest::Method, const Inspector::ArgList&)
+{
+    std::vector<BufferPool::Stats> stats = BufferPool::stats();
+    string result;
+    for (size_t i = 0; i < stats.size(); ++i)
+    {
+        const BufferPool::Stats& s = stats[i];
+        double hitRate = s.allocations > 0 ? 100.0 * static_cast<double>(s.hits) / static_cast<double>(s.allocations) : 0.0;
+        char buf[256];
+        snprintf(buf, sizeof buf, "tid %d allocations %lld hits %lld (%.1f%%) frees %lld recycled %lld cached_bytes %lld\n",
+                 s.tid,
+                 static_cast<long long>(s.allocations),
+                 static_cast<long long>(s.hits),
+                 hitRate,
+                 static_cast<long long>(s.frees),
+                 static_cast<long long>(s.recycled),
+                 static_cast<long long>(s.cachedBytes));
+        result += buf;
+    }
+    return result;
+}
+
+string LoopInspector::stats(HttpRequest::Method, const Inspector::ArgList&)
+{
+    std::vector<LoopStats::Snapshot> snapshots = LoopStats::snapshots();
+    string result;
+    for (size_t i = 0; i < snapshots.size(); ++i)
+    {
+        const LoopStats::Snapshot& s = snapshots[i];
+        double busy = s.elapsedMicroSeconds > 0
+            ? 100.0 * static_cast<double>(s.busyMicroSeconds) / static_cast<double>(s.elapsedMicroSeconds) : 0.0;
+        double seconds = static_cast<double>(s.elapsedMicroSeconds) / 1e6;
+        char buf[512];
+        snprintf(buf, sizeof buf, "tid %d%s%s uptime %.1fs busy %.2f%%\n"
+                 "  iterations %lld events %lld (%.1f/s) functors %lld (%.1f/s) max_batch %lld timers %lld\n",
+                 s.tid,
+                 s.name.empty() ? "" : " ",
+                 s.name.c_str(),
+                 seconds,
+                 busy,
+                 static_cast<long long>(s.iterations),
+                 static_cast<long long>(s.events),
+                 seconds > 0 ? static_cast<double>(s.events) / seconds : 0.0,
+                 static_cast<long long>(s.functors),
+                 seconds > 0 ? static_cast<double>(s.functors) / seconds : 0.0,
+                 static_cast<long long>(s.maxFunctorBatch),
+                 static_cast<long long>(s.timers));
+        result += buf;
+        appendHistogram(&result, "poll_wait", s.pollWait);
+        appendHistogram(&result, "callback", s.callback);
+        appendHistogram(&result, "functor", s.functor);
+        appendHistogram(&result, "functor_delay", s.functorDelay);
+        appendHistogram(&result, "timer_late", s.timerLateness);
+    }
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+﻿#ifndef MUDUO_NET_INSPECT_LOOPINSPECTOR_H
+#define MUDUO_NET_INSPECT_LOOPINSPECTOR_H
+
+#include <muduo/net/inspect/Inspector.h>
+#include <boost/noncopyable.hpp>
+
+namespace muduo
+{
+
+namespace net
+{
+
+// IO线程(EventLoop)相关的统计信息
+class LoopInspector : boost::noncopyable
+{
+public:
+    void registerCommands(Inspector* ins);	// 注册命令接口
+
+private:
+    static string bufferPool(HttpRequest::Method, const Inspector::ArgList&);
+    static string stats(HttpRequest::Method, const Inspector::ArgList&);
+
+};
+
+}       // namespace net
+
+}       // namespace muduo
+
+#endif  // MUDUO_NET_INSPECT_LOOPINSPECTOR_H
\ No newline at end of file
@@ -1,6 +1,8 @@
-﻿#include <muduo/net/Poller.h>
+﻿#include <muduo/base/Logging.h>
+#include <muduo/net/Poller.h>
 #include <muduo/net/poller/PollPoller.h>
 #include <muduo/net/poller/EPollPoller.h>
+#include <muduo/net/poller/IoUringPoller.h>
 
 #include <stdlib.h>
 
@@ -8,6 +10,16 @@ using namespace muduo::net;
 
 Poller* Poller::newDefaultPoller(EventLoop* loop)
 {
+    if (::getenv("MUDUO_USE_IO_URING"))
+    {
+        IoUringPoller* poller = new IoUringPoller(loop);
+        if (poller->valid())
+        {
+            return poller;
+        }
+        delete poller;      // 内核不支持, 退回epoll
+        LOG_WARN << "io_uring unavailable, falling back to epoll";
+    }
     if (::getenv("MUDUO_USE_POLL"))
     {
         return new PollPoller(loop);
@@ -51,7 +51,7 @@ Timestamp EPollPoller::poll(int timeoutMs, ChannelList* activeChannels)
                                  &*events_.begin(),
                                  static_cast<int>(events_.size()),
                                  timeoutMs);
-    Timestamp now(Timestamp::now());
+    Timestamp now(pollReturnTime());
     if (numEvents > 0)
     {
         LOG_TRACE << numEvents << " events happended";
@@ -78,12 +78,7 @@ void EPollPoller::fillActiveChannels(int numEvents, ChannelList* activeChannels)
     for (int i = 0; i < numEvents; ++i)
     {
         Channel* channel = static_cast<Channel*>(events_[i].data.ptr);  // update中event.data.ptr = channel; 所以可以返回通道
-#ifndef NDEBUG
-        int fd = channel->fd();
-        ChannelMap::const_iterator it = channels_.find(fd);
-        assert(it != channels_.end());
-        assert(it->second == channel);
-#endif
+        assert(findChannel(channel->fd()) == channel);
         channel->set_revents(events_[i].events);
         activeChannels->push_back(channel);                 // 返回到通道中
     }
@@ -101,13 +96,11 @@ void EPollPoller::updateChannel(Channel* channel)           //
         int fd = channel->fd();
         if (index == kNew)                                  // 未添加状态
         {
-            assert(channels_.find(fd) == channels_.end());  // Channel中可以找到, 但channel_找不到
-            channels_[fd] = channel;                        // 添加到channel_ map中
+            addChannel(fd, channel);                        // 添加到以fd为下标的channels_中
         }
-        else // index == kDeleted                           // 已添加, 只是从epoll关注事件中删除的还保留在channel_ map中
+        else // index == kDeleted                           // 已添加, 只是从epoll关注事件中删除的还保留在channels_中
         {
-            assert(channels_.find(fd) != channels_.end());
-            assert(channels_[fd] == channel);
+            assert(findChannel(fd) == channel);
         }
         channel->set_index(kAdded);
         update(EPOLL_CTL_ADD, channel);
@@ -117,12 +110,11 @@ void EPollPoller::updateChannel(Channel* channel)           //
         // update existing one with EPOLL_CTL_MOD/DEL
         int fd = channel->fd();
         (void)fd;
-        assert(channels_.find(fd) != channels_.end());
-        assert(channels_[fd] == channel);
+        assert(findChannel(fd) == channel);
         assert(index == kAdded);
         if (channel->isNoneEvent())
         {
-            update(EPOLL_CTL_DEL, channel);                 // 仅仅表示从epoll关注中移除, 并没有从channel_ map中移除
+            update(EPOLL_CTL_DEL, channel);                 // 仅仅表示从epoll关注中移除, 并没有从channels_中移除
             channel->set_index(kDeleted);
         }
         else
@@ -137,14 +129,11 @@ void EPollPoller::removeChannel(Channel* channel)
     Poller::assertInLoopThread();
     int fd = channel->fd();
     LOG_TRACE << "fd = " << fd;
-    assert(channels_.find(fd) != channels_.end());
-    assert(channels_[fd] == channel);
+    assert(findChannel(fd) == channel);
     assert(channel->isNoneEvent());                         // Channel没有事件 
     int index = channel->index();
     assert(index == kAdded || index == kDeleted);           // 断言等于kAdded或kDeleted, 而不能等于kNew(不在通道中)
-    size_t n = channels_.erase(fd);                         // kAdded或kDeleted都要从channel_ map中移除
-    (void)n;
-    assert(n == 1);
+    eraseChannel(fd);                                       // kAdded或kDeleted都要从channels_中移除
 
     if (index == kAdded)                                    // kAdded表示在epoll关注中, kDeleted已经从epoll关注中移除了
     {
@@ -158,6 +147,10 @@ void EPollPoller::update(int operation, Channel* channel)
     struct epoll_event event;
     bzero(&event, sizeof event);
     event.events = channel->events();
+    if (channel->isEdgeTriggered())
+    {
+        event.events |= EPOLLOUT | EPOLLET;     // 写事件的开关由Channel自己过滤, 避免每次enableWriting/disableWriting调用epoll_ctl
+    }
     event.data.ptr = channel;
     int fd = channel->fd();
     if (::epoll_ctl(epollfd_, operation, fd, &event) < 0)
@@ -0,0 +1,586 @@
+﻿#include <muduo/net/poller/IoUringPoller.h>
+
+#include <muduo/base/Logging.h>
+#include <muduo/net/Channel.h>
+
+#include <algorithm>
+
+#include <assert.h>
+#include <errno.h>
+#include <poll.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+    const int kNew      = -1;
+    const int kAdded    = 1;
+    const int kDeleted  = 2;
+
+    const uint64_t kCancelUserData = ~static_cast<uint64_t>(0);    // 取消请求本身的完成事件, 直接忽略
+
+    enum Op
+    {
+        kPollOp,
+        kRecvOp,
+        kAcceptOp
+    };
+
+    const uint32_t kGenerationMask = (1u << 30) - 1;
+    const uint16_t kBufferGroup = 0;
+
+    // 高32位是fd, 接着2位是操作, 低30位是注册的代数
+    uint64_t makeUserData(int fd, Op op, uint32_t generation)
+    {
+        return (static_cast<uint64_t>(fd) << 32) | (static_cast<uint64_t>(op) << 30)
+               | (generation & kGenerationMask);
+    }
+
+    Op ioOp(const Channel* channel)
+    {
+        return channel->completion() == Channel::kCompleteAccept ? kAcceptOp : kRecvOp;
+    }
+
+    // glibc没有io_uring的封装, 直接使用系统调用
+    int ioUringSetup(unsigned entries, struct io_uring_params* params)
+    {
+        return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+    }
+
+    int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags,
+                     void* arg, size_t argSize)
+    {
+        return static_cast<int>(::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete,
+                                          flags, arg, argSize));
+    }
+
+    int ioUringRegister(int fd, unsigned opcode, void* arg, unsigned nrArgs)
+    {
+        return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, nrArgs));
+    }
+
+    template<typename T>
+    T* ringPointer(void* ring, unsigned offset)
+    {
+        return reinterpret_cast<T*>(static_cast<char*>(ring) + offset);
+    }
+}
+
+IoUringPoller::IoUringPoller(EventLoop* loop)
+    : Poller(loop),
+    ringFd_(-1),
+    sqRing_(MAP_FAILED),
+    sqRingSize_(0),
+    cqRing_(MAP_FAILED),
+    cqRingSize_(0),
+    sqes_(NULL),
+    sqesSize_(0),
+    sqHead_(NULL),
+    sqTail_(NULL),
+    sqArray_(NULL),
+    sqMask_(0),
+    sqEntries_(0),
+    cqHead_(NULL),
+    cqTail_(NULL),
+    cqMask_(0),
+    cqes_(NULL),
+    bufferMem_(MAP_FAILED),
+    bufferMemSize_(0),
+    bufferRing_(NULL),
+    buffers_(NULL),
+    bufferTail_(0),
+    round_(0)
+{
+    if (!setupRing())
+    {
+        closeRing();
+    }
+    else
+    {
+        setupBufferRing();      // 失败时只用POLL_ADD, 通道不会进入完成模式
+    }
+}
+
+IoUringPoller::~IoUringPoller()
+{
+    closeRing();
+}
+
+bool IoUringPoller::setupRing()
+{
+    struct io_uring_params params;
+    bzero(&params, sizeof params);
+    ringFd_ = ioUringSetup(kRingEntries, &params);
+    if (ringFd_ < 0)
+    {
+        LOG_SYSERR << "IoUringPoller::setupRing - io_uring_setup";
+        return false;
+    }
+    if (!(params.features & IORING_FEAT_EXT_ARG))   // 等待超时需要IORING_ENTER_EXT_ARG
+    {
+        LOG_ERROR << "IoUringPoller::setupRing - kernel lacks IORING_FEAT_EXT_ARG";
+        return false;
+    }
+
+    sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap)
+    {
+        sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+    }
+    sqRing_ = ::mmap(NULL, sqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     ringFd_, IORING_OFF_SQ_RING);
+    if (sqRing_ == MAP_FAILED)
+    {
+        LOG_SYSERR << "IoUringPoller::setupRing - mmap sq ring";
+        return false;
+    }
+    if (singleMmap)
+    {
+        cqRing_ = sqRing_;
+    }
+    else
+    {
+        cqRing_ = ::mmap(NULL, cqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         ringFd_, IORING_OFF_CQ_RING);
+        if (cqRing_ == MAP_FAILED)
+        {
+            LOG_SYSERR << "IoUringPoller::setupRing - mmap cq ring";
+            return false;
+        }
+    }
+    sqesSize_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    void* sqes = ::mmap(NULL, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ringFd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+    {
+        LOG_SYSERR << "IoUringPoller::setupRing - mmap sqes";
+        return false;
+    }
+    sqes_ = static_cast<struct io_uring_sqe*>(sqes);
+
+    sqHead_ = ringPointer<unsigned>(sqRing_, params.sq_off.head);
+    sqTail_ = ringPointer<unsigned>(sqRing_, params.sq_off.tail);
+    sqArray_ = ringPointer<unsigned>(sqRing_, params.sq_off.array);
+    sqMask_ = *ringPointer<unsigned>(sqRing_, params.sq_off.ring_mask);
+    sqEntries_ = params.sq_entries;
+    cqHead_ = ringPointer<unsigned>(cqRing_, params.cq_off.head);
+    cqTail_ = ringPointer<unsigned>(cqRing_, params.cq_off.tail);
+    cqMask_ = *ringPointer<unsigned>(cqRing_, params.cq_off.ring_mask);
+    cqes_ = ringPointer<struct io_uring_cqe>(cqRing_, params.cq_off.cqes);
+    LOG_INFO << "IoUringPoller sq_entries=" << params.sq_entries
+             << " cq_entries=" << params.cq_entries;
+    return true;
+}
+
+// buffer ring占一页, 后面紧跟各个缓冲区; IORING_REGISTER_PBUF_RING需要5.19
+bool IoUringPoller::setupBufferRing()
+{
+    size_t ringSize = kBufferCount * sizeof(struct io_uring_buf);
+    bufferMemSize_ = ringSize + kBufferCount * kBufferSize;
+    bufferMem_ = ::mmap(NULL, bufferMemSize_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (bufferMem_ == MAP_FAILED)
+    {
+        LOG_SYSERR << "IoUringPoller::setupBufferRing - mmap";
+        return false;
+    }
+    struct io_uring_buf_reg reg;
+    bzero(&reg, sizeof reg);
+    reg.ring_addr = reinterpret_cast<uint64_t>(bufferMem_);
+    reg.ring_entries = kBufferCount;
+    reg.bgid = kBufferGroup;
+    if (ioUringRegister(ringFd_, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+    {
+        LOG_SYSERR << "IoUringPoller::setupBufferRing - IORING_REGISTER_PBUF_RING";
+        ::munmap(bufferMem_, bufferMemSize_);
+        bufferMem_ = MAP_FAILED;
+        return false;
+    }
+    bufferRing_ = static_cast<struct io_uring_buf*>(bufferMem_);
+    buffers_ = static_cast<char*>(bufferMem_) + ringSize;
+    for (unsigned i = 0; i < kBufferCount; ++i)
+    {
+        usedBuffers_.push_back(static_cast<uint16_t>(i));
+    }
+    provideBuffers();
+    return true;
+}
+
+void IoUringPoller::closeRing()
+{
+    if (sqes_)
+    {
+        ::munmap(sqes_, sqesSize_);
+        sqes_ = NULL;
+    }
+    if (cqRing_ != MAP_FAILED && cqRing_ != sqRing_)
+    {
+        ::munmap(cqRing_, cqRingSize_);
+    }
+    cqRing_ = MAP_FAILED;
+    if (sqRing_ != MAP_FAILED)
+    {
+        ::munmap(sqRing_, sqRingSize_);
+        sqRing_ = MAP_FAILED;
+    }
+    if (ringFd_ >= 0)
+    {
+        ::close(ringFd_);
+        ringFd_ = -1;
+    }
+    if (bufferMem_ != MAP_FAILED)   // 关闭ring之后, 内核不再写入缓冲区
+    {
+        ::munmap(bufferMem_, bufferMemSize_);
+        bufferMem_ = MAP_FAILED;
+        bufferRing_ = NULL;
+    }
+}
+
+Timestamp IoUringPoller::poll(int timeoutMs, ChannelList* activeChannels)
+{
+    // 上一轮的事件已处理完毕, 数据已从缓冲区复制走
+    provideBuffers();
+    // 上一轮触发的通道仍然关注事件的重新提交POLL_ADD, 结束了的RECV/ACCEPT也重新提交
+    // 还有数据没读完的fd会立即再次完成, 与水平触发一致
+    for (size_t i = 0; i < rearmFds_.size(); ++i)
+    {
+        Channel* channel = findChannel(rearmFds_[i]);
+        if (channel && channel->index() == kAdded)
+        {
+            armChannel(channel);
+        }
+    }
+    rearmFds_.clear();
+
+    submitAndWait(timeoutMs);
+    Timestamp now(pollReturnTime());
+    size_t oldSize = activeChannels->size();
+    fillActiveChannels(activeChannels);
+    if (activeChannels->size() > oldSize)
+    {
+        LOG_TRACE << activeChannels->size() - oldSize << " events happended";
+    }
+    else
+    {
+        LOG_TRACE << " nothing happended";
+    }
+    return now;
+}
+
+// 一次io_uring_enter提交本轮所有的注册/取消请求并等待完成事件
+void IoUringPoller::submitAndWait(int timeoutMs)
+{
+    struct __kernel_timespec ts;
+    struct io_uring_getevents_arg arg;
+    bzero(&arg, sizeof arg);
+    if (timeoutMs >= 0)
+    {
+        ts.tv_sec = timeoutMs / 1000;
+        ts.tv_nsec = static_cast<long long>(timeoutMs % 1000) * 1000 * 1000;
+        arg.ts = reinterpret_cast<uint64_t>(&ts);
+    }
+    unsigned toSubmit = *sqTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+    unsigned minComplete = timeoutMs == 0 ? 0 : 1;
+    int ret = ioUringEnter(ringFd_, toSubmit, minComplete,
+                           IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof arg);
+    if (ret < 0 && errno != ETIME && errno != EINTR)
+    {
+        LOG_SYSERR << "IoUringPoller::poll()";
+    }
+}
+
+void IoUringPoller::fillActiveChannels(ChannelList* activeChannels)
+{
+    ++round_;
+    unsigned head = *cqHead_;
+    unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head)
+    {
+        const struct io_uring_cqe& cqe = cqes_[head & cqMask_];
+        if (cqe.user_data == kCancelUserData)
+        {
+            continue;
+        }
+        int fd = static_cast<int>(cqe.user_data >> 32);
+        Op op = static_cast<Op>((cqe.user_data >> 30) & 3);
+        uint32_t generation = static_cast<uint32_t>(cqe.user_data) & kGenerationMask;
+        const char* data = NULL;
+        if (cqe.flags & IORING_CQE_F_BUFFER)    // 不论请求是否过期, 用掉的缓冲区都要归还
+        {
+            uint16_t bid = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+            data = buffers_ + implicit_cast<size_t>(bid) * kBufferSize;
+            usedBuffers_.push_back(bid);
+        }
+        bool known = implicit_cast<size_t>(fd) < states_.size();
+        if (op == kPollOp)
+        {
+            // 通道已经更新或移除, 这是被取消的旧请求
+            if (!known || (states_[fd].generation & kGenerationMask) != generation)
+            {
+                continue;
+            }
+            states_[fd].armed = false;
+            Channel* channel = findChannel(fd);
+            assert(channel != NULL);
+            if (cqe.res < 0)
+            {
+                // 请求本身失败, 按POLLERR交给通道处理, 并照常重新提交, 与poll(2)反复报告错误一致
+                errno = -cqe.res;
+                LOG_SYSERR << "IoUringPoller poll fd=" << fd;
+                addActiveChannel(channel, POLLERR, activeChannels);
+            }
+            else
+            {
+                addActiveChannel(channel, cqe.res, activeChannels);
+            }
+            rearmFds_.push_back(fd);
+        }
+        else
+        {
+            if (!known || (states_[fd].ioGeneration & kGenerationMask) != generation)
+            {
+                if (op == kAcceptOp && cqe.res >= 0)
+                {
+                    ::close(cqe.res);       // 取消之前已经接受的连接
+                }
+                continue;
+            }
+            Channel* channel = findChannel(fd);
+            assert(channel != NULL);
+            if (!(cqe.flags & IORING_CQE_F_MORE))   // multishot请求已结束(EOF, 出错或缓冲区用完)
+            {
+                states_[fd].ioArmed = false;
+                rearmFds_.push_back(fd);
+            }
+            if (cqe.res != -ENOBUFS)                // 缓冲区用完时数据仍在socket中, 下一轮归还缓冲区后重新提交
+            {
+                channel->addCompletion(cqe.res, data);
+                addActiveChannel(channel, POLLIN, activeChannels);
+            }
+        }
+    }
+    __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+}
+
+// 同一轮中一个通道可能有多个完成事件, 只加入activeChannels一次, 事件合并
+void IoUringPoller::addActiveChannel(Channel* channel, int revents, ChannelList* activeChannels)
+{
+    PollState& state = states_[channel->fd()];
+    if (state.round != round_)
+    {
+        state.round = round_;
+        state.revents = 0;
+        activeChannels->push_back(channel);
+    }
+    state.revents |= revents;
+    channel->set_revents(state.revents);
+}
+
+// 把上一轮交给通道的缓冲区放回buffer ring
+void IoUringPoller::provideBuffers()
+{
+    if (usedBuffers_.empty())
+    {
+        return;
+    }
+    for (size_t i = 0; i < usedBuffers_.size(); ++i)
+    {
+        uint16_t bid = usedBuffers_[i];
+        // bufferRing_[0].resv与ring的tail重叠, 只写其它字段
+        struct io_uring_buf* buf = &bufferRing_[bufferTail_ & (kBufferCount - 1)];
+        buf->addr = reinterpret_cast<uint64_t>(buffers_ + implicit_cast<size_t>(bid) * kBufferSize);
+        buf->len = kBufferSize;
+        buf->bid = bid;
+        ++bufferTail_;
+    }
+    usedBuffers_.clear();
+    uint16_t* ringTail = reinterpret_cast<uint16_t*>(
+        reinterpret_cast<char*>(bufferRing_) + offsetof(struct io_uring_buf, resv));
+    __atomic_store_n(ringTail, bufferTail_, __ATOMIC_RELEASE);
+}
+
+// SQ已满时先提交已有请求, 不等待
+struct io_uring_sqe* IoUringPoller::getSqe()
+{
+    unsigned tail = *sqTail_;
+    if (tail - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) == sqEntries_)
+    {
+        if (ioUringEnter(ringFd_, sqEntries_, 0, 0, NULL, 0) < 0)
+        {
+            LOG_SYSFATAL << "IoUringPoller::getSqe - io_uring_enter";
+        }
+    }
+    unsigned index = tail & sqMask_;
+    struct io_uring_sqe* sqe = &sqes_[index];
+    bzero(sqe, sizeof *sqe);
+    sqArray_[index] = index;
+    __atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);     // 下一次io_uring_enter才提交, 内核此前不会读取
+    return sqe;
+}
+
+// 按通道当前关注的事件提交或取消请求, 已提交且没有变化的不动
+// 完成模式下读由RECV/ACCEPT负责, POLL_ADD只关注其余事件
+void IoUringPoller::armChannel(Channel* channel)
+{
+    int fd = channel->fd();
+    if (implicit_cast<size_t>(fd) >= states_.size())
+    {
+        PollState empty = { 0, 0, false, 0, false, 0, 0 };
+        states_.resize(std::max(implicit_cast<size_t>(fd) + 1, 2 * states_.size()), empty);
+    }
+    bool completion = channel->completion() != Channel::kNoCompletion;
+    int events = completion ? channel->events() & ~(POLLIN | POLLPRI) : channel->events();
+    if (states_[fd].armed && states_[fd].events != events)
+    {
+        cancelPoll(fd);
+    }
+    if (!states_[fd].armed && events != 0)
+    {
+        submitPoll(fd, events);
+    }
+    bool io = completion && (channel->events() & POLLIN);
+    if (states_[fd].ioArmed && !io)
+    {
+        cancelIo(channel);
+    }
+    if (!states_[fd].ioArmed && io)
+    {
+        submitIo(channel);
+    }
+}
+
+void IoUringPoller::submitPoll(int fd, int events)
+{
+    PollState& state = states_[fd];
+    assert(!state.armed);
+    ++state.generation;
+    state.events = events;
+    state.armed = true;
+
+    struct io_uring_sqe* sqe = getSqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = static_cast<uint32_t>(events);
+    sqe->user_data = makeUserData(fd, kPollOp, state.generation);
+}
+
+// multishot请求, 每接受一个连接或读到一块数据产生一个完成事件
+void IoUringPoller::submitIo(Channel* channel)
+{
+    int fd = channel->fd();
+    PollState& state = states_[fd];
+    assert(!state.ioArmed);
+    ++state.ioGeneration;
+    state.ioArmed = true;
+
+    struct io_uring_sqe* sqe = getSqe();
+    sqe->fd = fd;
+    if (ioOp(channel) == kAcceptOp)
+    {
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+        sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    }
+    else
+    {
+        sqe->opcode = IORING_OP_RECV;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = kBufferGroup;
+    }
+    sqe->user_data = makeUserData(fd, ioOp(channel), state.ioGeneration);
+}
+
+void IoUringPoller::cancelPoll(int fd)
+{
+    PollState& state = states_[fd];
+    if (state.armed)
+    {
+        struct io_uring_sqe* sqe = getSqe();
+        sqe->opcode = IORING_OP_POLL_REMOVE;
+        sqe->fd = -1;
+        sqe->addr = makeUserData(fd, kPollOp, state.generation);
+        sqe->user_data = kCancelUserData;
+        state.armed = false;
+    }
+    ++state.generation;     // 已在完成队列中的旧事件也一并作废
+}
+
+void IoUringPoller::cancelIo(Channel* channel)
+{
+    int fd = channel->fd();
+    PollState& state = states_[fd];
+    if (state.ioArmed)
+    {
+        struct io_uring_sqe* sqe = getSqe();
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->addr = makeUserData(fd, ioOp(channel), state.ioGeneration);
+        sqe->user_data = kCancelUserData;
+        state.ioArmed = false;
+    }
+    ++state.ioGeneration;
+}
+
+void IoUringPoller::updateChannel(Channel* channel)
+{
+    Poller::assertInLoopThread();
+    LOG_TRACE << "fd = " << channel->fd() << " events = " << channel->events();
+    const int index = channel->index();
+    int fd = channel->fd();
+    if (index == kNew || index == kDeleted)
+    {
+        if (index == kNew)
+        {
+            addChannel(fd, channel);
+        }
+        else
+        {
+            assert(findChannel(fd) == channel);
+        }
+        channel->set_index(kAdded);
+        armChannel(channel);
+    }
+    else
+    {
+        assert(findChannel(fd) == channel);
+        assert(index == kAdded);
+        if (channel->isNoneEvent())
+        {
+            cancelPoll(fd);
+            cancelIo(channel);
+            channel->set_index(kDeleted);
+        }
+        else
+        {
+            armChannel(channel);    // 关注的事件变了, 取消旧请求后按新事件注册
+        }
+    }
+}
+
+void IoUringPoller::removeChannel(Channel* channel)
+{
+    Poller::assertInLoopThread();
+    int fd = channel->fd();
+    LOG_TRACE << "fd = " << fd;
+    assert(findChannel(fd) == channel);
+    assert(channel->isNoneEvent());
+    int index = channel->index();
+    assert(index == kAdded || index == kDeleted);
+    if (index == kAdded)
+    {
+        cancelPoll(fd);
+        cancelIo(channel);
+    }
+    eraseChannel(fd);
+    channel->set_index(kNew);
+}
\ No newline at end of file
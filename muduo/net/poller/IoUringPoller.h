@@ -0,0 +1,111 @@
+﻿#ifndef MUDUO_NET_POLLER_IOURINGPOLLER_H
+#define MUDUO_NET_POLLER_IOURINGPOLLER_H
+
+#include <muduo/net/Poller.h>
+
+#include <vector>
+
+#include <stdint.h>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct io_uring_buf;
+
+namespace muduo
+{
+
+namespace net
+{
+
+///
+/// IO Multiplexing with io_uring(7).
+///
+/// Every channel has one one-shot IORING_OP_POLL_ADD in flight, re-armed
+/// after it fires, which keeps the level-triggered semantics of poll(2).
+/// Registrations, re-arms and cancellations are queued as SQEs and go to
+/// the kernel together with the wait in a single io_uring_enter(2).
+///
+/// Channels with Channel::setCompletion get a multishot IORING_OP_RECV
+/// reading into a provided buffer ring, or a multishot IORING_OP_ACCEPT,
+/// instead of polling for POLLIN (5.19+). Writes still go through POLLOUT
+/// and writev/sendfile.
+class IoUringPoller : public Poller
+{
+public:
+    IoUringPoller(EventLoop* loop);
+    virtual ~IoUringPoller();
+
+    /// false if the kernel has no io_uring or lacks IORING_FEAT_EXT_ARG (5.11)
+    bool valid() const { return ringFd_ >= 0; }
+
+    virtual Timestamp poll(int timeoutMs, ChannelList* activeChannels); // activeChannels传出参数, 返回触发的Channel数组
+    virtual void updateChannel(Channel* channel);                       // 更新对应Channel的事件, 包括注册Channel
+    virtual void removeChannel(Channel* channel);                       // 从Poller中移除对应的Channel
+    virtual bool supportsCompletion() const { return bufferRing_ != NULL; }
+
+private:
+    static const unsigned kRingEntries = 4096;      // SQ大小, CQ为其两倍
+    static const unsigned kBufferCount = 256;       // provided buffer的个数, 2的幂
+    static const unsigned kBufferSize = 16 * 1024;
+
+    struct PollState
+    {
+        uint32_t generation;    // 每次提交POLL_ADD加一, 编入user_data, 用于丢弃过期的完成事件
+        int      events;        // 提交时关注的事件
+        bool     armed;         // 内核中有未完成的POLL_ADD
+        uint32_t ioGeneration;  // 同generation, 对应multishot RECV/ACCEPT
+        bool     ioArmed;       // 内核中有未结束的RECV/ACCEPT
+        uint32_t round;         // revents所属的轮次
+        int      revents;       // 本轮已报告给通道的事件
+    };
+
+    bool setupRing();
+    bool setupBufferRing();
+    void closeRing();
+    io_uring_sqe* getSqe();
+    void armChannel(Channel* channel);
+    void submitPoll(int fd, int events);
+    void submitIo(Channel* channel);
+    void cancelPoll(int fd);
+    void cancelIo(Channel* channel);
+    void provideBuffers();
+    void submitAndWait(int timeoutMs);
+    void fillActiveChannels(ChannelList* activeChannels);
+    void addActiveChannel(Channel* channel, int revents, ChannelList* activeChannels);
+
+    int ringFd_;
+    // mmap映射的提交队列与完成队列
+    void*    sqRing_;
+    size_t   sqRingSize_;
+    void*    cqRing_;
+    size_t   cqRingSize_;
+    io_uring_sqe* sqes_;
+    size_t   sqesSize_;
+    unsigned *sqHead_;
+    unsigned *sqTail_;
+    unsigned *sqArray_;
+    unsigned sqMask_;
+    unsigned sqEntries_;
+    unsigned *cqHead_;
+    unsigned *cqTail_;
+    unsigned cqMask_;
+    io_uring_cqe* cqes_;
+
+    // provided buffer ring, 与缓冲区在同一块映射中
+    void*    bufferMem_;
+    size_t   bufferMemSize_;
+    io_uring_buf* bufferRing_;
+    char*    buffers_;
+    uint16_t bufferTail_;
+
+    std::vector<PollState> states_; // 以fd为下标
+    std::vector<int> rearmFds_;     // 上一轮触发或结束的fd, 下一次poll时重新提交
+    std::vector<uint16_t> usedBuffers_; // 上一轮交给通道的缓冲区, 下一次poll时归还内核
+    uint32_t round_;                // poll的轮次
+};
+
+}       // namespace net
+
+}       // namespace muduo
+
+#endif  // MUDUO_NET_POLLER_IOURINGPOLLER_H
\ No newline at end of file
@@ -23,7 +23,7 @@ Timestamp PollPoller::poll(int timeoutMs, ChannelList* activeChannels)  // activ
 {
     // XXX pollfds_ shouldn't change
     int numEvents = ::poll(&*pollfds_.begin(), pollfds_.size(), timeoutMs);
-    Timestamp now(Timestamp::now());
+    Timestamp now(pollReturnTime());
     if (numEvents > 0)
     {
         LOG_TRACE << numEvents << " events happended";
@@ -49,9 +49,8 @@ void PollPoller::fillActiveChannels(int numEvents, ChannelList* activeChannels)
         if (pfd->revents > 0)
         {
             --numEvents;
-            ChannelMap::const_iterator ch = channels_.find(pfd->fd);
-            assert(ch != channels_.end());          // 通道必须存在, 否则无法查找通道里的文件描述符
-            Channel* channel = ch->second;
+            Channel* channel = findChannel(pfd->fd);
+            assert(channel != NULL);                // 通道必须存在, 否则无法查找通道里的文件描述符
             assert(channel->fd() == pfd->fd);       // 断言channel里的fd和pfd里的fd相等
             channel->set_revents(pfd->revents);
             // pfd->revents = 0;
@@ -68,7 +67,7 @@ void PollPoller::updateChannel(Channel* channel)    // 用于注册或者更新
     {
         // index < 0说明是一个新的通道, Channel的index_初始化为-1
         // a new one, add to pollfds_
-        assert(channels_.find(channel->fd()) == channels_.end());   // 断言新通道找不到
+        assert(findChannel(channel->fd()) == NULL);                 // 断言新通道找不到
         struct pollfd pfd;
         pfd.fd = channel->fd();
         pfd.events = static_cast<short>(channel->events());
@@ -76,13 +75,12 @@ void PollPoller::updateChannel(Channel* channel)    // 用于注册或者更新
         pollfds_.push_back(pfd);
         int idx = static_cast<int>(pollfds_.size()) - 1;            // 添加新通道的索引为当前通道数量-1
         channel->set_index(idx);                                    // 更新chennel的索引
-        channels_[pfd.fd] = channel;
+        addChannel(pfd.fd, channel);
     }
     else
     {
         // update existing one
-        assert(channels_.find(channel->fd()) != channels_.end());   // 断言更新的通道已存在
-        assert(channels_[channel->fd()] == channel);                // 以fd为索引的channel为更新的channel
+        assert(findChannel(channel->fd()) == channel);              // 以fd为索引的channel为更新的channel
         int idx = channel->index();
         assert(0 <= idx && idx < static_cast<int>(pollfds_.size()));// 索引大于0, 小于pollfds_的数量
         struct pollfd& pfd = pollfds_[idx];                         // 使用引用不需要拷贝
@@ -104,15 +102,13 @@ void PollPoller::removeChannel(Channel* channel)
 {
     Poller::assertInLoopThread();
     LOG_TRACE << "fd = " << channel->fd();
-    assert(channels_.find(channel->fd()) != channels_.end());
-    assert(channels_[channel->fd()] == channel);
+    assert(findChannel(channel->fd()) == channel);
     assert(channel->isNoneEvent());                             // 先调用update将要删除的channel更新为NoneEvent, 即不关注
     int idx = channel->index();
     assert(0 <= idx && idx < static_cast<int>(pollfds_.size()));
     const struct pollfd& pfd = pollfds_[idx]; (void)pfd;
     assert(pfd.fd == -channel->fd() - 1 && pfd.events == channel->events());
-    size_t n = channels_.erase(channel->fd());                  // 使用key来移除, 返回移除个数; 如果使用迭代器来移除, 返回下一个迭代器
-    assert(n == 1); (void)n;
+    eraseChannel(channel->fd());
     if (implicit_cast<size_t>(idx) == pollfds_.size() - 1)      // 移除最后一个
     {
         pollfds_.pop_back();
@@ -124,7 +120,7 @@ void PollPoller::removeChannel(Channel* channel)
         iter_swap(pollfds_.begin() + idx, pollfds_.end() - 1);    // 交换迭代器所指向的元素
         if (channelAtEnd < 0)
         {
-            channelAtEnd = -channelAtEnd - 1;                     // 最后一个文件描述符要是不关注为负数, 需修改过来到channels_查找key
+            channelAtEnd = -channelAtEnd - 1;                     // 最后一个文件描述符要是不关注为负数, 需修改过来到channels_中查找
         }
         channels_[channelAtEnd]->set_index(idx);                  // 修改交换后的索引
         pollfds_.pop_back();
@@ -3,7 +3,6 @@
 
 #include <muduo/net/Poller.h>
 
-#include <map>
 #include <vector>
 
 struct pollfd;
@@ -33,10 +32,8 @@ private:
     void fillActiveChannels(int numEvents, ChannelList* activeChannels) const;
 
     typedef std::vector<struct pollfd> PollFdList;
-    typedef std::map<int, Channel*> ChannelMap;	    // key是文件描述符，value是Channel*
 
     PollFdList pollfds_;
-    ChannelMap channels_;
 };
 
 }       // namespace net
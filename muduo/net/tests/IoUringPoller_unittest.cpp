@@ -0,0 +1,163 @@
+﻿#include <muduo/net/EventLoop.h>
+#include <muduo/net/TcpClient.h>
+#include <muduo/net/TcpServer.h>
+
+#include <boost/bind.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+
+#include <stdlib.h>
+
+//#define BOOST_TEST_MODULE IoUringPollerTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using muduo::string;
+using muduo::Timestamp;
+using muduo::net::Buffer;
+using muduo::net::EventLoop;
+using muduo::net::InetAddress;
+using muduo::net::TcpClient;
+using muduo::net::TcpConnectionPtr;
+using muduo::net::TcpServer;
+using muduo::net::TcpConnection;
+
+namespace
+{
+
+const uint16_t kPort = 20130;
+const size_t kMessageSize = 1024 * 1024;   // 大于socket缓冲区, 需要多次重新提交POLL_ADD
+
+string g_received;
+
+void onServerMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
+{
+    conn->send(buf);
+}
+
+void onClientConnection(const TcpConnectionPtr& conn)
+{
+    if (conn->connected())
+    {
+        conn->send(string(kMessageSize, 'x'));
+    }
+}
+
+void onClientMessage(EventLoop* loop, const TcpConnectionPtr&, Buffer* buf, Timestamp)
+{
+    g_received += buf->retrieveAllAsString();
+    if (g_received.size() >= kMessageSize)
+    {
+        loop->quit();
+    }
+}
+
+const uint16_t kManyPort = 20132;
+const int kClients = 16;
+const size_t kClientMessageSize = 512 * 1024;   // 合计大于provided buffer ring, 会用完缓冲区
+
+struct ManyClients
+{
+    EventLoop* loop;
+    std::vector<size_t> received;
+    int done;
+    int serverUp;
+    int serverDown;
+
+    void onServerConnection(const TcpConnectionPtr& conn)
+    {
+        if (conn->connected())
+        {
+            ++serverUp;
+        }
+        else if (++serverDown == kClients)  // 服务端读到每个客户端的EOF
+        {
+            loop->quit();
+        }
+    }
+
+    void onClientConnection(const TcpConnectionPtr& conn)
+    {
+        if (conn->connected())
+        {
+            conn->send(string(kClientMessageSize, 'y'));
+        }
+    }
+
+    void onClientMessage(int id, const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
+    {
+        received[id] += buf->readableBytes();
+        buf->retrieveAll();
+        if (received[id] == kClientMessageSize)
+        {
+            conn->shutdown();               // 服务端随后读到EOF
+            if (++done == kClients)
+            {
+                BOOST_CHECK_EQUAL(serverUp, kClients);
+            }
+        }
+    }
+};
+
+}   // namespace
+
+// 内核不支持io_uring时退回epoll, 此时仍应通过
+BOOST_AUTO_TEST_CASE(testEchoRoundTrip)
+{
+    ::setenv("MUDUO_USE_IO_URING", "1", 1);
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress("127.0.0.1", kPort), "IoUringEcho");
+    server.setMessageCallback(onServerMessage);
+    server.start();
+
+    TcpClient client(&loop, InetAddress("127.0.0.1", kPort), "IoUringClient");
+    client.setConnectionCallback(onClientConnection);
+    client.setMessageCallback(boost::bind(onClientMessage, &loop, _1, _2, _3));
+    client.connect();
+
+    loop.runAfter(10.0, boost::bind(&EventLoop::quit, &loop));    // 避免挂死
+    loop.loop();
+    client.disconnect();
+    ::unsetenv("MUDUO_USE_IO_URING");
+
+    BOOST_CHECK_EQUAL(g_received.size(), kMessageSize);
+    BOOST_CHECK(g_received == string(kMessageSize, 'x'));
+}
+
+// 多个连接同时收发: 监听套接字的multishot accept, 以及缓冲区用完后重新提交的RECV
+BOOST_AUTO_TEST_CASE(testManyConnections)
+{
+    ::setenv("MUDUO_USE_IO_URING", "1", 1);
+    EventLoop loop;
+    ManyClients state;
+    state.loop = &loop;
+    state.received.resize(kClients, 0);
+    state.done = 0;
+    state.serverUp = 0;
+    state.serverDown = 0;
+
+    TcpServer server(&loop, InetAddress("127.0.0.1", kManyPort), "IoUringMany");
+    server.setConnectionCallback(boost::bind(&ManyClients::onServerConnection, &state, _1));
+    server.setMessageCallback(onServerMessage);
+    server.start();
+
+    boost::ptr_vector<TcpClient> clients;
+    for (int i = 0; i < kClients; ++i)
+    {
+        clients.push_back(new TcpClient(&loop, InetAddress("127.0.0.1", kManyPort), "IoUringClient"));
+        clients.back().setConnectionCallback(boost::bind(&ManyClients::onClientConnection, &state, _1));
+        clients.back().setMessageCallback(boost::bind(&ManyClients::onClientMessage, &state, i, _1, _2, _3));
+        clients.back().connect();
+    }
+
+    loop.runAfter(20.0, boost::bind(&EventLoop::quit, &loop));    // 避免挂死
+    loop.loop();
+    ::unsetenv("MUDUO_USE_IO_URING");
+
+    BOOST_CHECK_EQUAL(state.done, kClients);
+    BOOST_CHECK_EQUAL(state.serverDown, kClients);
+    for (int i = 0; i < kClients; ++i)
+    {
+        BOOST_CHECK_EQUAL(state.received[i], kClientMessageSize);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,220 @@
+﻿#include <muduo/net/OutputQueue.h>
+
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+//#define BOOST_TEST_MODULE OutputQueueTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using muduo::string;
+using muduo::net::OutputQueue;
+
+namespace
+{
+
+// 非阻塞的socketpair, 发送缓冲区尽量小, 以便writev只写出一部分
+struct SocketPair
+{
+    SocketPair()
+    {
+        BOOST_REQUIRE(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) == 0);
+        int size = 4096;
+        ::setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &size, sizeof size);
+        ::setsockopt(fds[1], SOL_SOCKET, SO_RCVBUF, &size, sizeof size);
+    }
+    ~SocketPair()
+    {
+        ::close(fds[0]);
+        ::close(fds[1]);
+    }
+
+    string readAll()
+    {
+        string result;
+        char buf[65536];
+        ssize_t n = 0;
+        while ((n = ::read(fds[1], buf, sizeof buf)) > 0)
+        {
+            result.append(buf, n);
+        }
+        return result;
+    }
+
+    int fds[2];
+};
+
+string pattern(size_t len, char first)
+{
+    string result(len, first);
+    for (size_t i = 0; i < len; ++i)
+    {
+        result[i] = static_cast<char>(first + i % 26);
+    }
+    return result;
+}
+
+}   // namespace
+
+BOOST_AUTO_TEST_CASE(testAppendCoalescesIntoTailChunk)
+{
+    SocketPair pair;
+    OutputQueue queue;
+    string expected;
+    for (int i = 0; i < 100; ++i)
+    {
+        string piece = pattern(10, static_cast<char>('a' + i % 26));
+        queue.append(piece.data(), piece.size());
+        expected += piece;
+    }
+    BOOST_CHECK_EQUAL(queue.readableBytes(), 1000u);
+
+    // 每次writev最多kMaxIovecs片, 合并成一片时一次就写完
+    int savedErrno = 0;
+    OutputQueue::CompletedFileList completed;
+    ssize_t n = queue.writeFd(pair.fds[0], &savedErrno, &completed, 1);
+    BOOST_CHECK_EQUAL(n, 1000);
+    BOOST_CHECK(queue.empty());
+    BOOST_CHECK_EQUAL(queue.readableBytes(), 0u);
+    BOOST_CHECK(pair.readAll() == expected);
+}
+
+BOOST_AUTO_TEST_CASE(testPartialWriteAcrossChunks)
+{
+    SocketPair pair;
+    OutputQueue queue;
+    string expected;
+    // 拷贝的小片、跨越kMinChunkSize的大片与不拷贝的片交错
+    boost::shared_ptr<string> owned(new string(pattern(50000, 'A')));
+    for (int i = 0; i < 20; ++i)
+    {
+        string piece = pattern(static_cast<size_t>(100 + i * 997), static_cast<char>('a' + i));
+        queue.append(piece.data(), piece.size());
+        expected += piece;
+        if (i % 5 == 0)
+        {
+            queue.append(owned->data(), owned->size(), owned);
+            expected += *owned;
+        }
+    }
+    BOOST_CHECK_EQUAL(queue.readableBytes(), expected.size());
+
+    string received;
+    int rounds = 0;
+    while (!queue.empty())
+    {
+        int savedErrno = 0;
+        OutputQueue::CompletedFileList completed;
+        ssize_t n = queue.writeFd(pair.fds[0], &savedErrno, &completed);
+        BOOST_REQUIRE(n >= 0 || savedErrno == EAGAIN);
+        BOOST_CHECK(completed.empty());
+        received += pair.readAll();
+        BOOST_CHECK_EQUAL(queue.readableBytes() + received.size(), expected.size());
+        ++rounds;
+    }
+    received += pair.readAll();
+    BOOST_CHECK(rounds > 1);        // 确实发生了部分写
+    BOOST_CHECK(received == expected);
+}
+
+namespace
+{
+
+void onFileComplete(int* calls, const muduo::net::TcpConnectionPtr&, int)
+{
+    ++*calls;
+}
+
+int makeTempFile(const string& content)
+{
+    char name[] = "/tmp/outputqueue_testXXXXXX";
+    int fd = ::mkstemp(name);
+    BOOST_REQUIRE(fd >= 0);
+    ::unlink(name);
+    BOOST_REQUIRE(::write(fd, content.data(), content.size()) == static_cast<ssize_t>(content.size()));
+    return fd;
+}
+
+}   // namespace
+
+BOOST_AUTO_TEST_CASE(testFileSliceCompletion)
+{
+    SocketPair pair;
+    OutputQueue queue;
+    string content = pattern(100000, 'a');
+    int fd = makeTempFile(content);
+    int calls = 0;
+
+    queue.append("head", 4);
+    queue.appendFile(fd, 10, content.size() - 10,
+                     boost::bind(onFileComplete, &calls, _1, _2));
+    queue.append("tail", 4);
+    string expected = "head" + content.substr(10) + "tail";
+    BOOST_CHECK_EQUAL(queue.readableBytes(), expected.size());
+
+    string received;
+    OutputQueue::CompletedFileList completed;
+    while (!queue.empty())
+    {
+        int savedErrno = 0;
+        queue.writeFd(pair.fds[0], &savedErrno, &completed);
+        received += pair.readAll();
+    }
+    received += pair.readAll();
+    BOOST_CHECK(received == expected);
+    BOOST_REQUIRE_EQUAL(completed.size(), 1u);
+    BOOST_CHECK_EQUAL(completed[0].fd, fd);
+    completed[0].callback(muduo::net::TcpConnectionPtr(), completed[0].fd);
+    BOOST_CHECK_EQUAL(calls, 1);
+    ::close(fd);
+}
+
+BOOST_AUTO_TEST_CASE(testClearReturnsPendingFiles)
+{
+    OutputQueue queue;
+    queue.append("data", 4);
+    queue.appendFile(3, 0, 100, muduo::net::SendFileCompleteCallback());
+    queue.appendFile(4, 0, 200, muduo::net::SendFileCompleteCallback());
+
+    OutputQueue::CompletedFileList dropped;
+    queue.clear(&dropped);
+    BOOST_CHECK(queue.empty());
+    BOOST_CHECK_EQUAL(queue.readableBytes(), 0u);
+    BOOST_REQUIRE_EQUAL(dropped.size(), 2u);
+    BOOST_CHECK_EQUAL(dropped[0].fd, 3);
+    BOOST_CHECK_EQUAL(dropped[1].fd, 4);
+}
+
+BOOST_AUTO_TEST_CASE(testFileSliceErrorIsDropped)
+{
+    SocketPair pair;
+    OutputQueue queue;
+    int pipeFds[2];
+    BOOST_REQUIRE(::pipe(pipeFds) == 0);
+    BOOST_REQUIRE(::write(pipeFds[1], "abc", 3) == 3);
+
+    // sendfile的输入不能是管道(带offset时ESPIPE, 否则EINVAL), 文件片应被移除并交回回调, 而不是留在队首
+    queue.append("head", 4);
+    queue.appendFile(pipeFds[0], 0, 3, muduo::net::SendFileCompleteCallback());
+    queue.append("tail", 4);
+
+    int savedErrno = 0;
+    OutputQueue::CompletedFileList completed;
+    ssize_t n = queue.writeFd(pair.fds[0], &savedErrno, &completed);
+    BOOST_CHECK_EQUAL(n, 4);
+    BOOST_CHECK(savedErrno == ESPIPE || savedErrno == EINVAL);
+    BOOST_REQUIRE_EQUAL(completed.size(), 1u);
+    BOOST_CHECK_EQUAL(completed[0].fd, pipeFds[0]);
+    BOOST_CHECK_EQUAL(queue.readableBytes(), 4u);
+    BOOST_CHECK(pair.readAll() == "head");
+    ::close(pipeFds[0]);
+    ::close(pipeFds[1]);
+}
\ No newline at end of file
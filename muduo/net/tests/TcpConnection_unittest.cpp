@@ -0,0 +1,116 @@
+﻿#include <muduo/net/EventLoop.h>
+#include <muduo/net/TcpClient.h>
+#include <muduo/net/TcpServer.h>
+
+#include <boost/bind.hpp>
+
+#include <unistd.h>
+
+//#define BOOST_TEST_MODULE TcpConnectionTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using muduo::string;
+using muduo::Timestamp;
+using muduo::net::Buffer;
+using muduo::net::EventLoop;
+using muduo::net::InetAddress;
+using muduo::net::TcpClient;
+using muduo::net::TcpConnectionPtr;
+using muduo::net::TcpServer;
+
+namespace
+{
+
+const uint16_t kPort = 20131;
+
+// sendFile的输入是管道, sendfile(2)失败(ESPIPE): cb应恰好回调一次, 连接被关闭而不是一直触发POLLOUT
+struct PipeSender
+{
+    PipeSender(size_t prefix)
+        : prefixBytes(prefix),
+        callbacks(0),
+        clientClosed(false)
+    {
+        BOOST_REQUIRE(::pipe(pipeFds) == 0);
+    }
+    ~PipeSender()
+    {
+        ::close(pipeFds[0]);
+        ::close(pipeFds[1]);
+    }
+
+    void onServerConnection(const TcpConnectionPtr& conn)
+    {
+        if (conn->connected())
+        {
+            if (prefixBytes > 0)
+            {
+                // 先排队大量数据, 文件片在handleWrite中才发送
+                conn->send(string(prefixBytes, 'x'));
+            }
+            conn->sendFile(pipeFds[0], 0, 100,
+                           boost::bind(&PipeSender::onFileDone, this, _1, _2));
+        }
+    }
+
+    void onFileDone(const TcpConnectionPtr&, int fd)
+    {
+        BOOST_CHECK_EQUAL(fd, pipeFds[0]);
+        ++callbacks;
+    }
+
+    void onClientConnection(EventLoop* loop, const TcpConnectionPtr& conn)
+    {
+        if (!conn->connected())
+        {
+            clientClosed = true;
+            loop->quit();
+        }
+    }
+
+    size_t prefixBytes;
+    int pipeFds[2];
+    int callbacks;
+    bool clientClosed;
+};
+
+void onClientMessage(const TcpConnectionPtr&, Buffer* buf, Timestamp)
+{
+    buf->retrieveAll();
+}
+
+void runPipeSender(PipeSender* sender)
+{
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress("127.0.0.1", kPort), "PipeSender");
+    server.setConnectionCallback(boost::bind(&PipeSender::onServerConnection, sender, _1));
+    server.start();
+
+    TcpClient client(&loop, InetAddress("127.0.0.1", kPort), "PipeReceiver");
+    client.setConnectionCallback(boost::bind(&PipeSender::onClientConnection, sender, &loop, _1));
+    client.setMessageCallback(onClientMessage);
+    client.connect();
+
+    loop.runAfter(5.0, boost::bind(&EventLoop::quit, &loop));    // 避免挂死
+    loop.loop();
+}
+
+}   // namespace
+
+BOOST_AUTO_TEST_CASE(testSendFileErrorOnEmptyQueue)
+{
+    PipeSender sender(0);
+    runPipeSender(&sender);
+    BOOST_CHECK_EQUAL(sender.callbacks, 1);
+    BOOST_CHECK(sender.clientClosed);
+}
+
+BOOST_AUTO_TEST_CASE(testSendFileErrorInHandleWrite)
+{
+    PipeSender sender(4 * 1024 * 1024);
+    runPipeSender(&sender);
+    BOOST_CHECK_EQUAL(sender.callbacks, 1);
+    BOOST_CHECK(sender.clientClosed);
+}
\ No newline at end of file
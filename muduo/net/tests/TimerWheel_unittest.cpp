@@ -0,0 +1,162 @@
+﻿#include <muduo/net/TimerWheel.h>
+
+#include <boost/ptr_container/ptr_vector.hpp>
+
+#include <algorithm>
+
+#include <stdlib.h>
+
+//#define BOOST_TEST_MODULE TimerWheelTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using muduo::Timestamp;
+using muduo::net::Timer;
+using muduo::net::TimerWheel;
+
+namespace
+{
+
+const int64_t kTick = 1000;     // 1ms一个tick, 单位us
+
+void noop()
+{
+}
+
+Timestamp at(int64_t microSeconds)
+{
+    return Timestamp(microSeconds);
+}
+
+std::vector<Timer*> advanceTo(TimerWheel* wheel, int64_t microSeconds)
+{
+    std::vector<Timer*> expired;
+    wheel->advance(at(microSeconds), &expired);
+    return expired;
+}
+
+}   // namespace
+
+BOOST_AUTO_TEST_CASE(testRoundUpToTick)
+{
+    TimerWheel wheel(at(0), 0.001);
+    Timer timer(noop, at(1500), 0.0);      // 向上取整到第2个tick
+    BOOST_CHECK(wheel.insert(&timer));
+    BOOST_CHECK_EQUAL(wheel.nextExpiration().microSecondsSinceEpoch(), 2 * kTick);
+
+    BOOST_CHECK(advanceTo(&wheel, 1500).empty());
+    BOOST_CHECK(advanceTo(&wheel, 1999).empty());
+    std::vector<Timer*> expired = advanceTo(&wheel, 2000);
+    BOOST_REQUIRE_EQUAL(expired.size(), 1u);
+    BOOST_CHECK(expired[0] == &timer);
+    BOOST_CHECK_EQUAL(wheel.size(), 0u);
+    BOOST_CHECK(!wheel.nextExpiration().valid());
+}
+
+BOOST_AUTO_TEST_CASE(testCascadeFromHighLevel)
+{
+    TimerWheel wheel(at(0), 0.001);
+    // 70000 tick在第2层, 要经过两次级联才落到第0层
+    Timer timer(noop, at(70000 * kTick), 0.0);
+    Timer beyond(noop, at(((1LL << 26) + 5) * kTick), 0.0);    // 超出时间轮范围
+    wheel.insert(&timer);
+    wheel.insert(&beyond);
+
+    // 每次前进1000 tick, 只能在包含70000的那一步到期
+    int64_t now = 0;
+    while (now < 70000 * kTick)
+    {
+        BOOST_CHECK(wheel.nextExpiration().microSecondsSinceEpoch() <= 70000 * kTick);
+        now += 1000 * kTick;
+        std::vector<Timer*> expired = advanceTo(&wheel, std::min(now, 70000 * kTick - 1));
+        BOOST_REQUIRE(expired.empty());
+    }
+    std::vector<Timer*> expired = advanceTo(&wheel, 70000 * kTick);
+    BOOST_REQUIRE_EQUAL(expired.size(), 1u);
+    BOOST_CHECK(expired[0] == &timer);
+
+    BOOST_CHECK(advanceTo(&wheel, ((1LL << 26) + 4) * kTick).empty());
+    expired = advanceTo(&wheel, ((1LL << 26) + 5) * kTick);
+    BOOST_REQUIRE_EQUAL(expired.size(), 1u);
+    BOOST_CHECK(expired[0] == &beyond);
+    BOOST_CHECK_EQUAL(wheel.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(testCancelBeforeCascade)
+{
+    TimerWheel wheel(at(0), 0.001);
+    Timer timer(noop, at(70000 * kTick), 0.0);
+    wheel.insert(&timer);
+    BOOST_CHECK(advanceTo(&wheel, 100 * kTick).empty());
+    wheel.remove(&timer);
+    BOOST_CHECK_EQUAL(wheel.size(), 0u);
+    BOOST_CHECK(advanceTo(&wheel, 80000 * kTick).empty());
+}
+
+BOOST_AUTO_TEST_CASE(testCancelAfterCascade)
+{
+    TimerWheel wheel(at(0), 0.001);
+    Timer timer(noop, at(70000 * kTick), 0.0);
+    Timer other(noop, at(70001 * kTick), 0.0);
+    wheel.insert(&timer);
+    wheel.insert(&other);
+    // 65536和69888两次级联之后, 两个定时器都已在第0层
+    BOOST_CHECK(advanceTo(&wheel, 69900 * kTick).empty());
+    wheel.remove(&timer);
+    std::vector<Timer*> expired = advanceTo(&wheel, 80000 * kTick);
+    BOOST_REQUIRE_EQUAL(expired.size(), 1u);
+    BOOST_CHECK(expired[0] == &other);
+    BOOST_CHECK_EQUAL(wheel.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(testRepeatingTimer)
+{
+    TimerWheel wheel(at(0), 0.001);
+    Timer timer(noop, at(10 * kTick), 0.01);
+    wheel.insert(&timer);
+    // 与TimerQueue::reset相同, 到期后restart再插入
+    for (int i = 1; i <= 300; ++i)
+    {
+        int64_t due = i * 10 * kTick;
+        BOOST_REQUIRE(advanceTo(&wheel, due - 1).empty());
+        std::vector<Timer*> expired = advanceTo(&wheel, due);
+        BOOST_REQUIRE_EQUAL(expired.size(), 1u);
+        timer.restart(at(due));
+        wheel.insert(&timer);
+    }
+    BOOST_CHECK_EQUAL(wheel.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(testNeverEarlyNeverMissed)
+{
+    TimerWheel wheel(at(0), 0.001);
+    boost::ptr_vector<Timer> timers;
+    srand(1);
+    for (int i = 0; i < 2000; ++i)
+    {
+        // 分布在各层, 到期时间不对齐tick
+        int64_t when = static_cast<int64_t>(rand()) % (1LL << 22) * kTick / 16;
+        timers.push_back(new Timer(noop, at(when), 0.0));
+        wheel.insert(&timers.back());
+    }
+
+    size_t fired = 0;
+    int64_t previous = 0;
+    int64_t now = 0;
+    while (wheel.size() > 0)
+    {
+        now += rand() % (5000 * kTick);
+        std::vector<Timer*> expired = advanceTo(&wheel, now);
+        for (size_t i = 0; i < expired.size(); ++i)
+        {
+            int64_t expiration = expired[i]->expiration().microSecondsSinceEpoch();
+            int64_t dueTick = (expiration + kTick - 1) / kTick;
+            BOOST_CHECK(expiration <= now);                 // 不早于到期时间
+            BOOST_CHECK(previous / kTick < dueTick);        // 上一次前进时还没到期
+        }
+        fired += expired.size();
+        previous = now;
+    }
+    BOOST_CHECK_EQUAL(fired, timers.size());
+}
\ No newline at end of file